@@ -0,0 +1,47 @@
+#version 120
+
+#define SKINNING_MAX_JOINT 64
+
+uniform mat4 camera_projection;
+uniform mat4 camera_modelview;
+uniform mat4 normal_matrix;
+
+//one matrix T*B^{-1} per joint
+uniform mat4 skinning_palette[SKINNING_MAX_JOINT];
+
+//6 (joint,weight) pairs per vertex
+attribute vec3 skinning_joint_0;
+attribute vec3 skinning_joint_1;
+attribute vec3 skinning_weight_0;
+attribute vec3 skinning_weight_1;
+
+varying vec4 position_3d_original;
+varying vec4 position_3d_modelview;
+
+varying vec3 normal;
+varying vec4 color;
+
+
+void main (void)
+{
+    mat4 M = skinning_weight_0.x*skinning_palette[int(skinning_joint_0.x)]
+           + skinning_weight_0.y*skinning_palette[int(skinning_joint_0.y)]
+           + skinning_weight_0.z*skinning_palette[int(skinning_joint_0.z)]
+           + skinning_weight_1.x*skinning_palette[int(skinning_joint_1.x)]
+           + skinning_weight_1.y*skinning_palette[int(skinning_joint_1.y)]
+           + skinning_weight_1.z*skinning_palette[int(skinning_joint_1.z)];
+
+    vec4 p = M*gl_Vertex;
+    vec3 n = mat3(M)*gl_Normal;
+
+    gl_Position = camera_projection*camera_modelview*p;
+
+    position_3d_original = p;
+    position_3d_modelview = camera_modelview*p;
+    color = gl_Color;
+
+    vec4 normal4d = normal_matrix*vec4(normalize(n),0.0);
+    normal = normal4d.xyz;
+
+    gl_TexCoord[0]=gl_MultiTexCoord0;
+}
@@ -0,0 +1,60 @@
+#version 140
+#extension GL_ARB_compatibility : enable
+
+uniform mat4 camera_projection;
+uniform mat4 camera_modelview;
+uniform mat4 normal_matrix;
+
+//palettes of all the instances: 3 texels (rows of the affine matrix model*T*B^{-1}) per joint
+uniform samplerBuffer skinning_palettes;
+uniform int skinning_joint_count;
+
+//6 (joint,weight) pairs per vertex
+attribute vec3 skinning_joint_0;
+attribute vec3 skinning_joint_1;
+attribute vec3 skinning_weight_0;
+attribute vec3 skinning_weight_1;
+
+varying vec4 position_3d_original;
+varying vec4 position_3d_modelview;
+
+varying vec3 normal;
+varying vec4 color;
+
+//accumulate the rows of the weighted matrix of a joint
+void blend(int offset,float joint,float weight,inout vec4 r0,inout vec4 r1,inout vec4 r2)
+{
+    int index = offset+3*int(joint);
+    r0 += weight*texelFetch(skinning_palettes,index+0);
+    r1 += weight*texelFetch(skinning_palettes,index+1);
+    r2 += weight*texelFetch(skinning_palettes,index+2);
+}
+
+void main (void)
+{
+    int offset = 3*skinning_joint_count*gl_InstanceID;
+
+    vec4 r0 = vec4(0.0);
+    vec4 r1 = vec4(0.0);
+    vec4 r2 = vec4(0.0);
+    blend(offset,skinning_joint_0.x,skinning_weight_0.x,r0,r1,r2);
+    blend(offset,skinning_joint_0.y,skinning_weight_0.y,r0,r1,r2);
+    blend(offset,skinning_joint_0.z,skinning_weight_0.z,r0,r1,r2);
+    blend(offset,skinning_joint_1.x,skinning_weight_1.x,r0,r1,r2);
+    blend(offset,skinning_joint_1.y,skinning_weight_1.y,r0,r1,r2);
+    blend(offset,skinning_joint_1.z,skinning_weight_1.z,r0,r1,r2);
+
+    vec4 p = vec4(dot(r0,gl_Vertex),dot(r1,gl_Vertex),dot(r2,gl_Vertex),1.0);
+    vec3 n = vec3(dot(r0.xyz,gl_Normal),dot(r1.xyz,gl_Normal),dot(r2.xyz,gl_Normal));
+
+    gl_Position = camera_projection*camera_modelview*p;
+
+    position_3d_original = p;
+    position_3d_modelview = camera_modelview*p;
+    color = gl_Color;
+
+    vec4 normal4d = normal_matrix*vec4(normalize(n),0.0);
+    normal = normal4d.xyz;
+
+    gl_TexCoord[0]=gl_MultiTexCoord0;
+}
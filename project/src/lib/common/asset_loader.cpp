@@ -0,0 +1,159 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "asset_loader.hpp"
+
+#include "error_handling.hpp"
+
+namespace cpe
+{
+
+static double elapsed_seconds(std::chrono::steady_clock::time_point const& t0,std::chrono::steady_clock::time_point const& t1)
+{
+    return std::chrono::duration<double>(t1-t0).count();
+}
+
+asset_loader::asset_loader()
+    :tasks(),N_loaded(0),N_parsed(0),error(),timing_data(),time_start(),time_end()
+{}
+
+asset_loader::~asset_loader()
+{
+    //the workers write in the parsed assets and in N_parsed: they must end before
+    for(asset_loader_task& task : tasks)
+        if(task.parsing.valid())
+            task.parsing.wait();
+}
+
+void asset_loader::add(std::string const& name,std::function<void()> const& parse,std::function<void()> const& upload)
+{
+    ASSERT_CPE(parse!=nullptr,"Asset "+name+" without parsing");
+    if(tasks.size()==0)
+        time_start = std::chrono::steady_clock::now();
+
+    std::atomic<int>& counter = N_parsed;
+    asset_loader_task task;
+    task.name = name;
+    task.upload = upload;
+    task.parsing = std::async(std::launch::async,[parse,&counter]()
+    {
+        std::chrono::steady_clock::time_point const t0 = std::chrono::steady_clock::now();
+        try
+        {
+            parse();
+        }
+        catch(...)
+        {
+            //the exception is kept by the future, the parsing is over anyway
+            ++counter;
+            throw;
+        }
+        ++counter;
+        return elapsed_seconds(t0,std::chrono::steady_clock::now());
+    });
+    tasks.push_back(std::move(task));
+}
+
+bool asset_loader::upload_next(bool const wait_parsing)
+{
+    if(finished() || failed())
+        return false;
+
+    asset_loader_task& task = tasks[N_loaded];
+    if(!wait_parsing && task.parsing.wait_for(std::chrono::seconds(0))!=std::future_status::ready)
+        return false;
+
+    //the future is consumed by get: a failure is recorded so that it is not read again
+    double time_parse = 0.0;
+    std::chrono::steady_clock::time_point t0,t1;
+    try
+    {
+        time_parse = task.parsing.get();
+        t0 = std::chrono::steady_clock::now();
+        if(task.upload!=nullptr)
+            task.upload();
+        t1 = std::chrono::steady_clock::now();
+    }
+    catch(...)
+    {
+        error = std::current_exception();
+        throw;
+    }
+
+    timing_data.push_back({task.name,time_parse,elapsed_seconds(t0,t1),elapsed_seconds(time_start,t1)});
+    task.upload = nullptr;
+    ++N_loaded;
+    if(finished())
+        time_end = t1;
+
+    return true;
+}
+
+bool asset_loader::update()
+{
+    while(upload_next(false)) {}
+    return finished();
+}
+
+void asset_loader::wait()
+{
+    while(upload_next(true)) {}
+}
+
+int asset_loader::size() const
+{
+    return tasks.size();
+}
+
+int asset_loader::size_loaded() const
+{
+    return N_loaded;
+}
+
+bool asset_loader::finished() const
+{
+    return N_loaded==size();
+}
+
+bool asset_loader::failed() const
+{
+    return error!=nullptr;
+}
+
+float asset_loader::progress() const
+{
+    if(size()==0)
+        return 1.0f;
+    return static_cast<float>(N_parsed.load()+N_loaded)/(2*size());
+}
+
+std::vector<asset_load_timing> const& asset_loader::timings() const
+{
+    return timing_data;
+}
+
+double asset_loader::time_total() const
+{
+    if(size()==0)
+        return 0.0;
+    if(finished())
+        return elapsed_seconds(time_start,time_end);
+    return elapsed_seconds(time_start,std::chrono::steady_clock::now());
+}
+
+}
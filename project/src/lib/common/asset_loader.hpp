@@ -0,0 +1,114 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef ASSET_LOADER_HPP
+#define ASSET_LOADER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace cpe
+{
+
+/** Timings of an asset loaded by asset_loader (in seconds) */
+struct asset_load_timing
+{
+    std::string name;   // name given to asset_loader::add
+    double time_parse;  // parsing in the worker thread
+    double time_upload; // upload in the calling thread
+    double time_ready;  // since the first asset was added, until its upload is done
+};
+
+/** Load assets in two steps: the parsing (files, CPU processing) runs on worker threads,
+ *   and the upload (OpenGL buffers, textures) runs in the thread calling update, once the parsing is finished.
+ *  The uploads are called in the order of addition: an upload can use the result of the previous assets.
+ *  \note An exception thrown by a parsing (or an upload) is thrown again by update (or wait) in the calling thread.
+ *   The loading then stops: the next assets are not uploaded, and the next calls do nothing (see failed).
+*/
+class asset_loader
+{
+public:
+
+    asset_loader();
+    /** Wait for the parsings still running (their results are not uploaded) */
+    ~asset_loader();
+
+    asset_loader(asset_loader const&) = delete;
+    asset_loader& operator=(asset_loader const&) = delete;
+
+    /** Start the parsing of an asset in a worker thread. The upload is optional (empty function). */
+    void add(std::string const& name,std::function<void()> const& parse,std::function<void()> const& upload);
+
+    /** Upload the assets whose parsing is finished, without blocking.
+     *  Returns true when all the assets are loaded. */
+    bool update();
+    /** Block until all the assets are parsed and uploaded */
+    void wait();
+
+    /** Number of assets */
+    int size() const;
+    /** Number of assets parsed and uploaded */
+    int size_loaded() const;
+    /** True when all the assets are parsed and uploaded */
+    bool finished() const;
+    /** True if the parsing or the upload of an asset failed: the loading is stopped */
+    bool failed() const;
+    /** Fraction of the steps done (parsing and upload of each asset), between 0 and 1 */
+    float progress() const;
+
+    /** Timings of the loaded assets, in the order of addition */
+    std::vector<asset_load_timing> const& timings() const;
+    /** Time (in seconds) from the first addition until the last upload, or until now when loading */
+    double time_total() const;
+
+private:
+
+    /** Asset waiting for its parsing or its upload */
+    struct asset_loader_task
+    {
+        std::string name;
+        std::function<void()> upload;
+        std::future<double> parsing; // gives the parsing time
+    };
+
+    /** Upload the next asset, blocks until it is parsed if wait_parsing is set. Returns false if nothing was uploaded. */
+    bool upload_next(bool wait_parsing);
+
+    std::vector<asset_loader_task> tasks;
+    /** Number of uploaded assets (the next one to upload) */
+    int N_loaded;
+    /** Number of finished parsings, incremented by the worker threads */
+    std::atomic<int> N_parsed;
+    /** Exception of the asset that failed (null if none) */
+    std::exception_ptr error;
+    std::vector<asset_load_timing> timing_data;
+
+    std::chrono::steady_clock::time_point time_start;
+    std::chrono::steady_clock::time_point time_end;
+};
+
+}
+
+#endif
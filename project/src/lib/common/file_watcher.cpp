@@ -0,0 +1,190 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "file_watcher.hpp"
+
+#include "error_handling.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace cpe
+{
+
+/** Delay (in ms) during which the events following a first one are gathered:
+ *  saving a file may generate several events (truncation, writes, rename) */
+static int const file_watcher_gather_delay = 50;
+
+file_watcher::file_watcher()
+    :inotify_fd(-1),stop_fd(-1),worker(),mutex(),directories(),files()
+{
+    inotify_fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+    if(inotify_fd<0)
+        throw exception_cpe(std::string("Cannot initialize inotify: ")+std::strerror(errno),EXCEPTION_PARAMETERS_CPE);
+
+    stop_fd = eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if(stop_fd<0)
+    {
+        close(inotify_fd);
+        throw exception_cpe(std::string("Cannot create eventfd: ")+std::strerror(errno),EXCEPTION_PARAMETERS_CPE);
+    }
+}
+
+file_watcher::~file_watcher()
+{
+    stop();
+    close(stop_fd);
+    close(inotify_fd);
+}
+
+void file_watcher::watch(std::string const& filename,std::function<void(std::string const& filename)> const& on_change)
+{
+    ASSERT_CPE(on_change!=nullptr,"No function to call for "+filename);
+
+    std::size_t const separator = filename.find_last_of('/');
+    std::string const directory = separator==std::string::npos? "." : filename.substr(0,separator+1);
+    std::string const name = separator==std::string::npos? filename : filename.substr(separator+1);
+
+    std::lock_guard<std::mutex> const lock(mutex);
+
+    std::map<std::string,int>::const_iterator const it = directories.find(directory);
+    int wd = 0;
+    if(it!=directories.end())
+        wd = it->second;
+    else
+    {
+        wd = inotify_add_watch(inotify_fd,directory.c_str(),IN_CLOSE_WRITE|IN_MOVED_TO);
+        if(wd<0)
+            throw exception_cpe("Cannot watch directory "+directory+": "+std::strerror(errno),EXCEPTION_PARAMETERS_CPE);
+        directories[directory] = wd;
+    }
+
+    files.push_back({wd,name,filename,on_change});
+}
+
+void file_watcher::start()
+{
+    if(running())
+        return;
+    worker = std::thread(&file_watcher::run,this);
+}
+
+void file_watcher::stop()
+{
+    if(!running())
+        return;
+
+    uint64_t const one = 1;
+    if(write(stop_fd,&one,sizeof(one))!=sizeof(one))
+        std::cerr<<"Cannot stop the file watcher: "<<std::strerror(errno)<<std::endl;
+    worker.join();
+
+    //reset the event for a next start
+    uint64_t value = 0;
+    if(read(stop_fd,&value,sizeof(value))<0 && errno!=EAGAIN)
+        std::cerr<<"Cannot reset the file watcher: "<<std::strerror(errno)<<std::endl;
+}
+
+bool file_watcher::running() const
+{
+    return worker.joinable();
+}
+
+void file_watcher::read_events(std::vector<int>& modified)
+{
+    //buffer aligned for the events structures
+    alignas(inotify_event) char buffer[4096];
+    while(true)
+    {
+        ssize_t const length = read(inotify_fd,buffer,sizeof(buffer));
+        if(length<=0)
+            return;
+
+        std::lock_guard<std::mutex> const lock(mutex);
+        for(char const* p=buffer ; p<buffer+length ; )
+        {
+            inotify_event const* event = reinterpret_cast<inotify_event const*>(p);
+            p += sizeof(inotify_event)+event->len;
+            if(event->len==0)
+                continue;
+
+            int const N_file = files.size();
+            for(int k=0 ; k<N_file ; ++k)
+                if(files[k].directory==event->wd && files[k].name==event->name)
+                    if(std::find(modified.begin(),modified.end(),k)==modified.end())
+                        modified.push_back(k);
+        }
+    }
+}
+
+void file_watcher::run()
+{
+    pollfd fds[2] = {{inotify_fd,POLLIN,0},{stop_fd,POLLIN,0}};
+    while(true)
+    {
+        if(poll(fds,2,-1)<0)
+        {
+            if(errno==EINTR)
+                continue;
+            std::cerr<<"File watcher stopped: "<<std::strerror(errno)<<std::endl;
+            return;
+        }
+        if(fds[1].revents!=0)
+            return;
+
+        //gather the events until the files are quiet
+        std::vector<int> modified;
+        do
+        {
+            read_events(modified);
+        } while(poll(fds,1,file_watcher_gather_delay)>0);
+
+        for(int const k : modified)
+        {
+            std::string filename;
+            std::function<void(std::string const&)> on_change;
+            {
+                std::lock_guard<std::mutex> const lock(mutex);
+                filename = files[k].filename;
+                on_change = files[k].on_change;
+            }
+
+            try
+            {
+                on_change(filename);
+            }
+            catch(exception_cpe const& e)
+            {
+                std::cerr<<"Cannot process the modification of "<<filename<<": "<<e.info()<<std::endl;
+            }
+            catch(std::exception const& e)
+            {
+                std::cerr<<"Cannot process the modification of "<<filename<<": "<<e.what()<<std::endl;
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace cpe
+{
+
+/** Watch files with inotify and call a function in a background thread each time one of them is modified.
+ *  The directories of the files are watched (and not the files themselves): a file replaced by an editor
+ *   (written in a temporary file, then renamed) is detected as well.
+ *  The events received within a short delay are gathered: each modified file is notified once.
+ *  \note The functions are called in the watcher thread, an exception thrown by a function is printed and ignored.
+*/
+class file_watcher
+{
+public:
+
+    file_watcher();
+    /** Stop the watcher thread */
+    ~file_watcher();
+
+    file_watcher(file_watcher const&) = delete;
+    file_watcher& operator=(file_watcher const&) = delete;
+
+    /** Call on_change(filename) each time the file is written. Can be called while the watcher is running. */
+    void watch(std::string const& filename,std::function<void(std::string const& filename)> const& on_change);
+
+    /** Start the watcher thread */
+    void start();
+    /** Stop the watcher thread (the pending notification is finished first) */
+    void stop();
+    /** True if the watcher thread is running */
+    bool running() const;
+
+private:
+
+    /** File watched and its function */
+    struct file_watcher_entry
+    {
+        int directory;       // inotify watch descriptor of its directory
+        std::string name;    // name in the directory
+        std::string filename;
+        std::function<void(std::string const&)> on_change;
+    };
+
+    /** Loop of the watcher thread */
+    void run();
+    /** Read the available inotify events and add the index of the modified files */
+    void read_events(std::vector<int>& modified);
+
+    /** inotify instance */
+    int inotify_fd;
+    /** Event used to wake up the watcher thread when it is stopped */
+    int stop_fd;
+    std::thread worker;
+
+    /** Protects the watched files (watch can be called from another thread) */
+    std::mutex mutex;
+    /** Watch descriptor of each watched directory */
+    std::map<std::string,int> directories;
+    std::vector<file_watcher_entry> files;
+};
+
+}
+
+#endif
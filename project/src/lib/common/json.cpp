@@ -0,0 +1,550 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "json.hpp"
+
+#include "error_handling.hpp"
+
+#include <sstream>
+#include <locale>
+#include <cmath>
+
+namespace cpe
+{
+
+json_value::json_value()
+    :type_data(json_type::null_value),boolean_data(false),number_data(0.0),string_data(),array_data(),object_data()
+{}
+
+json_value::json_value(bool const value)
+    :json_value()
+{
+    type_data = json_type::boolean;
+    boolean_data = value;
+}
+
+json_value::json_value(int const value)
+    :json_value(static_cast<double>(value))
+{}
+
+json_value::json_value(std::size_t const value)
+    :json_value(static_cast<double>(value))
+{}
+
+json_value::json_value(double const value)
+    :json_value()
+{
+    type_data = json_type::number;
+    number_data = value;
+}
+
+json_value::json_value(char const* value)
+    :json_value(std::string(value))
+{}
+
+json_value::json_value(std::string const& value)
+    :json_value()
+{
+    type_data = json_type::string;
+    string_data = value;
+}
+
+json_value json_value::array()
+{
+    json_value v;
+    v.type_data = json_type::array;
+    return v;
+}
+
+json_value json_value::object()
+{
+    json_value v;
+    v.type_data = json_type::object;
+    return v;
+}
+
+json_type json_value::type() const {return type_data;}
+bool json_value::is_null() const {return type_data==json_type::null_value;}
+
+bool json_value::as_bool() const
+{
+    if(type_data!=json_type::boolean)
+        throw exception_cpe("Json value is not a boolean",EXCEPTION_PARAMETERS_CPE);
+    return boolean_data;
+}
+
+double json_value::as_number() const
+{
+    if(type_data!=json_type::number)
+        throw exception_cpe("Json value is not a number",EXCEPTION_PARAMETERS_CPE);
+    return number_data;
+}
+
+int json_value::as_int() const
+{
+    double const value = as_number();
+    if(value!=std::floor(value) || std::abs(value)>2147483647.0)
+        throw exception_cpe("Json value is not an integer",EXCEPTION_PARAMETERS_CPE);
+    return static_cast<int>(value);
+}
+
+std::string const& json_value::as_string() const
+{
+    if(type_data!=json_type::string)
+        throw exception_cpe("Json value is not a string",EXCEPTION_PARAMETERS_CPE);
+    return string_data;
+}
+
+int json_value::size() const
+{
+    if(type_data==json_type::array)
+        return array_data.size();
+    if(type_data==json_type::object)
+        return object_data.size();
+    throw exception_cpe("Json value is neither an array nor an object",EXCEPTION_PARAMETERS_CPE);
+}
+
+json_value const& json_value::operator[](int const index) const
+{
+    if(type_data!=json_type::array)
+        throw exception_cpe("Json value is not an array",EXCEPTION_PARAMETERS_CPE);
+    if(index<0 || index>=static_cast<int>(array_data.size()))
+        throw exception_cpe("Json array index ("+std::to_string(index)+") out of range",EXCEPTION_PARAMETERS_CPE);
+    return array_data[index];
+}
+
+void json_value::push_back(json_value const& value)
+{
+    if(type_data!=json_type::array)
+        throw exception_cpe("Json value is not an array",EXCEPTION_PARAMETERS_CPE);
+    array_data.push_back(value);
+}
+
+bool json_value::has(std::string const& name) const
+{
+    if(type_data!=json_type::object)
+        return false;
+    for(auto const& member : object_data)
+        if(member.first==name)
+            return true;
+    return false;
+}
+
+json_value const& json_value::operator[](std::string const& name) const
+{
+    if(type_data!=json_type::object)
+        throw exception_cpe("Json value is not an object",EXCEPTION_PARAMETERS_CPE);
+    for(auto const& member : object_data)
+        if(member.first==name)
+            return member.second;
+    throw exception_cpe("Json object has no member \""+name+"\"",EXCEPTION_PARAMETERS_CPE);
+}
+
+json_value const& json_value::get(std::string const& name,json_value const& default_value) const
+{
+    for(auto const& member : object_data)
+        if(member.first==name)
+            return member.second;
+    return default_value;
+}
+
+void json_value::set(std::string const& name,json_value const& value)
+{
+    if(type_data!=json_type::object)
+        throw exception_cpe("Json value is not an object",EXCEPTION_PARAMETERS_CPE);
+    for(auto& member : object_data)
+    {
+        if(member.first==name)
+        {
+            member.second = value;
+            return;
+        }
+    }
+    object_data.push_back({name,value});
+}
+
+/** Write a string with its escaped characters */
+static void dump_string_json(std::ostream& stream,std::string const& s)
+{
+    stream<<'"';
+    for(unsigned char const c : s)
+    {
+        if(c=='"' || c=='\\')
+            stream<<'\\'<<c;
+        else if(c=='\n')
+            stream<<"\\n";
+        else if(c=='\t')
+            stream<<"\\t";
+        else if(c=='\r')
+            stream<<"\\r";
+        else if(c<0x20)
+        {
+            static char const* const hexadecimal = "0123456789abcdef";
+            stream<<"\\u00"<<hexadecimal[c>>4]<<hexadecimal[c&15];
+        }
+        else
+            stream<<c;
+    }
+    stream<<'"';
+}
+
+/** Write the compact text of a value */
+static void dump_json(std::ostream& stream,json_value const& value);
+
+std::string json_value::dump() const
+{
+    std::ostringstream stream;
+    stream.imbue(std::locale::classic());
+    dump_json(stream,*this);
+    return stream.str();
+}
+
+static void dump_json(std::ostream& stream,json_value const& value)
+{
+    switch(value.type())
+    {
+    case json_type::null_value:
+        stream<<"null";
+        break;
+    case json_type::boolean:
+        stream<<(value.as_bool()? "true" : "false");
+        break;
+    case json_type::number:
+    {
+        double const x = value.as_number();
+        if(!std::isfinite(x))
+            throw exception_cpe("Json cannot store infinite or nan numbers",EXCEPTION_PARAMETERS_CPE);
+        if(x==std::floor(x) && std::abs(x)<1e15)
+            stream<<static_cast<long long>(x);
+        else
+        {
+            std::ostringstream number;
+            number.imbue(std::locale::classic());
+            number.precision(17);
+            number<<x;
+            stream<<number.str();
+        }
+        break;
+    }
+    case json_type::string:
+        dump_string_json(stream,value.as_string());
+        break;
+    case json_type::array:
+        stream<<'[';
+        for(int k=0 ; k<value.size() ; ++k)
+        {
+            if(k>0)
+                stream<<',';
+            dump_json(stream,value[k]);
+        }
+        stream<<']';
+        break;
+    case json_type::object:
+        stream<<'{';
+        for(int k=0 ; k<value.size() ; ++k)
+        {
+            if(k>0)
+                stream<<',';
+            std::pair<std::string,json_value> const& member = value.member(k);
+            dump_string_json(stream,member.first);
+            stream<<':';
+            dump_json(stream,member.second);
+        }
+        stream<<'}';
+        break;
+    }
+}
+
+std::pair<std::string,json_value> const& json_value::member(int const index) const
+{
+    if(type_data!=json_type::object)
+        throw exception_cpe("Json value is not an object",EXCEPTION_PARAMETERS_CPE);
+    if(index<0 || index>=static_cast<int>(object_data.size()))
+        throw exception_cpe("Json member index ("+std::to_string(index)+") out of range",EXCEPTION_PARAMETERS_CPE);
+    return object_data[index];
+}
+
+/** Cursor of the recursive descent parser of a json text */
+struct json_parser
+{
+    char const* current;
+    char const* begin;
+    char const* end;
+
+    void throw_error(std::string const& msg) const
+    {
+        throw exception_cpe("Json syntax error at character "+std::to_string(current-begin)+": "+msg,EXCEPTION_PARAMETERS_CPE);
+    }
+
+    void skip_blank()
+    {
+        while(current<end && (*current==' ' || *current=='\t' || *current=='\n' || *current=='\r'))
+            ++current;
+    }
+
+    char peek()
+    {
+        skip_blank();
+        if(current>=end)
+            throw_error("unexpected end of text");
+        return *current;
+    }
+
+    void expect(char const c)
+    {
+        if(peek()!=c)
+            throw_error(std::string("expecting '")+c+"'");
+        ++current;
+    }
+
+    void expect_word(char const* word)
+    {
+        for(char const* w=word ; *w!='\0' ; ++w, ++current)
+            if(current>=end || *current!=*w)
+                throw_error(std::string("expecting \"")+word+"\"");
+    }
+
+    json_value parse_value(int const depth)
+    {
+        if(depth>512)
+            throw_error("too many nested values");
+
+        char const c = peek();
+        if(c=='{')
+            return parse_object(depth);
+        if(c=='[')
+            return parse_array(depth);
+        if(c=='"')
+            return json_value(parse_string());
+        if(c=='t')
+        {
+            expect_word("true");
+            return json_value(true);
+        }
+        if(c=='f')
+        {
+            expect_word("false");
+            return json_value(false);
+        }
+        if(c=='n')
+        {
+            expect_word("null");
+            return json_value();
+        }
+        return json_value(parse_number());
+    }
+
+    json_value parse_object(int const depth)
+    {
+        json_value object = json_value::object();
+        expect('{');
+        if(peek()=='}')
+        {
+            ++current;
+            return object;
+        }
+        while(true)
+        {
+            if(peek()!='"')
+                throw_error("expecting the name of a member");
+            std::string const name = parse_string();
+            expect(':');
+            object.set(name,parse_value(depth+1));
+            if(peek()==',')
+                ++current;
+            else
+            {
+                expect('}');
+                return object;
+            }
+        }
+    }
+
+    json_value parse_array(int const depth)
+    {
+        json_value array = json_value::array();
+        expect('[');
+        if(peek()==']')
+        {
+            ++current;
+            return array;
+        }
+        while(true)
+        {
+            array.push_back(parse_value(depth+1));
+            if(peek()==',')
+                ++current;
+            else
+            {
+                expect(']');
+                return array;
+            }
+        }
+    }
+
+    unsigned int parse_hexadecimal_4()
+    {
+        unsigned int value = 0;
+        for(int k=0 ; k<4 ; ++k, ++current)
+        {
+            if(current>=end)
+                throw_error("unexpected end of text");
+            char const c = *current;
+            value *= 16;
+            if(c>='0' && c<='9') value += c-'0';
+            else if(c>='a' && c<='f') value += c-'a'+10;
+            else if(c>='A' && c<='F') value += c-'A'+10;
+            else throw_error("incorrect unicode escape");
+        }
+        return value;
+    }
+
+    static void append_utf8(std::string& s,unsigned int const code)
+    {
+        if(code<0x80)
+            s += static_cast<char>(code);
+        else if(code<0x800)
+        {
+            s += static_cast<char>(0xC0 | (code>>6));
+            s += static_cast<char>(0x80 | (code&0x3F));
+        }
+        else if(code<0x10000)
+        {
+            s += static_cast<char>(0xE0 | (code>>12));
+            s += static_cast<char>(0x80 | ((code>>6)&0x3F));
+            s += static_cast<char>(0x80 | (code&0x3F));
+        }
+        else
+        {
+            s += static_cast<char>(0xF0 | (code>>18));
+            s += static_cast<char>(0x80 | ((code>>12)&0x3F));
+            s += static_cast<char>(0x80 | ((code>>6)&0x3F));
+            s += static_cast<char>(0x80 | (code&0x3F));
+        }
+    }
+
+    std::string parse_string()
+    {
+        expect('"');
+        std::string s;
+        while(true)
+        {
+            if(current>=end)
+                throw_error("unterminated string");
+            char const c = *current++;
+            if(c=='"')
+                return s;
+            if(static_cast<unsigned char>(c)<0x20)
+                throw_error("control character in string");
+            if(c!='\\')
+            {
+                s += c;
+                continue;
+            }
+
+            if(current>=end)
+                throw_error("unterminated string");
+            char const e = *current++;
+            switch(e)
+            {
+            case '"': s += '"'; break;
+            case '\\': s += '\\'; break;
+            case '/': s += '/'; break;
+            case 'b': s += '\b'; break;
+            case 'f': s += '\f'; break;
+            case 'n': s += '\n'; break;
+            case 'r': s += '\r'; break;
+            case 't': s += '\t'; break;
+            case 'u':
+            {
+                unsigned int code = parse_hexadecimal_4();
+                //utf-16 surrogate pair
+                if(code>=0xD800 && code<0xDC00)
+                {
+                    if(end-current<6 || current[0]!='\\' || current[1]!='u')
+                        throw_error("incomplete surrogate pair");
+                    current += 2;
+                    unsigned int const low = parse_hexadecimal_4();
+                    if(low<0xDC00 || low>=0xE000)
+                        throw_error("incorrect surrogate pair");
+                    code = 0x10000+((code-0xD800)<<10)+(low-0xDC00);
+                }
+                append_utf8(s,code);
+                break;
+            }
+            default:
+                throw_error("incorrect escape character");
+            }
+        }
+    }
+
+    double parse_number()
+    {
+        //validate the json grammar, the conversion is done independently of the locale
+        char const* const start = current;
+        if(current<end && *current=='-')
+            ++current;
+        if(current>=end || *current<'0' || *current>'9')
+            throw_error("unexpected character");
+        if(*current=='0')
+            ++current;
+        else
+            while(current<end && *current>='0' && *current<='9') ++current;
+        if(current<end && *current=='.')
+        {
+            ++current;
+            if(current>=end || *current<'0' || *current>'9')
+                throw_error("incorrect number");
+            while(current<end && *current>='0' && *current<='9') ++current;
+        }
+        if(current<end && (*current=='e' || *current=='E'))
+        {
+            ++current;
+            if(current<end && (*current=='+' || *current=='-'))
+                ++current;
+            if(current>=end || *current<'0' || *current>'9')
+                throw_error("incorrect number");
+            while(current<end && *current>='0' && *current<='9') ++current;
+        }
+
+        std::istringstream stream(std::string(start,current));
+        stream.imbue(std::locale::classic());
+        double value = 0.0;
+        stream>>value;
+        if(stream.fail())
+            throw_error("incorrect number");
+        return value;
+    }
+};
+
+json_value parse_json(char const* const begin,char const* const end)
+{
+    json_parser parser = {begin,begin,end};
+    json_value const value = parser.parse_value(0);
+    parser.skip_blank();
+    if(parser.current!=end)
+        parser.throw_error("unexpected characters after the value");
+    return value;
+}
+
+json_value parse_json(std::string const& text)
+{
+    return parse_json(text.data(),text.data()+text.size());
+}
+
+}
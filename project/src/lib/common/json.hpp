@@ -0,0 +1,105 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace cpe
+{
+
+/** Type of a json value */
+enum class json_type {null_value,boolean,number,string,array,object};
+
+/** A json value (RFC 8259): null, boolean, number, string, array of values, or object (ordered list of named values).
+ *  The accessors throw an exception if the value does not have the expected type. */
+class json_value
+{
+public:
+
+    /** null value */
+    json_value();
+    json_value(bool value);
+    json_value(int value);
+    json_value(std::size_t value);
+    json_value(double value);
+    json_value(char const* value);
+    json_value(std::string const& value);
+
+    /** Empty array */
+    static json_value array();
+    /** Empty object */
+    static json_value object();
+
+    json_type type() const;
+    bool is_null() const;
+
+    bool as_bool() const;
+    double as_number() const;
+    /** The number as an integer, throw if it is not an integer */
+    int as_int() const;
+    std::string const& as_string() const;
+
+    /** Number of values of an array, or number of members of an object */
+    int size() const;
+
+    /** The k-th value of an array */
+    json_value const& operator[](int index) const;
+    /** Add a value at the end of an array */
+    void push_back(json_value const& value);
+
+    /** The k-th member (name,value) of an object */
+    std::pair<std::string,json_value> const& member(int index) const;
+    /** Check if an object has a member with the given name */
+    bool has(std::string const& name) const;
+    /** The member with the given name of an object (throw if it does not exist) */
+    json_value const& operator[](std::string const& name) const;
+    /** The member with the given name of an object, or the default value if it does not exist */
+    json_value const& get(std::string const& name,json_value const& default_value) const;
+    /** Set the member with the given name of an object (added at the end if it does not exist) */
+    void set(std::string const& name,json_value const& value);
+
+    /** Compact text of the value */
+    std::string dump() const;
+
+private:
+
+    json_type type_data;
+    bool boolean_data;
+    double number_data;
+    std::string string_data;
+    /** Values of an array */
+    std::vector<json_value> array_data;
+    /** Members of an object, in their order of insertion */
+    std::vector<std::pair<std::string,json_value>> object_data;
+};
+
+/** Parse a json text, throw an exception on syntax error */
+json_value parse_json(char const* begin,char const* end);
+/** Parse a json text, throw an exception on syntax error */
+json_value parse_json(std::string const& text);
+
+}
+
+#endif
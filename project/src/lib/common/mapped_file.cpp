@@ -0,0 +1,97 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mapped_file.hpp"
+
+#include "error_handling.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace cpe
+{
+
+mapped_file::mapped_file()
+    :address(nullptr),size_data(0)
+{}
+
+mapped_file::mapped_file(std::string const& filename)
+    :address(nullptr),size_data(0)
+{
+    open(filename);
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+void mapped_file::open(std::string const& filename)
+{
+    close();
+
+    int const fid = ::open(filename.c_str(),O_RDONLY);
+    if(fid<0)
+        throw exception_cpe("Cannot open file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    struct stat info;
+    if(fstat(fid,&info)!=0)
+    {
+        ::close(fid);
+        throw exception_cpe("Cannot get the size of file "+filename,EXCEPTION_PARAMETERS_CPE);
+    }
+
+    //an empty file cannot be mapped
+    std::size_t const size = static_cast<std::size_t>(info.st_size);
+    if(size>0)
+    {
+        void* const p = mmap(nullptr,size,PROT_READ,MAP_PRIVATE,fid,0);
+        if(p==MAP_FAILED)
+        {
+            ::close(fid);
+            throw exception_cpe("Cannot map file "+filename,EXCEPTION_PARAMETERS_CPE);
+        }
+        address = p;
+        size_data = size;
+    }
+
+    //the mapping stays valid after the file is closed
+    ::close(fid);
+}
+
+void mapped_file::close()
+{
+    if(address!=nullptr)
+        munmap(address,size_data);
+    address = nullptr;
+    size_data = 0;
+}
+
+char const* mapped_file::data() const
+{
+    return static_cast<char const*>(address);
+}
+
+std::size_t mapped_file::size() const
+{
+    return size_data;
+}
+
+}
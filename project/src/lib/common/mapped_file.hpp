@@ -0,0 +1,66 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+namespace cpe
+{
+
+/** Read-only memory mapping of a whole file.
+ *  The content is paged in by the system when it is accessed: no copy is made and
+ *  several threads can read different parts of the file at the same time. */
+class mapped_file
+{
+public:
+
+    mapped_file();
+    /** Map the given file (see open) */
+    explicit mapped_file(std::string const& filename);
+    ~mapped_file();
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    /** Map the given file, throw an exception if it cannot be opened */
+    void open(std::string const& filename);
+    /** Unmap the file (the pointers given by data are no longer valid) */
+    void close();
+
+    /** Content of the file (nullptr for an empty or closed file) */
+    char const* data() const;
+    /** Size of the file in bytes */
+    std::size_t size() const;
+
+private:
+
+    /** Address of the mapping */
+    void* address;
+    /** Size of the mapping */
+    std::size_t size_data;
+};
+
+}
+
+#endif
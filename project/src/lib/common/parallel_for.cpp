@@ -0,0 +1,80 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "parallel_for.hpp"
+
+#include <exception>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace cpe
+{
+
+int parallel_for_chunk_count(int const N,int const min_chunk_size)
+{
+    if(N<=0)
+        return 0;
+    int const N_thread = std::max(1u,std::thread::hardware_concurrency());
+    int const N_chunk_max = std::max(1,N/std::max(1,min_chunk_size));
+    return std::min(N_thread,N_chunk_max);
+}
+
+void parallel_for(int const N,std::function<void(int begin,int end)> const& f,int const min_chunk_size)
+{
+    int const N_chunk = parallel_for_chunk_count(N,min_chunk_size);
+    if(N_chunk==0)
+        return;
+    if(N_chunk==1)
+    {
+        f(0,N);
+        return;
+    }
+
+    //the exception of each chunk is kept until all the threads are joined
+    std::vector<std::exception_ptr> errors(N_chunk);
+    auto const run_chunk = [&f,&errors,N,N_chunk](int const k_chunk)
+    {
+        int const begin = static_cast<long long>(N)*k_chunk/N_chunk;
+        int const end = static_cast<long long>(N)*(k_chunk+1)/N_chunk;
+        try
+        {
+            f(begin,end);
+        }
+        catch(...)
+        {
+            errors[k_chunk] = std::current_exception();
+        }
+    };
+
+    //the calling thread processes the last chunk
+    std::vector<std::thread> threads;
+    threads.reserve(N_chunk-1);
+    for(int k_chunk=0 ; k_chunk<N_chunk-1 ; ++k_chunk)
+        threads.push_back(std::thread(run_chunk,k_chunk));
+    run_chunk(N_chunk-1);
+
+    for(std::thread& t : threads)
+        t.join();
+
+    for(std::exception_ptr const& error : errors)
+        if(error)
+            std::rethrow_exception(error);
+}
+
+}
@@ -0,0 +1,42 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef PARALLEL_FOR_HPP
+#define PARALLEL_FOR_HPP
+
+#include <functional>
+
+namespace cpe
+{
+
+/** Call f(begin,end) on contiguous chunks covering [0,N[, each chunk in its own thread.
+ *  The number of chunks is limited by the number of hardware threads and by min_chunk_size
+ *   (small ranges are processed in the calling thread).
+ *  If f throws, the other chunks are still processed, then the exception of the first failing chunk is thrown again.
+*/
+void parallel_for(int N,std::function<void(int begin,int end)> const& f,int min_chunk_size=16384);
+
+/** Number of chunks used by parallel_for for a range of size N */
+int parallel_for_chunk_count(int N,int min_chunk_size=16384);
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef PENDING_VALUE_HPP
+#define PENDING_VALUE_HPP
+
+#include <mutex>
+#include <utility>
+
+namespace cpe
+{
+
+/** Value produced by a thread and taken by another one (ex. data reloaded in the background and swapped in the scene).
+ *  Only the last value set before it is taken is kept.
+*/
+template <typename T>
+class pending_value
+{
+public:
+
+    pending_value():mutex(),value(),available(false) {}
+
+    /** Store a new value, replacing the one not taken yet if any */
+    void set(T new_value)
+    {
+        std::lock_guard<std::mutex> const lock(mutex);
+        value = std::move(new_value);
+        available = true;
+    }
+
+    /** Move the stored value in result without waiting: returns false if there is no value,
+     *   or if it is being set by the other thread (it is then taken at the next call). */
+    bool take(T& result)
+    {
+        std::unique_lock<std::mutex> const lock(mutex,std::try_to_lock);
+        if(!lock.owns_lock() || !available)
+            return false;
+        result = std::move(value);
+        value = T();
+        available = false;
+        return true;
+    }
+
+private:
+
+    std::mutex mutex;
+    T value;
+    bool available;
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "camera_matrices.hpp"
+
+#include "../3d/vec3.hpp"
+
+namespace cpe
+{
+
+mat4 build_normal_matrix(mat4 const& w)
+{
+    //the normal matrix is used to compute the transformation of the normals of the meshes
+    mat4 normal_matrix=mat4(w(0,0),w(1,0),w(2,0),0,
+                            w(0,1),w(1,1),w(2,1),0,
+                            w(0,2),w(1,2),w(2,2),0,
+                            0,0,0,1);
+    vec4 tr(w(0,3),w(1,3),w(2,3),1.0f);
+    vec4 tr_inv=-normal_matrix*tr;
+    normal_matrix(0,3)=tr_inv[0];
+    normal_matrix(1,3)=tr_inv[1];
+    normal_matrix(2,3)=tr_inv[2];
+
+    normal_matrix=transposed(normal_matrix);
+
+    return normal_matrix;
+}
+
+view_frustum build_view_frustum(camera_matrices const& cam)
+{
+    //the planes are combinations of the rows of the matrix projection*modelview (Gribb & Hartmann)
+    mat4 const M = cam.projection*cam.modelview;
+    vec4 row[4];
+    for(int k=0 ; k<4 ; ++k)
+        row[k] = vec4(M(k,0),M(k,1),M(k,2),M(k,3));
+
+    view_frustum frustum;
+    frustum.plane[0] = row[3]+row[0]; //left
+    frustum.plane[1] = row[3]-row[0]; //right
+    frustum.plane[2] = row[3]+row[1]; //bottom
+    frustum.plane[3] = row[3]-row[1]; //top
+    frustum.plane[4] = row[3]+row[2]; //near
+    frustum.plane[5] = row[3]-row[2]; //far
+
+    return frustum;
+}
+
+bool is_aabb_visible(view_frustum const& frustum,vec3 const& corner_min,vec3 const& corner_max)
+{
+    for(vec4 const& p : frustum.plane)
+    {
+        //corner of the box the most inside the plane
+        vec3 const q(p.x()>=0 ? corner_max.x() : corner_min.x(),
+                     p.y()>=0 ? corner_max.y() : corner_min.y(),
+                     p.z()>=0 ? corner_max.z() : corner_min.z());
+        if(p.x()*q.x()+p.y()*q.y()+p.z()*q.z()+p.w()<0)
+            return false;
+    }
+    return true;
+}
+
+float projected_size(camera_matrices const& cam,vec3 const& corner_min,vec3 const& corner_max)
+{
+    vec3 const center = (corner_min+corner_max)/2.0f;
+    float const radius = norm(corner_max-corner_min)/2.0f;
+
+    //distance along the view direction (the camera looks toward -z)
+    float const depth = -(cam.modelview*center).z();
+    if(depth<=radius)
+        return 1.0f;
+
+    //the screen height covers 2*depth/P(1,1) at this depth
+    return radius*cam.projection(1,1)/depth;
+}
+
+}
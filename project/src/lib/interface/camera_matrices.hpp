@@ -22,6 +22,7 @@
 #define CAMERA_MATRICES_HPP
 
 #include "../3d/mat4.hpp"
+#include "../3d/vec4.hpp"
 
 namespace cpe
 {
@@ -31,6 +32,27 @@ struct camera_matrices
     mat4 projection;
     mat4 normal;
 };
+
+/** Compute the matrix transforming the normals of the meshes from the modelview matrix */
+mat4 build_normal_matrix(mat4 const& modelview);
+
+/** The 6 planes (a,b,c,d) bounding the visible volume of a camera, in world space.
+ *  A point p is inside the frustum if a*p.x+b*p.y+c*p.z+d>=0 for every plane. */
+struct view_frustum
+{
+    vec4 plane[6];
+};
+
+/** Extract the planes of the view frustum from the projection and modelview matrices */
+view_frustum build_view_frustum(camera_matrices const& cam);
+
+/** Check if an axis aligned bounding box is (at least partially) inside the frustum.
+ *  Conservative test: some boxes close to the corners of the frustum are seen as visible. */
+bool is_aabb_visible(view_frustum const& frustum,vec3 const& corner_min,vec3 const& corner_max);
+
+/** Approximate size of an axis aligned bounding box on the screen, as a fraction of the screen height
+ *  (diameter of its bounding sphere at the distance of its center, for a perspective projection). */
+float projected_size(camera_matrices const& cam,vec3 const& corner_min,vec3 const& corner_max);
 }
 
 #endif
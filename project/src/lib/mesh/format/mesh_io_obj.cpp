@@ -18,257 +18,532 @@
 
 #include "mesh_io_obj.hpp"
 #include "../../common/error_handling.hpp"
+#include "../../common/mapped_file.hpp"
+#include "../../common/parallel_for.hpp"
 #include "../../mesh/mesh.hpp"
 
-#include <sstream>
-#include <fstream>
-#include <assert.h>
-#include <map>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 namespace cpe
 {
 
-std::vector<int> split_face_data(std::string const& face_data_str)
+/** Open addressing hash table giving the index of the mesh vertex associated to a (vertex,texture,normal) triplet of indices */
+struct obj_corner_table
 {
-    std::vector<int> data;
-    std::string current_str=face_data_str;
+    /** Table able to store N_corner triplets */
+    obj_corner_table(int N_corner);
+
+    /** Index associated to the triplet. If the triplet is not in the table, it is associated to new_index which is returned. */
+    int find_or_insert(int v,int vt,int vn,int new_index);
+
+    /** The triplets (3 indices per slot) */
+    std::vector<int> key;
+    /** The index associated to each slot (-1 for an empty slot) */
+    std::vector<int> value;
+    /** Number of slots - 1 (the number of slots is a power of 2) */
+    unsigned int mask;
+};
+
+obj_corner_table::obj_corner_table(int const N_corner)
+    :key(),value(),mask(0)
+{
+    //load factor at most 1/2
+    unsigned int N_slot = 16;
+    while(N_slot<2u*static_cast<unsigned int>(N_corner))
+        N_slot *= 2;
+    key.resize(3*N_slot);
+    value.assign(N_slot,-1);
+    mask = N_slot-1;
+}
+
+int obj_corner_table::find_or_insert(int const v,int const vt,int const vn,int const new_index)
+{
+    unsigned int h = static_cast<unsigned int>(v)*0x9E3779B1u ^ static_cast<unsigned int>(vt+1)*0x85EBCA77u ^ static_cast<unsigned int>(vn+1)*0xC2B2AE3Du;
+    h ^= h>>15;
+    h *= 0x2C1B3C6Du;
+    h ^= h>>12;
 
-    while(current_str.length()>0)
+    //linear probing
+    for(unsigned int slot=h&mask ; ; slot=(slot+1)&mask)
     {
-        while(current_str.length()>0 && current_str[0]=='/')
+        if(value[slot]<0)
         {
-            std::string temp_str=current_str.substr(1,current_str.length()-1);
-            current_str=temp_str;
+            key[3*slot+0] = v;
+            key[3*slot+1] = vt;
+            key[3*slot+2] = vn;
+            value[slot] = new_index;
+            return new_index;
         }
+        if(key[3*slot+0]==v && key[3*slot+1]==vt && key[3*slot+2]==vn)
+            return value[slot];
+    }
+}
 
-        int value;
-        std::stringstream tokenizer(current_str);
-        tokenizer>>value;
-        data.push_back(value);
-
-        std::string residual;
-        tokenizer>>residual;
 
-        current_str=residual;
-    }
+/** Throw an exception describing the malformed line [begin,end[ */
+static void throw_malformed_line_obj(char const* begin,char const* end)
+{
+    throw exception_cpe("Malformed line in obj file: \""+std::string(begin,end)+"\"",EXCEPTION_PARAMETERS_CPE);
+}
 
-    return data;
+/** Skip the spaces and tabulations */
+static char const* skip_blank(char const* p,char const* const end)
+{
+    while(p<end && (*p==' ' || *p=='\t' || *p=='\r'))
+        ++p;
+    return p;
 }
 
-void read_vertex_obj(std::stringstream& tokens,obj_structure& obj)
+/** Check if p is at the end of a word */
+static bool is_end_of_word(char const* p,char const* const end)
 {
-    vec3 v;
-    tokens >> v.x();
-    tokens >> v.y();
-    tokens >> v.z();
-    obj.data_vertex.push_back(v);
+    return p==end || *p==' ' || *p=='\t' || *p=='\r';
 }
 
-void read_texture_obj(std::stringstream& tokens,obj_structure& obj)
+/** 10^e, exact for |e|<=22 */
+static double power_of_ten(int const e)
 {
-    vec2 t;
-    tokens >> t.x();
-    tokens >> t.y();
-    obj.data_texture.push_back(t);
+    static double const exact[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                   1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    if(e>=0 && e<=22)
+        return exact[e];
+    return std::pow(10.0,e);
 }
 
-void read_normal_obj(std::stringstream& tokens,obj_structure& obj)
+/** Parse a signed integer starting at p. Return the position following it, or nullptr if there is no digit. */
+static char const* parse_int_obj(char const* p,char const* const end,int& value)
 {
-    vec3 n;
-    tokens >> n.x();
-    tokens >> n.y();
-    tokens >> n.z();
-    obj.data_normal.push_back(n);
+    bool negative = false;
+    if(p<end && (*p=='-' || *p=='+'))
+        negative = *p++=='-';
+    if(p==end || *p<'0' || *p>'9')
+        return nullptr;
+
+    long long v = 0;
+    while(p<end && *p>='0' && *p<='9')
+        v = 10*v+(*p++-'0');
+    value = static_cast<int>(negative? -v : v);
+    return p;
 }
 
-void read_face_obj(std::stringstream& tokens,obj_structure& obj)
+/** Parse a decimal number (ex. -1.25e-3) starting at p. Return the position following it, or nullptr if it is not a number. */
+static char const* parse_float_obj(char const* p,char const* const end,float& value)
 {
-    std::vector<std::vector<int> > face_data;
-    while(tokens.good())
+    bool negative = false;
+    if(p<end && (*p=='-' || *p=='+'))
+        negative = *p++=='-';
+
+    //the 19 first significant digits are kept in an integer
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool is_number = false;
+    while(p<end && *p>='0' && *p<='9')
     {
-        std::string polygon_index_str;
-        tokens >> polygon_index_str;
-
-        std::vector<int> const current_data=split_face_data(polygon_index_str);
-        face_data.push_back(current_data);
+        is_number = true;
+        if(digits<19)
+        {
+            mantissa = 10*mantissa+(*p-'0');
+            digits += mantissa>0;
+        }
+        else
+            ++exponent;
+        ++p;
     }
-
-    std::vector<int> temp_vertex;
-    std::vector<int> temp_texture;
-    std::vector<int> temp_normal;
-    for(auto const& index_face : face_data)
+    if(p<end && *p=='.')
     {
-        int const N_dim=index_face.size();
-        for(int k_dim=0;k_dim<N_dim;++k_dim)
+        ++p;
+        while(p<end && *p>='0' && *p<='9')
         {
-            int const value=index_face[k_dim];
-
-            switch(k_dim)
+            is_number = true;
+            if(digits<19)
             {
-            case 0:
-                temp_vertex.push_back(value-1);
-                break;
-            case 1:
-                temp_texture.push_back(value-1);
-                break;
-            case 2:
-                temp_normal.push_back(value-1);
-                break;
-            default:
-                std::cerr<<"Error reading file "<<std::endl;
-                exit(1);
+                mantissa = 10*mantissa+(*p-'0');
+                digits += mantissa>0;
+                --exponent;
             }
+            ++p;
         }
     }
+    if(!is_number)
+        return nullptr;
 
-    if(temp_vertex.size()>0)
-        obj.data_face_vertex.push_back(temp_vertex);
-    if(temp_texture.size()>0)
-        obj.data_face_texture.push_back(temp_texture);
-    if(temp_normal.size()>0)
-        obj.data_face_normal.push_back(temp_normal);
+    if(p<end && (*p=='e' || *p=='E'))
+    {
+        int e = 0;
+        p = parse_int_obj(p+1,end,e);
+        if(p==nullptr)
+            return nullptr;
+        exponent += e;
+    }
+
+    double const v = exponent<0? mantissa/power_of_ten(-exponent) : mantissa*power_of_ten(exponent);
+    value = static_cast<float>(negative? -v : v);
+    return p;
 }
 
-obj_structure load_file_obj_structure(std::string const& filename)
+/** Read the coordinates following the keyword of a line: at least N_required and at most N values are read, the missing ones are 0 */
+static void read_coordinates_obj(char const* p,char const* const end,float* value,int const N,int const N_required,char const* line_begin)
 {
-    std::ifstream fid(filename.c_str());
-    if(!fid.good())
-        throw exception_cpe("Cannot open file "+filename,MACRO_EXCEPTION_PARAMETER);
-
-    std::string buffer;
+    for(int k=0 ; k<N ; ++k)
+    {
+        value[k] = 0.0f;
+        p = skip_blank(p,end);
+        if(p==end && k>=N_required)
+            continue;
+        p = parse_float_obj(p,end,value[k]);
+        if(p==nullptr || !is_end_of_word(p,end))
+            throw_malformed_line_obj(line_begin,end);
+    }
+}
 
-    obj_structure structure;
+/** Part of an obj file parsed independently of the others */
+struct obj_chunk
+{
+    /** Content of the chunk. The positive indices are absolute, the relative ones are resolved within the chunk only */
+    obj_structure obj;
+    /** Corners using a relative index for their vertex, texture and normal: their index is offset by the number of
+     *  elements of the previous chunks when the chunks are merged (the index may still be negative before) */
+    std::vector<int> relative_vertex;
+    std::vector<int> relative_texture;
+    std::vector<int> relative_normal;
+};
+
+/** Convert an index of the file (starting at 1, or negative relative to the elements already read) to an index starting at 0.
+ *  The relative indices are resolved from the elements of the chunk, and the corner is recorded in the list of relative corners. */
+static int resolve_index_obj(int const index,int const N_current,int const corner,std::vector<int>& relative,char const* line_begin,char const* end)
+{
+    if(index>0)
+        return index-1;
+    if(index==0)
+        throw_malformed_line_obj(line_begin,end);
+    relative.push_back(corner);
+    return N_current+index;
+}
 
-    //read the whole file
-    while(fid.good()==true)
+/** Read the corners of a face: v, v/vt, v//vn or v/vt/vn */
+static void read_face_obj(char const* p,char const* const end,obj_chunk& chunk,char const* line_begin)
+{
+    obj_structure& obj = chunk.obj;
+    int N_corner = 0;
+    while((p=skip_blank(p,end))<end)
     {
-        //read line
-        std::getline(fid,buffer);
+        int v=0, vt=0, vn=0;
+        bool is_texture=false, is_normal=false;
 
-        if(buffer.size()>0)
+        p = parse_int_obj(p,end,v);
+        if(p!=nullptr && p<end && *p=='/')
         {
-            std::stringstream tokens_buffer(buffer);
-            std::string first_word;
-            tokens_buffer>>first_word;
-
-            //skip comments
-            if(first_word.length()>0 && first_word[0]!='#')
+            ++p;
+            if(p<end && *p!='/')
             {
-                //vertices
-                if(first_word=="v")
-                    read_vertex_obj(tokens_buffer,structure);
+                p = parse_int_obj(p,end,vt);
+                is_texture = true;
+            }
+            if(p!=nullptr && p<end && *p=='/')
+            {
+                p = parse_int_obj(p+1,end,vn);
+                is_normal = true;
+            }
+        }
+        if(p==nullptr || !is_end_of_word(p,end))
+            throw_malformed_line_obj(line_begin,end);
+
+        int const corner = obj.corner_vertex.size();
+        obj.corner_vertex.push_back(resolve_index_obj(v,obj.data_vertex.size(),corner,chunk.relative_vertex,line_begin,end));
+        obj.corner_texture.push_back(is_texture? resolve_index_obj(vt,obj.data_texture.size(),corner,chunk.relative_texture,line_begin,end) : -1);
+        obj.corner_normal.push_back(is_normal? resolve_index_obj(vn,obj.data_normal.size(),corner,chunk.relative_normal,line_begin,end) : -1);
+        ++N_corner;
+    }
 
-                //texture
-                if(first_word=="vt")
-                    read_texture_obj(tokens_buffer,structure);
+    if(N_corner<3)
+        throw_malformed_line_obj(line_begin,end);
+    obj.face_offset.push_back(obj.corner_vertex.size());
+}
 
-                //normal
-                if(first_word=="vn")
-                    read_normal_obj(tokens_buffer,structure);
+/** Read all the values of a 'sk' line */
+static void read_skinning_obj(char const* p,char const* const end,obj_structure& obj,char const* line_begin)
+{
+    while((p=skip_blank(p,end))<end)
+    {
+        float value = 0.0f;
+        p = parse_float_obj(p,end,value);
+        if(p==nullptr || !is_end_of_word(p,end))
+            throw_malformed_line_obj(line_begin,end);
+        obj.data_skinning.push_back(value);
+    }
+    obj.skinning_offset.push_back(obj.data_skinning.size());
+}
 
-                //connectivity
-                if(first_word=="f")
-                    read_face_obj(tokens_buffer,structure);
-            }
+/** Read a single line [begin,end[ of an obj file (without the end of line) */
+static void read_line_obj(char const* const begin,char const* const end,obj_chunk& chunk)
+{
+    char const* const keyword = skip_blank(begin,end);
+    char const* p = keyword;
+    while(!is_end_of_word(p,end))
+        ++p;
+    int const length = p-keyword;
 
-        }
+    if(length==1 && keyword[0]=='v')
+    {
+        float c[3];
+        read_coordinates_obj(p,end,c,3,3,begin);
+        chunk.obj.data_vertex.push_back(vec3(c[0],c[1],c[2]));
+    }
+    else if(length==2 && keyword[0]=='v' && keyword[1]=='t')
+    {
+        float c[2];
+        read_coordinates_obj(p,end,c,2,1,begin);
+        chunk.obj.data_texture.push_back(vec2(c[0],c[1]));
+    }
+    else if(length==2 && keyword[0]=='v' && keyword[1]=='n')
+    {
+        float c[3];
+        read_coordinates_obj(p,end,c,3,3,begin);
+        chunk.obj.data_normal.push_back(vec3(c[0],c[1],c[2]));
+    }
+    else if(length==1 && keyword[0]=='f')
+        read_face_obj(p,end,chunk,begin);
+    else if(length==2 && keyword[0]=='s' && keyword[1]=='k')
+        read_skinning_obj(p,end,chunk.obj,begin);
+}
 
+/** Read all the lines of [begin,end[ */
+static void read_chunk_obj(char const* line,char const* const end,obj_chunk& chunk)
+{
+    while(line<end)
+    {
+        char const* line_end = static_cast<char const*>(std::memchr(line,'\n',end-line));
+        if(line_end==nullptr)
+            line_end = end;
+
+        //skip comments
+        char const* const first = skip_blank(line,line_end);
+        if(first<line_end && *first!='#')
+            read_line_obj(first,line_end,chunk);
+
+        line = line_end+1;
     }
+}
 
-    fid.close();
+/** Offset the relative indices of a chunk by the number of elements of the previous chunks, throw if they are still negative */
+static void offset_relative_index_obj(std::vector<int>& index,std::vector<int> const& relative,int const offset,std::string const& filename)
+{
+    for(int const corner : relative)
+    {
+        index[corner] += offset;
+        if(index[corner]<0)
+            throw exception_cpe("Relative index refers to an element before the beginning of file "+filename,EXCEPTION_PARAMETERS_CPE);
+    }
+}
 
-    return structure;
+/** Append the elements of a chunk at the given offset of the merged vector */
+template <typename T>
+static void copy_chunk_obj(std::vector<T> const& chunk_data,std::vector<T>& data,std::size_t const offset)
+{
+    std::copy(chunk_data.begin(),chunk_data.end(),data.begin()+offset);
 }
 
+/** Minimal size of the chunk parsed by a thread (bytes) */
+static std::size_t const obj_min_chunk_size = 1<<20;
 
+obj_load_report::obj_load_report()
+    :size_file(0),N_chunk(0),time_parse(0.0),time_merge(0.0)
+{}
 
-mesh load_mesh_file_obj(const std::string& filename)
+double obj_load_report::throughput() const
 {
-    mesh mesh_loaded;
+    double const time = time_parse+time_merge;
+    if(time<=0.0)
+        return 0.0;
+    return (size_file/(1024.0*1024.0))/(time/1000.0);
+}
 
-    obj_structure obj=load_file_obj_structure(filename);
+obj_structure::obj_structure()
+    :data_vertex(),data_texture(),data_normal(),face_offset(1,0),corner_vertex(),corner_texture(),corner_normal(),
+     skinning_offset(1,0),data_skinning()
+{}
 
-    bool is_vertex=obj.data_vertex.size()>0 && obj.data_face_vertex.size()>0;
-    bool is_normal=obj.data_normal.size()>0 && obj.data_face_normal.size()>0;
-    bool is_texture=obj.data_texture.size()>0 && obj.data_face_texture.size()>0;
+int obj_structure::size_face() const
+{
+    return face_offset.size()-1;
+}
 
+int obj_structure::size_skinning() const
+{
+    return skinning_offset.size()-1;
+}
+
+obj_structure load_file_obj_structure(std::string const& filename,obj_load_report* report)
+{
+    std::chrono::steady_clock::time_point const t_parse = std::chrono::steady_clock::now();
 
+    mapped_file const file(filename);
+    char const* const begin = file.data();
+    std::size_t const size = file.size();
 
-    if(is_vertex && !is_normal && !is_texture)
+    //chunks boundaries are moved just after the next end of line
+    int const N_chunk = static_cast<int>(std::max<std::size_t>(1,std::min<std::size_t>(std::max(1u,std::thread::hardware_concurrency()),size/obj_min_chunk_size)));
+    std::vector<std::size_t> boundary(N_chunk+1,size);
+    boundary[0] = 0;
+    for(int k=1 ; k<N_chunk ; ++k)
     {
-        int const N_face=obj.data_face_vertex.size();
-        for(int k_face=0;k_face<N_face;++k_face)
-        {
-            auto const& polygon=obj.data_face_vertex[k_face];
-            int const dim=polygon.size();
+        std::size_t const start = std::max(size/N_chunk*k,boundary[k-1]);
+        char const* const line_end = static_cast<char const*>(std::memchr(begin+start,'\n',size-start));
+        boundary[k] = line_end!=nullptr? line_end-begin+1 : size;
+    }
 
-            assert(dim>=2);
-            for(int k=2;k<dim;++k)
-                mesh_loaded.add_triangle_index({polygon[0],polygon[1],polygon[k]});
-        }
+    //each chunk is parsed by its own thread (a parsing error is thrown again once all the threads are done)
+    std::vector<obj_chunk> chunks(N_chunk);
+    parallel_for(N_chunk,[&](int const first,int const last)
+    {
+        for(int k=first ; k<last ; ++k)
+            read_chunk_obj(begin+boundary[k],begin+boundary[k+1],chunks[k]);
+    },1);
 
-        int const N_vertex=obj.data_vertex.size();
-        for(int k_vertex=0;k_vertex<N_vertex;++k_vertex)
-            mesh_loaded.add_vertex(obj.data_vertex[k_vertex]);
-    }
+    std::chrono::steady_clock::time_point const t_merge = std::chrono::steady_clock::now();
 
-    if((is_vertex && !is_normal && is_texture) || (is_vertex && is_normal && is_texture) )//note: normal are not read
+    //offset of each chunk in the merged arrays
+    std::vector<std::size_t> offset_vertex(N_chunk+1,0),offset_texture(N_chunk+1,0),offset_normal(N_chunk+1,0);
+    std::vector<std::size_t> offset_face(N_chunk+1,0),offset_corner(N_chunk+1,0);
+    std::vector<std::size_t> offset_skinning(N_chunk+1,0),offset_skinning_value(N_chunk+1,0);
+    for(int k=0 ; k<N_chunk ; ++k)
     {
-        std::vector<vec3> data_vertex;
-        std::vector<vec2> data_texture;
+        obj_structure const& obj = chunks[k].obj;
+        offset_vertex[k+1]  = offset_vertex[k]+obj.data_vertex.size();
+        offset_texture[k+1] = offset_texture[k]+obj.data_texture.size();
+        offset_normal[k+1]  = offset_normal[k]+obj.data_normal.size();
+        offset_face[k+1]    = offset_face[k]+obj.size_face();
+        offset_corner[k+1]  = offset_corner[k]+obj.corner_vertex.size();
+        offset_skinning[k+1] = offset_skinning[k]+obj.size_skinning();
+        offset_skinning_value[k+1] = offset_skinning_value[k]+obj.data_skinning.size();
+    }
 
-        std::map<int,int> map_vertex;
-        std::map<int,int> map_texture;
-        long int counter_max=0;
+    for(int k=0 ; k<N_chunk ; ++k)
+    {
+        obj_chunk& chunk = chunks[k];
+        offset_relative_index_obj(chunk.obj.corner_vertex,chunk.relative_vertex,offset_vertex[k],filename);
+        offset_relative_index_obj(chunk.obj.corner_texture,chunk.relative_texture,offset_texture[k],filename);
+        offset_relative_index_obj(chunk.obj.corner_normal,chunk.relative_normal,offset_normal[k],filename);
+    }
 
-        int const N_face=obj.data_face_vertex.size();
-        assert(static_cast<int>(obj.data_face_texture.size())==N_face);
-        for(int k_face=0;k_face<N_face;++k_face)
+    obj_structure structure;
+    structure.data_vertex.resize(offset_vertex[N_chunk]);
+    structure.data_texture.resize(offset_texture[N_chunk]);
+    structure.data_normal.resize(offset_normal[N_chunk]);
+    structure.face_offset.resize(offset_face[N_chunk]+1);
+    structure.corner_vertex.resize(offset_corner[N_chunk]);
+    structure.corner_texture.resize(offset_corner[N_chunk]);
+    structure.corner_normal.resize(offset_corner[N_chunk]);
+    structure.skinning_offset.resize(offset_skinning[N_chunk]+1);
+    structure.data_skinning.resize(offset_skinning_value[N_chunk]);
+
+    parallel_for(N_chunk,[&](int const first,int const last)
+    {
+        for(int k=first ; k<last ; ++k)
         {
-            std::vector<int> const& face_vertex=obj.data_face_vertex[k_face];
-            std::vector<int> const& face_texture=obj.data_face_texture[k_face];
+            obj_structure const& obj = chunks[k].obj;
+            copy_chunk_obj(obj.data_vertex,structure.data_vertex,offset_vertex[k]);
+            copy_chunk_obj(obj.data_texture,structure.data_texture,offset_texture[k]);
+            copy_chunk_obj(obj.data_normal,structure.data_normal,offset_normal[k]);
+            copy_chunk_obj(obj.corner_vertex,structure.corner_vertex,offset_corner[k]);
+            copy_chunk_obj(obj.corner_texture,structure.corner_texture,offset_corner[k]);
+            copy_chunk_obj(obj.corner_normal,structure.corner_normal,offset_corner[k]);
+
+            int const N_face = obj.size_face();
+            for(int k_face=0 ; k_face<N_face ; ++k_face)
+                structure.face_offset[offset_face[k]+k_face+1] = offset_corner[k]+obj.face_offset[k_face+1];
+
+            copy_chunk_obj(obj.data_skinning,structure.data_skinning,offset_skinning_value[k]);
+            int const N_skinning = obj.size_skinning();
+            for(int k_skinning=0 ; k_skinning<N_skinning ; ++k_skinning)
+                structure.skinning_offset[offset_skinning[k]+k_skinning+1] = offset_skinning_value[k]+obj.skinning_offset[k_skinning+1];
+        }
+    },1);
 
-            int const dim=face_vertex.size();
-            assert(dim>2);
-            assert(static_cast<int>(face_texture.size())==dim);
-            for(int k_dim=0;k_dim<dim;++k_dim)
-            {
-                int const idx_vertex=face_vertex[k_dim];
-                int const idx_texture=face_texture[k_dim];
+    if(report!=nullptr)
+    {
+        std::chrono::steady_clock::time_point const t_end = std::chrono::steady_clock::now();
+        report->size_file  = size;
+        report->N_chunk    = N_chunk;
+        report->time_parse = std::chrono::duration<double,std::milli>(t_merge-t_parse).count();
+        report->time_merge = std::chrono::duration<double,std::milli>(t_end-t_merge).count();
+    }
 
-                std::map<int,int>::const_iterator it_vertex=map_vertex.find(idx_vertex);
-                std::map<int,int>::const_iterator it_texture=map_texture.find(idx_texture);
+    return structure;
+}
 
-                if(it_vertex==map_vertex.end() || it_texture==map_texture.end())
-                {
-                    map_vertex[idx_vertex]=counter_max;
-                    map_texture[idx_texture]=counter_max;
 
-                    counter_max++;
 
-                    assert(static_cast<int>(obj.data_vertex.size())>idx_vertex);
-                    assert(static_cast<int>(obj.data_texture.size())>idx_texture);
+mesh load_mesh_file_obj(const std::string& filename,obj_load_report* report)
+{
+    obj_structure const obj=load_file_obj_structure(filename,report);
 
-                    mesh_loaded.add_vertex(obj.data_vertex[idx_vertex]);
-                    mesh_loaded.add_texture_coord(obj.data_texture[idx_texture]);
+    int const N_corner=obj.corner_vertex.size();
+    int const N_vertex=obj.data_vertex.size();
+    int const N_texture=obj.data_texture.size();
+    int const N_normal=obj.data_normal.size();
 
-                    data_vertex.push_back(obj.data_vertex[idx_vertex]);
-                    data_texture.push_back(obj.data_texture[idx_texture]);
+    for(int k=0;k<N_corner;++k)
+    {
+        if(obj.corner_vertex[k]>=N_vertex)
+            throw exception_cpe("Incorrect vertex index ("+std::to_string(obj.corner_vertex[k]+1)+") in file "+filename,EXCEPTION_PARAMETERS_CPE);
+        if(obj.corner_texture[k]>=N_texture)
+            throw exception_cpe("Incorrect texture index ("+std::to_string(obj.corner_texture[k]+1)+") in file "+filename,EXCEPTION_PARAMETERS_CPE);
+        if(obj.corner_normal[k]>=N_normal)
+            throw exception_cpe("Incorrect normal index ("+std::to_string(obj.corner_normal[k]+1)+") in file "+filename,EXCEPTION_PARAMETERS_CPE);
+    }
 
-                    assert(static_cast<int>(data_vertex.size())==counter_max);
-                    assert(static_cast<int>(data_texture.size())==counter_max);
-                }
-            }
+    //the texture coordinates and the normals are only kept if they are given for every corner
+    auto const is_given = [](int const index){return index>=0;};
+    bool const is_texture=N_corner>0 && std::all_of(obj.corner_texture.begin(),obj.corner_texture.end(),is_given);
+    bool const is_normal=N_corner>0 && std::all_of(obj.corner_normal.begin(),obj.corner_normal.end(),is_given);
 
-            int const index_0=map_vertex[face_vertex[0]];
-            for(int k_dim=1;k_dim<dim-1;++k_dim)
-            {
-                int const index_1=map_vertex[face_vertex[k_dim]];
-                int const index_2=map_vertex[face_vertex[k_dim+1]];
-                mesh_loaded.add_triangle_index({index_0,index_1,index_2});
-            }
+    mesh mesh_loaded;
+    std::vector<int> corner_index(N_corner);
+
+    //positions only: the vertices of the file are kept in their order (indices of the file are valid in the mesh)
+    bool const position_only=!is_texture && !is_normal;
+    if(position_only)
+    {
+        for(int k=0;k<N_vertex;++k)
+            mesh_loaded.add_vertex(obj.data_vertex[k]);
+        corner_index=obj.corner_vertex;
+    }
+
+    //otherwise each distinct triplet of indices is a vertex of the mesh, in order of first use
+    obj_corner_table table(position_only? 0 : N_corner);
+    for(int k=0;k<N_corner && !position_only;++k)
+    {
+        int const v=obj.corner_vertex[k];
+        int const vt=is_texture? obj.corner_texture[k] : -1;
+        int const vn=is_normal? obj.corner_normal[k] : -1;
 
+        int const new_index=mesh_loaded.size_vertex();
+        int const index=table.find_or_insert(v,vt,vn,new_index);
+        if(index==new_index)
+        {
+            mesh_loaded.add_vertex(obj.data_vertex[v]);
+            if(is_texture)
+                mesh_loaded.add_texture_coord(obj.data_texture[vt]);
+            if(is_normal)
+                mesh_loaded.add_normal(normalized(obj.data_normal[vn]));
         }
+        corner_index[k]=index;
+    }
+
+    //polygons are triangulated as fans
+    int const N_face=obj.size_face();
+    for(int k_face=0;k_face<N_face;++k_face)
+    {
+        int const first=obj.face_offset[k_face];
+        int const last=obj.face_offset[k_face+1];
+        for(int k=first+1;k<last-1;++k)
+            mesh_loaded.add_triangle_index({corner_index[first],corner_index[k],corner_index[k+1]});
     }
 
     mesh_loaded.fill_empty_field_by_default();
@@ -279,4 +554,3 @@ mesh load_mesh_file_obj(const std::string& filename)
 }
 
 }
-
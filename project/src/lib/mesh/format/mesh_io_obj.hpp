@@ -22,6 +22,8 @@
 #define MESH_IO_OBJ_HPP
 
 #include <vector>
+#include <string>
+#include <cstddef>
 #include "../../3d/vec3.hpp"
 #include "../../3d/vec2.hpp"
 
@@ -30,38 +32,60 @@ namespace cpe
 
 class mesh;
 
-/** Load a mesh structure from a OFF file */
-mesh load_mesh_file_obj(std::string const& filename);
+/** Measures of the reading of an obj file */
+struct obj_load_report
+{
+    obj_load_report();
+
+    /** Loading throughput in MB/s (parsing and merging) */
+    double throughput() const;
+
+    std::size_t size_file;  //size of the file (bytes)
+    int N_chunk;            //number of chunks parsed in parallel
+    double time_parse;      //time to parse all the chunks (ms)
+    double time_merge;      //time to merge the chunks into a single structure (ms)
+};
+
+/** Load a mesh structure from a OBJ file.
+ *  With positions only, the vertices are the ones of the file in the same order.
+ *  Otherwise each distinct (vertex,texture,normal) triplet of the faces becomes a vertex of the mesh, in order of first use.
+ *  Identical vertices are not merged (see mesh_basic::weld_vertices).
+ *  The measures of the parsing are stored in the report if it is given. */
+mesh load_mesh_file_obj(std::string const& filename,obj_load_report* report=nullptr);
 
 
-/** An obj structure following the definition of an obj file */
+/** An obj structure following the definition of an obj file.
+ *  The faces are stored in flat arrays: the corners of the face k are the indices [face_offset[k],face_offset[k+1][ of the corner arrays.
+ *  The indices start at 0 (the relative negative indices of the file are already resolved).
+ *  The 'sk' lines (skinning weights of the vertices, extension of the format used by the skinned meshes) are stored in the same way. */
 struct obj_structure
 {
+    obj_structure();
+
+    /** Number of faces */
+    int size_face() const;
+    /** Number of 'sk' lines */
+    int size_skinning() const;
+
     std::vector<vec3> data_vertex;    //the coordinates of vertices
     std::vector<vec2> data_texture;   //the coordinates of textures (optional)
     std::vector<vec3> data_normal;    //the coordinates of normals (optional)
 
-    std::vector<std::vector<int>> data_face_vertex;  //the indices of the polygon of vertices
-    std::vector<std::vector<int>> data_face_texture; //the indices of the polygon of texture (optional)
-    std::vector<std::vector<int>> data_face_normal;  //the indices of the polygon of normal (optional)
-};
-
-/** Split a given string of face f from obj style into a set of values.
- *
- *  ex. 1/2 4/5 7/8 -> 1 2 4 5 7 8
- *      1/2/3 4/4/1 4/7/8 -> 1 2 3 4 4 1 4 7 8
- *      1//3 4//1 7//9 -> 1 3 4 1 7 9
- *      4 7 8 4 -> 4 7 8 4
- *
-*/
-std::vector<int> split_face_data(std::string const& face_data_str);
-
-/** Read an obj file and return an obj structure. */
-obj_structure load_file_obj_structure(std::string const& filename);
+    std::vector<int> face_offset;     //the index of the first corner of each face, followed by the total number of corners
+    std::vector<int> corner_vertex;   //the index of vertex of each corner
+    std::vector<int> corner_texture;  //the index of texture of each corner (-1 if not given)
+    std::vector<int> corner_normal;   //the index of normal of each corner (-1 if not given)
 
+    std::vector<int> skinning_offset; //the index of the first value of each 'sk' line, followed by the total number of values
+    std::vector<float> data_skinning; //the values of the 'sk' lines (pairs of joint index and weight)
+};
 
-void read_vertex_obj(std::stringstream& tokens,obj_structure& obj);
-void read_texture_obj(std::stringstream& tokens,obj_structure& obj);
+/** Read an obj file and return an obj structure.
+ *  The file is mapped in memory and split at line boundaries in chunks parsed in parallel, then merged in order:
+ *   the result is the same as a serial reading.
+ *  Unsupported keywords (groups, materials, etc) are ignored, an exception is thrown on malformed data.
+ *  The measures of the parsing are stored in the report if it is given. */
+obj_structure load_file_obj_structure(std::string const& filename,obj_load_report* report=nullptr);
 
 
 }
@@ -0,0 +1,629 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_io_ply.hpp"
+#include "../../common/error_handling.hpp"
+#include "../../common/mapped_file.hpp"
+#include "../../mesh/mesh.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <utility>
+
+namespace cpe
+{
+
+/** Description of a property in the header of a ply file */
+struct ply_header_property
+{
+    std::string name;
+    ply_type type;        //type of the values
+    bool is_list;         //the property is a list of values preceded by its size
+    ply_type size_type;   //type of the size of the list
+};
+
+/** Description of an element in the header of a ply file */
+struct ply_header_element
+{
+    std::string name;
+    std::size_t size;
+    std::vector<ply_header_property> property;
+};
+
+/** Destination of a value of a vertex property: data[stride*k_vertex]*scale */
+struct ply_vertex_target
+{
+    float* data;
+    int stride;
+    float scale;
+};
+
+/** Type of a given name (ex. "float" or "float32"), return false for an unknown name */
+static bool ply_type_from_name(std::string const& name,ply_type& type)
+{
+    static char const* const names[8][2] = {{"char","int8"},{"uchar","uint8"},{"short","int16"},{"ushort","uint16"},
+                                            {"int","int32"},{"uint","uint32"},{"float","float32"},{"double","float64"}};
+    for(int k=0 ; k<8 ; ++k)
+    {
+        if(name==names[k][0] || name==names[k][1])
+        {
+            type = static_cast<ply_type>(k);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Name of a type in the header of a ply file */
+static char const* ply_type_name(ply_type const type)
+{
+    static char const* const names[8] = {"char","uchar","short","ushort","int","uint","float","double"};
+    return names[static_cast<int>(type)];
+}
+
+/** Size of a type in a binary ply file (bytes) */
+static int ply_type_size(ply_type const type)
+{
+    static int const size[8] = {1,1,2,2,4,4,4,8};
+    return size[static_cast<int>(type)];
+}
+
+/** Check if a type stores integer values */
+static bool ply_type_is_integer(ply_type const type)
+{
+    return type!=ply_type::float32 && type!=ply_type::float64;
+}
+
+/** The binary format of the files is little endian: it is read and written without conversion */
+static bool is_little_endian_host()
+{
+    uint16_t const one = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte,&one,1);
+    return first_byte==1;
+}
+
+/** Read a binary value of the given type */
+static double read_binary_ply(char const* p,ply_type const type)
+{
+    switch(type)
+    {
+    case ply_type::int8:    {int8_t v;   std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::uint8:   {uint8_t v;  std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::int16:   {int16_t v;  std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::uint16:  {uint16_t v; std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::int32:   {int32_t v;  std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::uint32:  {uint32_t v; std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::float32: {float v;    std::memcpy(&v,p,sizeof(v)); return v;}
+    case ply_type::float64: {double v;   std::memcpy(&v,p,sizeof(v)); return v;}
+    }
+    return 0.0;
+}
+
+/** Write a value as a binary value of the given type (integer types are rounded) */
+static void write_binary_ply(char* p,ply_type const type,double const value)
+{
+    long long const i = ply_type_is_integer(type)? std::llround(value) : 0;
+    switch(type)
+    {
+    case ply_type::int8:    {int8_t v=i;     std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::uint8:   {uint8_t v=i;    std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::int16:   {int16_t v=i;    std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::uint16:  {uint16_t v=i;   std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::int32:   {int32_t v=i;    std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::uint32:  {uint32_t v=i;   std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::float32: {float v=value;  std::memcpy(p,&v,sizeof(v)); break;}
+    case ply_type::float64: {double v=value; std::memcpy(p,&v,sizeof(v)); break;}
+    }
+}
+
+/** Sequential reading of the values of a binary ply file */
+struct ply_binary_reader
+{
+    char const* current;
+    char const* end;
+
+    double read(ply_type const type)
+    {
+        int const size = ply_type_size(type);
+        if(end-current<size)
+            throw exception_cpe("Unexpected end of ply file",EXCEPTION_PARAMETERS_CPE);
+        double const value = read_binary_ply(current,type);
+        current += size;
+        return value;
+    }
+};
+
+/** Sequential reading of the values of an ascii ply file */
+struct ply_ascii_reader
+{
+    std::istringstream tokens;
+
+    double read(ply_type)
+    {
+        double value = 0.0;
+        if(!(tokens>>value))
+            throw exception_cpe("Missing or malformed value in ply file",EXCEPTION_PARAMETERS_CPE);
+        return value;
+    }
+};
+
+/** Read the header, return the position of the data following it */
+static std::size_t read_header_ply(char const* data,std::size_t const size,ply_format& format,std::vector<ply_header_element>& elements,std::string const& filename)
+{
+    bool is_format = false;
+    std::size_t position = 0;
+    int k_line = 0;
+    while(position<size)
+    {
+        char const* const line_begin = data+position;
+        char const* line_end = static_cast<char const*>(std::memchr(line_begin,'\n',size-position));
+        if(line_end==nullptr)
+            break;
+        position = line_end-data+1;
+        if(line_end>line_begin && line_end[-1]=='\r')
+            --line_end;
+
+        std::istringstream tokens(std::string(line_begin,line_end));
+        std::string keyword;
+        tokens >> keyword;
+
+        if(k_line++==0)
+        {
+            if(keyword!="ply")
+                throw exception_cpe("File "+filename+" is not a ply file",EXCEPTION_PARAMETERS_CPE);
+        }
+        else if(keyword=="format")
+        {
+            std::string name;
+            tokens >> name;
+            if(name=="ascii")
+                format = ply_format::ascii;
+            else if(name=="binary_little_endian")
+                format = ply_format::binary_little_endian;
+            else
+                throw exception_cpe("Unsupported ply format ("+name+") in file "+filename,EXCEPTION_PARAMETERS_CPE);
+            is_format = true;
+        }
+        else if(keyword=="element")
+        {
+            ply_header_element element;
+            long long N = -1;
+            tokens >> element.name >> N;
+            if(!tokens || N<0)
+                throw exception_cpe("Incorrect element in the header of file "+filename,EXCEPTION_PARAMETERS_CPE);
+            element.size = static_cast<std::size_t>(N);
+            elements.push_back(element);
+        }
+        else if(keyword=="property")
+        {
+            if(elements.size()==0)
+                throw exception_cpe("Property without element in the header of file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+            ply_header_property property;
+            std::string type_name;
+            tokens >> type_name;
+            property.is_list = type_name=="list";
+            property.size_type = ply_type::uint8;
+            bool is_valid = true;
+            if(property.is_list)
+            {
+                std::string size_type_name;
+                tokens >> size_type_name >> type_name;
+                is_valid = ply_type_from_name(size_type_name,property.size_type) && ply_type_is_integer(property.size_type);
+            }
+            tokens >> property.name;
+            is_valid = is_valid && ply_type_from_name(type_name,property.type) && !tokens.fail();
+            if(!is_valid)
+                throw exception_cpe("Incorrect property in the header of file "+filename,EXCEPTION_PARAMETERS_CPE);
+            elements.back().property.push_back(property);
+        }
+        else if(keyword=="end_header")
+        {
+            if(!is_format)
+                throw exception_cpe("Missing format in the header of file "+filename,EXCEPTION_PARAMETERS_CPE);
+            return position;
+        }
+        //comment and obj_info lines are ignored
+    }
+
+    throw exception_cpe("Cannot find the end of the header of file "+filename,EXCEPTION_PARAMETERS_CPE);
+}
+
+/** Index of a property of the element among the given names, -1 if none is found */
+static int find_property_ply(ply_header_element const& element,std::vector<std::string> const& names)
+{
+    for(std::string const& name : names)
+        for(int k=0 ; k<static_cast<int>(element.property.size()) ; ++k)
+            if(element.property[k].name==name && !element.property[k].is_list)
+                return k;
+    return -1;
+}
+
+/** Allocate the fields of the structure for the vertices and give the destination of each property of the vertex element */
+static std::vector<ply_vertex_target> prepare_vertex_ply(ply_header_element const& element,ply_structure& ply)
+{
+    std::size_t const N = element.size;
+    std::vector<ply_vertex_target> target(element.property.size(),{nullptr,0,1.0f});
+
+    //fields made of several properties: they are only stored if all of them are given
+    auto const prepare_field = [&](std::vector<std::vector<std::string>> const& names,float* const data,int const dim,float const integer_scale)
+    {
+        std::vector<int> index;
+        for(std::vector<std::string> const& component_names : names)
+            index.push_back(find_property_ply(element,component_names));
+        for(int const k : index)
+            if(k<0)
+                return false;
+        for(int d=0 ; d<dim ; ++d)
+        {
+            ply_header_property const& p = element.property[index[d]];
+            target[index[d]] = {data+d,dim,ply_type_is_integer(p.type)? integer_scale : 1.0f};
+        }
+        return true;
+    };
+
+    ply.data_vertex.resize(N);
+    if(!prepare_field({{"x"},{"y"},{"z"}},reinterpret_cast<float*>(ply.data_vertex.data()),3,1.0f))
+        throw exception_cpe("The vertices of a ply file must have x, y and z coordinates",EXCEPTION_PARAMETERS_CPE);
+
+    ply.data_normal.resize(N);
+    if(!prepare_field({{"nx"},{"ny"},{"nz"}},reinterpret_cast<float*>(ply.data_normal.data()),3,1.0f))
+        ply.data_normal.clear();
+
+    //integer colors are in [0,255]
+    ply.data_color.resize(N);
+    if(!prepare_field({{"red"},{"green"},{"blue"}},reinterpret_cast<float*>(ply.data_color.data()),3,1.0f/255.0f))
+        ply.data_color.clear();
+
+    ply.data_texture.resize(N);
+    if(!prepare_field({{"u","s","texture_u","texture_s"},{"v","t","texture_v","texture_t"}},reinterpret_cast<float*>(ply.data_texture.data()),2,1.0f))
+        ply.data_texture.clear();
+
+    //all the other scalar properties are kept as additional properties
+    std::size_t N_additional = 0;
+    for(std::size_t k=0 ; k<target.size() ; ++k)
+        N_additional += target[k].data==nullptr && !element.property[k].is_list;
+    ply.vertex_property.reserve(N_additional);
+    for(std::size_t k=0 ; k<target.size() ; ++k)
+    {
+        ply_header_property const& p = element.property[k];
+        if(target[k].data!=nullptr || p.is_list)
+            continue;
+        ply.vertex_property.push_back({p.name,p.type,std::vector<float>(N)});
+        target[k] = {ply.vertex_property.back().value.data(),1,1.0f};
+    }
+
+    return target;
+}
+
+/** Read all the values of an element, the properties with a target are stored */
+template <typename reader>
+static void read_element_sequential_ply(reader& r,ply_header_element const& element,std::vector<ply_vertex_target> const& target)
+{
+    int const N_property = element.property.size();
+    for(std::size_t k_element=0 ; k_element<element.size ; ++k_element)
+    {
+        for(int k=0 ; k<N_property ; ++k)
+        {
+            ply_header_property const& p = element.property[k];
+            if(p.is_list)
+            {
+                int const N_value = static_cast<int>(r.read(p.size_type));
+                for(int k_value=0 ; k_value<N_value ; ++k_value)
+                    r.read(p.type);
+            }
+            else
+            {
+                double const value = r.read(p.type);
+                if(k<static_cast<int>(target.size()) && target[k].data!=nullptr)
+                    target[k].data[target[k].stride*k_element] = static_cast<float>(value*target[k].scale);
+            }
+        }
+    }
+}
+
+/** Read the faces and split them into triangles */
+template <typename reader>
+static void read_face_ply(reader& r,ply_header_element const& element,ply_structure& ply,std::string const& filename)
+{
+    int k_index = -1;
+    for(int k=0 ; k<static_cast<int>(element.property.size()) ; ++k)
+        if(element.property[k].is_list && (element.property[k].name=="vertex_indices" || element.property[k].name=="vertex_index"))
+            k_index = k;
+    if(k_index<0)
+        throw exception_cpe("Cannot find the vertex indices of the faces in file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    int const N_vertex = ply.data_vertex.size();
+    int const N_property = element.property.size();
+    std::vector<int> polygon;
+    ply.data_triangle.reserve(ply.data_triangle.size()+element.size);
+    for(std::size_t k_face=0 ; k_face<element.size ; ++k_face)
+    {
+        for(int k=0 ; k<N_property ; ++k)
+        {
+            ply_header_property const& p = element.property[k];
+            int const N_value = p.is_list? static_cast<int>(r.read(p.size_type)) : 1;
+            if(k!=k_index)
+            {
+                for(int k_value=0 ; k_value<N_value ; ++k_value)
+                    r.read(p.type);
+                continue;
+            }
+
+            polygon.resize(N_value);
+            for(int& u : polygon)
+            {
+                u = static_cast<int>(r.read(p.type));
+                if(u<0 || u>=N_vertex)
+                    throw exception_cpe("Incorrect vertex index ("+std::to_string(u)+") in file "+filename,EXCEPTION_PARAMETERS_CPE);
+            }
+            for(int k_corner=1 ; k_corner+1<N_value ; ++k_corner)
+                ply.data_triangle.push_back(triangle_index(polygon[0],polygon[k_corner],polygon[k_corner+1]));
+        }
+    }
+}
+
+/** Read all the elements of the file */
+template <typename reader>
+static void read_elements_ply(reader& r,std::vector<ply_header_element> const& elements,ply_structure& ply,std::string const& filename)
+{
+    for(ply_header_element const& element : elements)
+    {
+        if(element.name=="vertex")
+            read_element_sequential_ply(r,element,prepare_vertex_ply(element,ply));
+        else if(element.name=="face")
+            read_face_ply(r,element,ply,filename);
+        else
+            read_element_sequential_ply(r,element,{});
+    }
+}
+
+/** Read the elements of a binary file. The elements without list have a fixed size:
+ *  the vertices are converted property by property over the whole block, and the other elements are skipped at once. */
+static void read_elements_binary_ply(ply_binary_reader& r,std::vector<ply_header_element> const& elements,ply_structure& ply,std::string const& filename)
+{
+    for(ply_header_element const& element : elements)
+    {
+        std::size_t stride = 0;
+        bool is_fixed_size = true;
+        for(ply_header_property const& p : element.property)
+        {
+            stride += ply_type_size(p.type);
+            is_fixed_size = is_fixed_size && !p.is_list;
+        }
+
+        if(element.name=="face")
+            read_face_ply(r,element,ply,filename);
+        else if(!is_fixed_size)
+        {
+            std::vector<ply_vertex_target> const target = element.name=="vertex"? prepare_vertex_ply(element,ply) : std::vector<ply_vertex_target>();
+            read_element_sequential_ply(r,element,target);
+        }
+        else
+        {
+            std::size_t const size_block = stride*element.size;
+            if(static_cast<std::size_t>(r.end-r.current)<size_block)
+                throw exception_cpe("Unexpected end of file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+            if(element.name=="vertex")
+            {
+                std::vector<ply_vertex_target> const target = prepare_vertex_ply(element,ply);
+                std::size_t offset = 0;
+                for(std::size_t k=0 ; k<element.property.size() ; ++k)
+                {
+                    ply_type const type = element.property[k].type;
+                    ply_vertex_target const& t = target[k];
+                    char const* value = r.current+offset;
+                    if(type==ply_type::float32 && t.scale==1.0f)
+                    {
+                        for(std::size_t k_vertex=0 ; k_vertex<element.size ; ++k_vertex, value+=stride)
+                            std::memcpy(t.data+t.stride*k_vertex,value,sizeof(float));
+                    }
+                    else
+                    {
+                        for(std::size_t k_vertex=0 ; k_vertex<element.size ; ++k_vertex, value+=stride)
+                            t.data[t.stride*k_vertex] = static_cast<float>(read_binary_ply(value,type)*t.scale);
+                    }
+                    offset += ply_type_size(type);
+                }
+            }
+            r.current += size_block;
+        }
+    }
+}
+
+ply_vertex_property const* ply_structure::find_vertex_property(std::string const& name) const
+{
+    for(ply_vertex_property const& p : vertex_property)
+        if(p.name==name)
+            return &p;
+    return nullptr;
+}
+
+ply_structure load_file_ply_structure(std::string const& filename)
+{
+    mapped_file const file(filename);
+
+    ply_format format = ply_format::ascii;
+    std::vector<ply_header_element> elements;
+    std::size_t const size_header = read_header_ply(file.data(),file.size(),format,elements,filename);
+
+    ply_structure ply;
+    if(format==ply_format::binary_little_endian)
+    {
+        if(!is_little_endian_host())
+            throw exception_cpe("Binary ply files can only be read on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+        ply_binary_reader r = {file.data()+size_header,file.data()+file.size()};
+        read_elements_binary_ply(r,elements,ply,filename);
+    }
+    else
+    {
+        ply_ascii_reader r;
+        r.tokens.str(std::string(file.data()+size_header,file.data()+file.size()));
+        read_elements_ply(r,elements,ply,filename);
+    }
+
+    return ply;
+}
+
+/** A property written in a ply file: its values are data[stride*k] */
+struct ply_output_property
+{
+    std::string name;
+    ply_type type;
+    float const* data;
+    int stride;
+};
+
+void save_file_ply_structure(std::string const& filename,ply_structure const& ply,ply_format const format)
+{
+    std::size_t const N_vertex = ply.data_vertex.size();
+    std::size_t const N_triangle = ply.data_triangle.size();
+    if(format==ply_format::binary_little_endian && !is_little_endian_host())
+        throw exception_cpe("Binary ply files can only be written on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    //the vertex properties, the optional fields are only written when they are complete
+    std::vector<ply_output_property> property;
+    auto const add_field = [&](std::vector<std::string> const& names,float const* data,std::size_t const size)
+    {
+        if(size!=N_vertex || N_vertex==0)
+            return;
+        for(int d=0 ; d<static_cast<int>(names.size()) ; ++d)
+            property.push_back({names[d],ply_type::float32,data+d,static_cast<int>(names.size())});
+    };
+    add_field({"x","y","z"},ply.data_vertex.size()>0? ply.data_vertex[0].pointer() : nullptr,ply.data_vertex.size());
+    add_field({"nx","ny","nz"},ply.data_normal.size()>0? ply.data_normal[0].pointer() : nullptr,ply.data_normal.size());
+    add_field({"red","green","blue"},ply.data_color.size()>0? ply.data_color[0].pointer() : nullptr,ply.data_color.size());
+    add_field({"u","v"},ply.data_texture.size()>0? ply.data_texture[0].pointer() : nullptr,ply.data_texture.size());
+    for(ply_vertex_property const& p : ply.vertex_property)
+    {
+        if(p.value.size()!=N_vertex)
+            throw exception_cpe("Property "+p.name+" must have one value per vertex",EXCEPTION_PARAMETERS_CPE);
+        if(N_vertex>0)
+            property.push_back({p.name,p.type,p.value.data(),1});
+    }
+
+    std::ofstream fid(filename.c_str(),std::ios::binary);
+    if(!fid.good())
+        throw exception_cpe("Cannot open file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    fid<<"ply"<<std::endl;
+    fid<<"format "<<(format==ply_format::ascii? "ascii" : "binary_little_endian")<<" 1.0"<<std::endl;
+    fid<<"element vertex "<<N_vertex<<std::endl;
+    for(ply_output_property const& p : property)
+        fid<<"property "<<ply_type_name(p.type)<<" "<<p.name<<std::endl;
+    fid<<"element face "<<N_triangle<<std::endl;
+    fid<<"property list uchar int vertex_indices"<<std::endl;
+    fid<<"end_header"<<std::endl;
+
+    if(format==ply_format::binary_little_endian)
+    {
+        //each element is written as a single block
+        std::size_t stride = 0;
+        for(ply_output_property const& p : property)
+            stride += ply_type_size(p.type);
+
+        std::vector<char> block(stride*N_vertex);
+        std::size_t offset = 0;
+        for(ply_output_property const& p : property)
+        {
+            for(std::size_t k=0 ; k<N_vertex ; ++k)
+                write_binary_ply(&block[stride*k+offset],p.type,p.data[p.stride*k]);
+            offset += ply_type_size(p.type);
+        }
+        fid.write(block.data(),block.size());
+
+        std::size_t const stride_face = 1+3*sizeof(int32_t);
+        block.resize(stride_face*N_triangle);
+        for(std::size_t k=0 ; k<N_triangle ; ++k)
+        {
+            char* const current = &block[stride_face*k];
+            current[0] = 3;
+            for(int d=0 ; d<3 ; ++d)
+                write_binary_ply(current+1+d*sizeof(int32_t),ply_type::int32,ply.data_triangle[k][d]);
+        }
+        fid.write(block.data(),block.size());
+    }
+    else
+    {
+        fid<<std::setprecision(9);
+        for(std::size_t k=0 ; k<N_vertex ; ++k)
+        {
+            for(std::size_t k_property=0 ; k_property<property.size() ; ++k_property)
+            {
+                ply_output_property const& p = property[k_property];
+                float const value = p.data[p.stride*k];
+                if(k_property>0)
+                    fid<<" ";
+                if(ply_type_is_integer(p.type))
+                    fid<<std::llround(value);
+                else
+                    fid<<value;
+            }
+            fid<<"\n";
+        }
+        for(triangle_index const& tri : ply.data_triangle)
+            fid<<"3 "<<tri.u0()<<" "<<tri.u1()<<" "<<tri.u2()<<"\n";
+    }
+
+    if(!fid.good())
+        throw exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+}
+
+ply_structure build_ply_structure(mesh const& m)
+{
+    ply_structure ply;
+    int const N_vertex = m.size_vertex();
+    for(int k=0 ; k<N_vertex ; ++k)
+        ply.data_vertex.push_back(m.vertex(k));
+    for(int k=0 ; k<m.size_normal() ; ++k)
+        ply.data_normal.push_back(m.normal(k));
+    for(int k=0 ; k<m.size_color() ; ++k)
+        ply.data_color.push_back(m.color(k));
+    for(int k=0 ; k<m.size_texture_coord() ; ++k)
+        ply.data_texture.push_back(m.texture_coord(k));
+    for(int k=0 ; k<m.size_connectivity() ; ++k)
+        ply.data_triangle.push_back(m.connectivity(k));
+    return ply;
+}
+
+mesh load_mesh_file_ply(std::string const& filename)
+{
+    ply_structure ply = load_file_ply_structure(filename);
+
+    mesh mesh_loaded;
+    mesh_loaded.assign(std::move(ply.data_vertex),std::move(ply.data_normal),std::move(ply.data_color),
+                       std::move(ply.data_texture),std::move(ply.data_triangle));
+
+    mesh_loaded.fill_empty_field_by_default();
+    ASSERT_CPE(mesh_loaded.valid_mesh(),"Mesh is invalid");
+
+    return mesh_loaded;
+}
+
+void save_mesh_file_ply(std::string const& filename,mesh const& m,ply_format const format)
+{
+    save_file_ply_structure(filename,build_ply_structure(m),format);
+}
+
+}
@@ -0,0 +1,80 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef MESH_IO_PLY_HPP
+#define MESH_IO_PLY_HPP
+
+#include <vector>
+#include <string>
+#include "../../3d/vec3.hpp"
+#include "../../3d/vec2.hpp"
+#include "../triangle_index.hpp"
+
+namespace cpe
+{
+
+class mesh;
+
+/** Encoding of the data of a ply file */
+enum class ply_format {ascii,binary_little_endian};
+
+/** Type of a property value in a ply file */
+enum class ply_type {int8,uint8,int16,uint16,int32,uint32,float32,float64};
+
+/** Per-vertex property of a ply file other than the position, normal, color and texture coordinates (ex. skinning weights) */
+struct ply_vertex_property
+{
+    std::string name;          //name of the property in the file
+    ply_type type;             //type of the property in the file
+    std::vector<float> value;  //one value per vertex
+};
+
+/** The content of a ply file: the vertex element and the faces (triangulated) */
+struct ply_structure
+{
+    std::vector<vec3> data_vertex;    //the coordinates of vertices (x,y,z)
+    std::vector<vec3> data_normal;    //the coordinates of normals (nx,ny,nz) (optional)
+    std::vector<vec3> data_color;     //the colors in [0,1] (red,green,blue) (optional)
+    std::vector<vec2> data_texture;   //the texture coordinates (u,v or s,t) (optional)
+    std::vector<triangle_index> data_triangle;  //the triangles (polygons are split in fans)
+
+    std::vector<ply_vertex_property> vertex_property;  //the other properties of the vertices
+
+    /** The additional vertex property of the given name, nullptr if it is not in the file */
+    ply_vertex_property const* find_vertex_property(std::string const& name) const;
+};
+
+/** Read a ply file (ascii or binary little endian).
+ *  In binary files, the vertices are read as a single block: each property is converted in one pass over the block. */
+ply_structure load_file_ply_structure(std::string const& filename);
+/** Write a ply file. The optional fields are only written if they have one value per vertex. */
+void save_file_ply_structure(std::string const& filename,ply_structure const& ply,ply_format format=ply_format::binary_little_endian);
+
+/** The data of a mesh as a ply structure (without additional property) */
+ply_structure build_ply_structure(mesh const& m);
+
+/** Load a mesh structure from a PLY file */
+mesh load_mesh_file_ply(std::string const& filename);
+/** Save a mesh structure in a PLY file */
+void save_mesh_file_ply(std::string const& filename,mesh const& m,ply_format format=ply_format::binary_little_endian);
+
+}
+
+#endif
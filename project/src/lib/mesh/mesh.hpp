@@ -54,6 +54,7 @@ public:
     void add_color(vec3 const& c);
     void add_texture_coord(vec2 const& t);
     void add_triangle_index(triangle_index const& idx);
+    using mesh_basic::assign;
 
     void load(std::string const& filename);
 
@@ -21,13 +21,31 @@
 #include "../common/error_handling.hpp"
 #include "../3d/mat3.hpp"
 #include "../3d/mat4.hpp"
+#include "mesh_vertex_cache.hpp"
+#include "mesh_weld.hpp"
+#include "mesh_transform.hpp"
+#include "mesh_statistics.hpp"
+#include "../common/parallel_for.hpp"
 #include <cmath>
+#include <algorithm>
+#include <atomic>
 
 namespace cpe
 {
 
+/** Source of the generations of all the meshes (0 is never given, it is used as "not computed") */
+static std::atomic<unsigned long long> generation_counter(1);
+
 mesh_basic::mesh_basic()
-    :vertex_data(),normal_data(),color_data(),texture_coord_data(),connectivity_data()
+    :vertex_data(),normal_data(),color_data(),texture_coord_data(),connectivity_data(),
+      generation_data(),generation_outdated(),statistics_cache(),statistics_cache_generation(),fill_normal_generation()
+{
+    generation_outdated.fill(true);
+    statistics_cache_generation.fill(0);
+    fill_normal_generation.fill(0);
+}
+
+mesh_basic::~mesh_basic()
 {}
 
 int mesh_basic::size_vertex() const {return vertex_data.size();}
@@ -48,6 +66,7 @@ vec3& mesh_basic::vertex(int const index)
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
     ASSERT_CPE(index<size_vertex(),"Index ("+std::to_string(index)+") must be less than the current size of the vertices ("+std::to_string(size_vertex())+")");
 
+    touch(mesh_attribute::vertex);
     return vertex_data[index];
 }
 
@@ -63,6 +82,7 @@ vec3& mesh_basic::normal(int const index)
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
     ASSERT_CPE(index<size_normal(),"Index ("+std::to_string(index)+") must be less than the current size of the normals ("+std::to_string(size_normal())+")");
 
+    touch(mesh_attribute::normal);
     return normal_data[index];
 }
 
@@ -78,6 +98,7 @@ vec3& mesh_basic::color(int const index)
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
     ASSERT_CPE(index<size_color(),"Index ("+std::to_string(index)+") must be less than the current size of the colors ("+std::to_string(size_color())+")");
 
+    touch(mesh_attribute::color);
     return color_data[index];
 }
 
@@ -93,6 +114,7 @@ vec2& mesh_basic::texture_coord(int const index)
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
     ASSERT_CPE(index<size_texture_coord(),"Index ("+std::to_string(index)+") must be less than the current size of the texture coordinates ("+std::to_string(size_texture_coord())+")");
 
+    touch(mesh_attribute::texture_coord);
     return texture_coord_data[index];
 }
 
@@ -108,32 +130,49 @@ triangle_index& mesh_basic::connectivity(int const index)
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
     ASSERT_CPE(index<size_connectivity(),"Index ("+std::to_string(index)+") must be less than the current size of the connectivity ("+std::to_string(size_connectivity())+")");
 
+    touch(mesh_attribute::connectivity);
     return connectivity_data[index];
 }
 
 void mesh_basic::add_vertex(vec3 const& v)
 {
     vertex_data.push_back(v);
+    touch(mesh_attribute::vertex);
 }
 
 void mesh_basic::add_normal(vec3 const& n)
 {
     normal_data.push_back(n);
+    touch(mesh_attribute::normal);
 }
 
 void mesh_basic::add_color(vec3 const& c)
 {
     color_data.push_back(c);
+    touch(mesh_attribute::color);
 }
 
 void mesh_basic::add_texture_coord(vec2 const& t)
 {
     texture_coord_data.push_back(t);
+    touch(mesh_attribute::texture_coord);
 }
 
 void mesh_basic::add_triangle_index(triangle_index const& idx)
 {
     connectivity_data.push_back(idx);
+    touch(mesh_attribute::connectivity);
+}
+
+void mesh_basic::assign(std::vector<vec3> vertices,std::vector<vec3> normals,std::vector<vec3> colors,
+                        std::vector<vec2> texture_coords,std::vector<triangle_index> connectivity)
+{
+    vertex_data.swap(vertices);
+    normal_data.swap(normals);
+    color_data.swap(colors);
+    texture_coord_data.swap(texture_coords);
+    connectivity_data.swap(connectivity);
+    touch_all();
 }
 
 
@@ -144,6 +183,7 @@ void mesh_basic::fill_color(vec3 const& c)
 
     for(auto& col : color_data)
         col=c;
+    touch(mesh_attribute::color);
 }
 
 void mesh_basic::fill_color_xyz()
@@ -168,10 +208,10 @@ void mesh_basic::fill_color_xyz()
     for(int k=0;k<N;++k)
     {
         //normalize the color (black at p_min, and white at p_max)
-        vec3 p=vertex(k)-p_min;
-        color(k) = vec3(p.x()/d.x(),p.y()/d.y(),p.z()/d.z());
+        vec3 p=vertex_data[k]-p_min;
+        color_data[k] = vec3(p.x()/d.x(),p.y()/d.y(),p.z()/d.z());
     }
-
+    touch(mesh_attribute::color);
 }
 
 void mesh_basic::fill_color_normal()
@@ -184,14 +224,23 @@ void mesh_basic::fill_color_normal()
     //fill the color value with c=|n|
     for(int k=0;k<N;++k)
     {
-        vec3 const& n=normal(k);
-        color(k) = vec3(std::abs(n.x()),std::abs(n.y()),std::abs(n.z()));
+        vec3 const& n=normal_data[k];
+        color_data[k] = vec3(std::abs(n.x()),std::abs(n.y()),std::abs(n.z()));
     }
+    touch(mesh_attribute::color);
 }
 
 void mesh_basic::fill_normal()
 {
     int const N_vertex=size_vertex();
+
+    //nothing to do if the vertices, the triangles and the normals did not change since the last call
+    std::array<unsigned long long,3> const current_generation = {{generation(mesh_attribute::vertex),
+                                                                   generation(mesh_attribute::connectivity),
+                                                                   generation(mesh_attribute::normal)}};
+    if(size_normal()==N_vertex && current_generation==fill_normal_generation)
+        return;
+
     if(size_normal()!=N_vertex)
         normal_data.resize(N_vertex);
 
@@ -204,7 +253,7 @@ void mesh_basic::fill_normal()
     for(int k_triangle=0;k_triangle<N_triangle;++k_triangle)
     {
         //get current triangle index
-        triangle_index const& tri=connectivity(k_triangle);
+        triangle_index const& tri=connectivity_data[k_triangle];
 
         //check that the index given have correct values
         ASSERT_CPE(tri.u0()>=0 && tri.u0()<N_vertex,"Incorrect triangle index");
@@ -212,9 +261,9 @@ void mesh_basic::fill_normal()
         ASSERT_CPE(tri.u2()>=0 && tri.u2()<N_vertex,"Incorrect triangle index");
 
         //compute current normal
-        vec3 const& p0=vertex(tri.u0());
-        vec3 const& p1=vertex(tri.u1());
-        vec3 const& p2=vertex(tri.u2());
+        vec3 const& p0=vertex_data[tri.u0()];
+        vec3 const& p1=vertex_data[tri.u1()];
+        vec3 const& p2=vertex_data[tri.u2()];
 
         vec3 const u1=normalized(p1-p0);
         vec3 const u2=normalized(p2-p0);
@@ -229,24 +278,62 @@ void mesh_basic::fill_normal()
     for(auto& n : normal_data)
         n=normalized(n);
 
+    touch(mesh_attribute::normal);
+    fill_normal_generation = {{current_generation[0],current_generation[1],generation(mesh_attribute::normal)}};
 }
 
 void mesh_basic::transform_opposite_normal_orientation()
 {
     for(auto& n : normal_data)
         n=-n;
+    touch(mesh_attribute::normal);
+}
+
+void mesh_basic::transform_apply(mat4 const& T)
+{
+    int const N_vertex = size_vertex();
+    int const N_normal = size_normal();
+    bool const is_normal = N_normal>0;
+    mat3 const normal_matrix = build_normal_matrix_affine(T);
+
+    //each chunk of vertices (and their normals) is transformed in a single pass by its own thread
+    parallel_for(N_vertex,[&](int const begin,int const end)
+    {
+        transform_positions_affine(&vertex_data[begin],end-begin,T);
+        if(is_normal)
+        {
+            int const end_normal = std::min(end,N_normal);
+            if(begin<end_normal)
+                transform_normals(&normal_data[begin],end_normal-begin,normal_matrix);
+        }
+    });
+
+    //normals without associated vertex (incomplete mesh)
+    if(N_normal>N_vertex)
+        transform_normals(&normal_data[N_vertex],N_normal-N_vertex,normal_matrix);
+
+    touch(mesh_attribute::vertex);
+    touch(mesh_attribute::normal);
 }
 
 void mesh_basic::transform_apply_matrix(mat3 const& T)
 {
-    for(auto& p : vertex_data)
-        p=T*p;
+    transform_apply(mat4(T));
 }
 
 void mesh_basic::transform_apply_matrix(mat4 const& T)
 {
+    bool const is_affine = T(3,0)==0.0f && T(3,1)==0.0f && T(3,2)==0.0f && T(3,3)==1.0f;
+    if(is_affine)
+    {
+        transform_apply(T);
+        return;
+    }
+
+    //projective transformation: the normals are not defined
     for(auto& p : vertex_data)
         p=T*p;
+    touch(mesh_attribute::vertex);
 }
 
 void mesh_basic::transform_apply_auto_scale_and_center()
@@ -257,130 +344,84 @@ void mesh_basic::transform_apply_auto_scale_and_center()
     vec3 const center=(corner_min+corner_max)/2;
     vec3 const d=corner_max-corner_min;
 
-    transform_apply_translation(-center);
+    //translation and scaling are applied in a single pass
     float const s=std::max(std::max(d.x(),d.y()),d.z());
+    mat4 T; T.set_translation(-center);
     if(s>1e-6f)
-        transform_apply_scale(1.0f/s);
+    {
+        mat4 S; S.set_scaling(1.0f/s);
+        T=S*T;
+    }
+    transform_apply(T);
 }
 
 void mesh_basic::transform_apply_scale(float const s)
 {
-    for(auto& p : vertex_data)
-        p=s*p;
+    mat4 S; S.set_scaling(s);
+    transform_apply(S);
 }
 
 void mesh_basic::transform_apply_scale(float const sx,float const sy,float const sz)
 {
-    for(vec3& p : vertex_data)
-    {
-        p.x()*=sx;
-        p.y()*=sy;
-        p.z()*=sz;
-    }
+    mat4 S; S.set_scaling(sx,sy,sz,1.0f);
+    transform_apply(S);
 }
 
 void mesh_basic::transform_apply_translation(vec3 const& t)
 {
-    for(vec3& p : vertex_data)
-        p+=t;
+    //the normals are not modified by a translation
+    mat4 T; T.set_translation(t);
+    parallel_for(size_vertex(),[&](int const begin,int const end)
+    {
+        transform_positions_affine(&vertex_data[begin],end-begin,T);
+    });
+    touch(mesh_attribute::vertex);
 }
 
 void mesh_basic::transform_apply_rotation(vec3 const& axis,float const angle)
 {
-    mat3 R;R.set_rotation(axis,angle);
-    for(vec3& p : vertex_data)
-        p=R*p;
+    mat4 R; R.set_rotation(axis,angle);
+    transform_apply(R);
 }
 
 bool mesh_basic::valid_mesh() const
 {
-    //mesh_basic should have at least one vertex
-    if(size_vertex()<=0)
-    {
-        std::cout<<"mesh_basic has 0 vertex"<<std::endl;
-        return false;
-    }
-    //mesh_basic should have at least one triangle
-    if(size_connectivity()<=0)
-    {
-        std::cout<<"Connectivity has size 0";
-        return false;
-    }
-
-    //mesh_basic should identical size for vertex, normal, color and texture_coord
-    if(size_vertex()!=size_normal())
-    {
-        std::cout<<"Normal size is different than vertex size"<<std::endl;
-        return false;
-    }
-    if(size_vertex()!=size_color())
-    {
-        std::cout<<"Normal size is different than color size"<<std::endl;
-        return false;
-    }
-    if(size_vertex()!=size_texture_coord())
-    {
-        std::cout<<"Normal size is different than texture_coord size"<<std::endl;
-        return false;
-    }
-
-    //vertices should not have too large coordinates
-    for(int k=0,N=size_vertex();k<N;++k)
-    {
-        vec3 const& p=vertex_data[k];
-        if(std::abs(p.x())>50000 || std::abs(p.y())>50000 || std::abs(p.z())>50000)
-        {
-            std::cout<<"Vertex "<<k<<" ("<<p<<") has very large size"<<std::endl;
-            return false;
-        }
-    }
+    return compute_statistics().valid;
+}
 
-    //normals should be normalized
-    for(int k=0,N=size_normal();k<N;++k)
-    {
-        vec3 const& n=normal_data[k];
-        if(std::abs(norm(n)-1.0f)>1e-6f)
-        {
-            std::cout<<"Normal "<<k<<"("<<n<<") is not normalized"<<std::endl;
-            return false;
-        }
-    }
+mesh_statistics mesh_basic::compute_statistics() const
+{
+    std::array<unsigned long long,mesh_attribute_count> current_generation;
+    for(int k=0 ; k<mesh_attribute_count ; ++k)
+        current_generation[k] = generation(static_cast<mesh_attribute>(k));
 
-    //color components should be in [0,1]
-    for(int k=0,N=size_color();k<N;++k)
+    if(current_generation!=statistics_cache_generation)
     {
-        vec3 const& c=color_data[k];
-        if(c.x()<0 || c.x()>1 || c.y()<0 || c.y()>1 || c.z()<0 || c.z()>1)
-        {
-            std::cout<<"Color "<<k<<"("<<c<<") has values outside [0,1]"<<std::endl;
-            return false;
-        }
+        statistics_cache = compute_mesh_statistics(vertex_data,normal_data,color_data,texture_coord_data,connectivity_data);
+        statistics_cache_generation = current_generation;
     }
+    return statistics_cache;
+}
 
-    //all triangle indices should be in the vertex list with non degenerated triangle
-    int const N_vertex=size_vertex();
-    for(int k=0,N=size_connectivity();k<N;++k)
+unsigned long long mesh_basic::generation(mesh_attribute const attribute) const
+{
+    int const k = static_cast<int>(attribute);
+    if(generation_outdated[k])
     {
-        triangle_index const& tri = connectivity_data[k];
-        int const u0=tri.u0();
-        int const u1=tri.u1();
-        int const u2=tri.u2();
-
-        if(u0==u1 || u0==u2 || u1==u2)
-        {
-            std::cout<<"Triangle index "<<k<<" ("<<tri<<") is degenerated"<<std::endl;
-            return false;
-        }
-
-        if(u0<0 || u1<0 || u2<0 || u0>=N_vertex || u1>=N_vertex || u2>=N_vertex)
-        {
-            std::cout<<"Triangle index "<<k<<" ("<<tri<<") has incorrect value with respect to the current vertex list of size "<<N_vertex<<std::endl;
-            return false;
-        }
+        generation_data[k] = generation_counter++;
+        generation_outdated[k] = false;
     }
+    return generation_data[k];
+}
 
-    return true;
+void mesh_basic::touch(mesh_attribute const attribute)
+{
+    generation_outdated[static_cast<int>(attribute)] = true;
+}
 
+void mesh_basic::touch_all()
+{
+    generation_outdated.fill(true);
 }
 
 float const* mesh_basic::pointer_vertex() const
@@ -423,28 +464,129 @@ void mesh_basic::fill_empty_field_by_default()
 
     if(size_texture_coord()!=N_vertex)
     {
-        texture_coord_data.clear();
-        for(int k=0;k<N_vertex;++k)
-            add_texture_coord({0.0f,0.0f});
+        texture_coord_data.assign(N_vertex,vec2(0.0f,0.0f));
+        touch(mesh_attribute::texture_coord);
     }
 
 }
 
-void mesh_basic::compute_mesh_aabb_extremities(vec3& corner_min,vec3& corner_max)
+void mesh_basic::compute_mesh_aabb_extremities(vec3& corner_min,vec3& corner_max) const
 {
-    int const N=size_vertex();
-    if(N==0) return ;
-    corner_min=vertex(0);
-    corner_max=vertex(0);
-    for(int k=1;k<N;++k)
+    if(size_vertex()==0) return ;
+
+    mesh_statistics const stats=compute_mesh_statistics(vertex_data,{},{},{},{});
+    corner_min=stats.corner_min;
+    corner_max=stats.corner_max;
+}
+
+void mesh_basic::optimize_vertex_cache(int const cache_size)
+{
+    int const N_vertex = size_vertex();
+    connectivity_data = optimize_triangle_order(connectivity_data,N_vertex,cache_size);
+
+    std::vector<int> const new_to_old = vertex_order_by_first_use(connectivity_data,N_vertex);
+    std::vector<int> old_to_new(N_vertex);
+    for(int k=0 ; k<N_vertex ; ++k)
+        old_to_new[new_to_old[k]] = k;
+    remap_vertices(new_to_old,old_to_new);
+}
+
+float mesh_basic::compute_acmr(int const cache_size) const
+{
+    return cpe::compute_acmr(connectivity_data,size_vertex(),cache_size);
+}
+
+int mesh_basic::weld_vertices(float const position_tolerance,float const attribute_tolerance)
+{
+    int const N_vertex = size_vertex();
+
+    auto const same_attributes = [&](int const k0,int const k1)
     {
-        vec3 const& p=vertex(k);
-        for(int k_dim=0;k_dim<3;++k_dim)
+        return same_vertex_attributes(k0,k1,attribute_tolerance);
+    };
+    std::vector<int> const merged_into = weld_positions(vertex_data,position_tolerance,same_attributes);
+
+    //the kept vertices stay in the same order
+    std::vector<int> new_to_old;
+    std::vector<int> old_to_new(N_vertex);
+    for(int k=0 ; k<N_vertex ; ++k)
+    {
+        if(merged_into[k]==k)
         {
-            if(p[k_dim]<corner_min[k_dim]) corner_min[k_dim]=p[k_dim];
-            if(p[k_dim]>corner_max[k_dim]) corner_max[k_dim]=p[k_dim];
+            old_to_new[k] = new_to_old.size();
+            new_to_old.push_back(k);
         }
+        else
+            old_to_new[k] = old_to_new[merged_into[k]];
+    }
+    remap_vertices(new_to_old,old_to_new);
+
+    //vertices merged with a tolerance may collapse some triangles
+    connectivity_data.erase(std::remove_if(connectivity_data.begin(),connectivity_data.end(),
+                                           [](triangle_index const& t){return t.u0()==t.u1() || t.u0()==t.u2() || t.u1()==t.u2();}),
+                            connectivity_data.end());
+    touch(mesh_attribute::connectivity);
+
+    return N_vertex-size_vertex();
+}
+
+std::size_t mesh_basic::size_memory() const
+{
+    return vertex_data.size()*sizeof(vec3) + normal_data.size()*sizeof(vec3) + color_data.size()*sizeof(vec3)
+         + texture_coord_data.size()*sizeof(vec2) + connectivity_data.size()*sizeof(triangle_index);
+}
+
+void mesh_basic::remap_vertices(std::vector<int> const& new_to_old,std::vector<int> const& old_to_new)
+{
+    int const N_vertex = size_vertex();
+    int const N_new = new_to_old.size();
+    ASSERT_CPE(int(old_to_new.size())==N_vertex,"Remapping must have one entry per vertex");
+    for(int const k_old : new_to_old)
+        ASSERT_CPE(k_old>=0 && k_old<N_vertex,"Incorrect vertex index in remapping ("+std::to_string(k_old)+")");
+    for(int const k_new : old_to_new)
+        ASSERT_CPE(k_new>=0 && k_new<N_new,"Incorrect new vertex index in remapping ("+std::to_string(k_new)+")");
+
+    ASSERT_CPE(size_normal()==0 || size_normal()==N_vertex,"Normal size is different than vertex size");
+    ASSERT_CPE(size_color()==0 || size_color()==N_vertex,"Color size is different than vertex size");
+    ASSERT_CPE(size_texture_coord()==0 || size_texture_coord()==N_vertex,"Texture coordinates size is different than vertex size");
+
+    remap_vector(vertex_data,new_to_old);
+    remap_vector(normal_data,new_to_old);
+    remap_vector(color_data,new_to_old);
+    remap_vector(texture_coord_data,new_to_old);
+
+    for(triangle_index& tri : connectivity_data)
+        for(int& u : tri)
+            u = old_to_new[u];
+    touch_all();
+}
+
+bool mesh_basic::same_vertex_attributes(int const k0,int const k1,float const tolerance) const
+{
+    auto const close = [tolerance](float const a,float const b){return std::abs(a-b)<=tolerance;};
+
+    if(size_normal()==size_vertex())
+    {
+        vec3 const& n0 = normal_data[k0];
+        vec3 const& n1 = normal_data[k1];
+        if(!close(n0.x(),n1.x()) || !close(n0.y(),n1.y()) || !close(n0.z(),n1.z()))
+            return false;
     }
+    if(size_color()==size_vertex())
+    {
+        vec3 const& c0 = color_data[k0];
+        vec3 const& c1 = color_data[k1];
+        if(!close(c0.x(),c1.x()) || !close(c0.y(),c1.y()) || !close(c0.z(),c1.z()))
+            return false;
+    }
+    if(size_texture_coord()==size_vertex())
+    {
+        vec2 const& t0 = texture_coord_data[k0];
+        vec2 const& t1 = texture_coord_data[k1];
+        if(!close(t0.x(),t1.x()) || !close(t0.y(),t1.y()))
+            return false;
+    }
+    return true;
 }
 
 
@@ -24,8 +24,11 @@
 #include "../3d/vec3.hpp"
 #include "../3d/vec2.hpp"
 #include "triangle_index.hpp"
+#include "mesh_statistics.hpp"
 
 #include <vector>
+#include <array>
+#include <cstddef>
 
 
 namespace cpe
@@ -33,6 +36,11 @@ namespace cpe
 class mat3;
 class mat4;
 
+/** The data of a mesh tracked by a generation counter (see mesh_basic::generation) */
+enum class mesh_attribute {vertex=0,normal,color,texture_coord,connectivity};
+/** Number of values of mesh_attribute */
+int const mesh_attribute_count=5;
+
 /** Basic container for a triangular mesh structure.
  * Used as a parent class for other mesh classes.
  * The mesh contains:
@@ -40,12 +48,15 @@ class mat4;
  * - 1 normal per vertex
  * - 1 color (r,g,b) per vertex
  * - 1 texture coordinate (u,v) per vertex
+ * Each attribute has a generation number, renewed every time it may have been modified.
+ * The results derived from the data (statistics, normals, VBOs) are cached against these generations.
 */
 class mesh_basic
 {
 public:
 
     mesh_basic();
+    virtual ~mesh_basic();
 
     /******************************************/
     // Size
@@ -86,9 +97,13 @@ public:
 
     /** Inverse all the normals */
     void transform_opposite_normal_orientation();
-    /** Multiply all the vertices by the given matrix */
+    /** Apply an affine transformation to the vertices, and its normal matrix to the normals.
+     *  Done in a single vectorized pass, split over several threads for large meshes:
+     *   chained transformations should be multiplied beforehand and applied at once. */
+    void transform_apply(mat4 const& T);
+    /** Multiply all the vertices by the given matrix (and the normals by its normal matrix) */
     void transform_apply_matrix(mat3 const& T);
-    /** Multiply all the vertices by the given matrix */
+    /** Multiply all the vertices by the given matrix (and the normals by its normal matrix if the matrix is affine) */
     void transform_apply_matrix(mat4 const& T);
     /** Center the mesh around the origin and set its maximal size in x,y or z direction to 1. */
     void transform_apply_auto_scale_and_center();
@@ -101,6 +116,24 @@ public:
     /** Rotate the mesh */
     void transform_apply_rotation(vec3 const& axis,float angle);
 
+    /******************************************/
+    // Optimization
+    /******************************************/
+
+    /** Reorder the triangles for the post-transform vertex cache of the GPU, then the vertices by first use in the triangles.
+     *  All the per-vertex data are remapped consistently. The shape of the mesh is not modified. */
+    void optimize_vertex_cache(int cache_size=32);
+    /** Average Cache Miss Ratio of the current triangles order (vertices transformed per triangle with a FIFO cache) */
+    float compute_acmr(int cache_size=32) const;
+
+    /** Merge the duplicated vertices: same position (up to position_tolerance) and same attributes (up to attribute_tolerance).
+     *  The triangles are remapped to the remaining vertices, the ones degenerated by the merge are removed.
+     *  Returns the number of removed vertices. */
+    int weld_vertices(float position_tolerance=0.0f,float attribute_tolerance=0.0f);
+
+    /** Memory used by the mesh data (in bytes) */
+    virtual std::size_t size_memory() const;
+
     /******************************************/
     // Pointers
     /******************************************/
@@ -118,7 +151,19 @@ public:
 
 
 
+    /** Check that the mesh can be drawn (see mesh_statistics::error for the description of the problem) */
     bool valid_mesh() const;
+    /** Compute the bounding box, the centroid, the length of the normals and the validity of the data in a single parallel pass */
+    mesh_statistics compute_statistics() const;
+
+    /** Compute the two extremities of the Axis Aligned Bounding Box of the vertices */
+    void compute_mesh_aabb_extremities(vec3& corner_min,vec3& corner_max) const;
+
+    /** Generation of an attribute: unique among all the meshes, and renewed when the attribute may have been modified.
+     *  Two equal generations of the same attribute guarantee that it was not modified in between.
+     *  \note A reference obtained from a non-const accessor must not be kept: writing through it after the
+     *  generation has been read is not detected. */
+    unsigned long long generation(mesh_attribute attribute) const;
 
 protected:
 
@@ -140,8 +185,25 @@ protected:
     void add_texture_coord(vec2 const& t);
     void add_triangle_index(triangle_index const& idx);
 
-    /** Compute the two extremities of the Axis Aligned Bounding Box */
-    void compute_mesh_aabb_extremities(vec3& corner_min,vec3& corner_max);
+    /** Replace all the data of the mesh at once: the vectors are moved into the internal storage (no copy when called with std::move).
+     *  \note Derived classes storing additional per-vertex data should overload it and call the parent method. */
+    virtual void assign(std::vector<vec3> vertices,std::vector<vec3> normals,std::vector<vec3> colors,
+                        std::vector<vec2> texture_coords,std::vector<triangle_index> connectivity);
+
+    /** Reorder or select the per-vertex data: the new vertex k is the previous vertex new_to_old[k].
+     *  The triangles indices are updated using old_to_new (index of the new vertex replacing each previous one).
+     *  \note Derived classes storing additional per-vertex data should overload it and call the parent method. */
+    virtual void remap_vertices(std::vector<int> const& new_to_old,std::vector<int> const& old_to_new);
+
+    /** Check if two vertices have the same attributes (up to a tolerance on each component), the position is not compared.
+     *  \note Derived classes storing additional per-vertex data should overload it and call the parent method. */
+    virtual bool same_vertex_attributes(int k0,int k1,float tolerance) const;
+
+    /** Mark an attribute as modified: its generation is renewed.
+     *  \note Called by all the non-const accessors, and must be called after writing directly in the internal storage. */
+    void touch(mesh_attribute attribute);
+    /** Mark all the attributes as modified */
+    void touch_all();
 
 
 protected:
@@ -158,8 +220,38 @@ protected:
 
     /** Internal storage for the triangles indices */
     std::vector<triangle_index> connectivity_data;
+
+private:
+
+    /** Current generation of each attribute */
+    mutable std::array<unsigned long long,mesh_attribute_count> generation_data;
+    /** Attributes modified since their generation was last read: the new generation is only taken when it is read again,
+     *  so that modifying each vertex in a loop stays cheap */
+    mutable std::array<bool,mesh_attribute_count> generation_outdated;
+
+    /** Statistics of the last call to compute_statistics */
+    mutable mesh_statistics statistics_cache;
+    /** Generations of the attributes used to compute statistics_cache (0 if not computed) */
+    mutable std::array<unsigned long long,mesh_attribute_count> statistics_cache_generation;
+
+    /** Generations of the vertices, connectivity and normals after the last call to fill_normal (0 if not called) */
+    std::array<unsigned long long,3> fill_normal_generation;
 };
 
+/** Reorder a per-vertex vector: the new element k is the element new_to_old[k].
+ *  Empty vectors (fields not filled) are left unchanged. */
+template <typename T>
+void remap_vector(std::vector<T>& data,std::vector<int> const& new_to_old)
+{
+    if(data.size()==0)
+        return;
+    std::vector<T> remapped;
+    remapped.reserve(new_to_old.size());
+    for(int const k_old : new_to_old)
+        remapped.push_back(data[k_old]);
+    data.swap(remapped);
+}
+
 }
 
 
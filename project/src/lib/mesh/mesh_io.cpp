@@ -24,6 +24,7 @@
 
 #include "format/mesh_io_obj.hpp"
 #include "format/mesh_io_off.hpp"
+#include "format/mesh_io_ply.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -43,6 +44,8 @@ mesh load_mesh_file(std::string const& filename)
         return load_mesh_file_obj(filename);
     else if(filename.find(".off")!=std::string::npos || filename.find(".OFF")!=std::string::npos)
         return load_mesh_file_off(filename);
+    else if(filename.find(".ply")!=std::string::npos || filename.find(".PLY")!=std::string::npos)
+        return load_mesh_file_ply(filename);
     else
         throw cpe::exception_cpe("Unknown extension for mesh file "+filename,EXCEPTION_PARAMETERS_CPE);
 }
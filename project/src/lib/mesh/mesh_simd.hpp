@@ -0,0 +1,95 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_SIMD_HPP
+#define MESH_SIMD_HPP
+
+#include "../3d/vec3.hpp"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/** Helpers to process arrays of vec3 with SSE, 4 elements at a time (internal use of the mesh algorithms) */
+
+namespace cpe
+{
+
+static_assert(sizeof(vec3)==3*sizeof(float),"vec3 must be stored as 3 contiguous floats");
+
+#ifdef __SSE__
+
+/** Load 4 consecutive vec3 (12 floats) and transpose them in x,y,z registers */
+inline void load_soa(float const* p,__m128& x,__m128& y,__m128& z)
+{
+    __m128 const a = _mm_loadu_ps(p+0); //x0 y0 z0 x1
+    __m128 const b = _mm_loadu_ps(p+4); //y1 z1 x2 y2
+    __m128 const c = _mm_loadu_ps(p+8); //z2 x3 y3 z3
+
+    x = _mm_shuffle_ps(_mm_shuffle_ps(a,a,_MM_SHUFFLE(3,3,3,0)),_mm_shuffle_ps(b,c,_MM_SHUFFLE(1,1,2,2)),_MM_SHUFFLE(2,0,1,0));
+    y = _mm_shuffle_ps(_mm_shuffle_ps(a,b,_MM_SHUFFLE(0,0,1,1)),_mm_shuffle_ps(b,c,_MM_SHUFFLE(2,2,3,3)),_MM_SHUFFLE(2,0,2,0));
+    z = _mm_shuffle_ps(_mm_shuffle_ps(a,b,_MM_SHUFFLE(1,1,2,2)),_mm_shuffle_ps(c,c,_MM_SHUFFLE(3,3,0,0)),_MM_SHUFFLE(2,0,2,0));
+}
+
+/** Transpose x,y,z registers back to 4 consecutive vec3 and store them */
+inline void store_soa(float* p,__m128 const& x,__m128 const& y,__m128 const& z)
+{
+    __m128 const a = _mm_shuffle_ps(_mm_shuffle_ps(x,y,_MM_SHUFFLE(0,0,0,0)),_mm_shuffle_ps(z,x,_MM_SHUFFLE(1,1,0,0)),_MM_SHUFFLE(2,0,2,0));
+    __m128 const b = _mm_shuffle_ps(_mm_shuffle_ps(y,z,_MM_SHUFFLE(1,1,1,1)),_mm_shuffle_ps(x,y,_MM_SHUFFLE(2,2,2,2)),_MM_SHUFFLE(2,0,2,0));
+    __m128 const c = _mm_shuffle_ps(_mm_shuffle_ps(z,x,_MM_SHUFFLE(3,3,2,2)),_mm_shuffle_ps(y,z,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(2,0,2,0));
+
+    _mm_storeu_ps(p+0,a);
+    _mm_storeu_ps(p+4,b);
+    _mm_storeu_ps(p+8,c);
+}
+
+/** Smallest of the 4 values */
+inline float horizontal_min(__m128 const& v)
+{
+    __m128 const m = _mm_min_ps(v,_mm_movehl_ps(v,v));
+    return _mm_cvtss_f32(_mm_min_ss(m,_mm_shuffle_ps(m,m,_MM_SHUFFLE(1,1,1,1))));
+}
+
+/** Largest of the 4 values */
+inline float horizontal_max(__m128 const& v)
+{
+    __m128 const m = _mm_max_ps(v,_mm_movehl_ps(v,v));
+    return _mm_cvtss_f32(_mm_max_ss(m,_mm_shuffle_ps(m,m,_MM_SHUFFLE(1,1,1,1))));
+}
+
+/** Sum of the 4 values */
+inline float horizontal_sum(__m128 const& v)
+{
+    __m128 const s = _mm_add_ps(v,_mm_movehl_ps(v,v));
+    return _mm_cvtss_f32(_mm_add_ss(s,_mm_shuffle_ps(s,s,_MM_SHUFFLE(1,1,1,1))));
+}
+
+/** Absolute value of the 4 values */
+inline __m128 abs_ps(__m128 const& v)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f),v);
+}
+
+#endif
+
+}
+
+#endif
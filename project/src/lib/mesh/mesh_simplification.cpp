@@ -0,0 +1,286 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_simplification.hpp"
+
+#include "../common/error_handling.hpp"
+
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace cpe
+{
+
+/** Quadric error of a set of planes: symmetric 4x4 matrix stored as its 10 upper coefficients */
+struct simplification_quadric
+{
+    simplification_quadric() :q() {}
+    double q[10];
+};
+
+/** Quadric of the squared distance to the plane a*x+b*y+c*z+d=0, weighted by w */
+static simplification_quadric plane_quadric(vec3 const& n,double const d,double const w)
+{
+    double const a=n.x(),b=n.y(),c=n.z();
+    simplification_quadric Q;
+    double const coeff[10] = {a*a,a*b,a*c,a*d, b*b,b*c,b*d, c*c,c*d, d*d};
+    for(int k=0 ; k<10 ; ++k)
+        Q.q[k] = w*coeff[k];
+    return Q;
+}
+
+static simplification_quadric operator+(simplification_quadric const& Q0,simplification_quadric const& Q1)
+{
+    simplification_quadric Q;
+    for(int k=0 ; k<10 ; ++k)
+        Q.q[k] = Q0.q[k]+Q1.q[k];
+    return Q;
+}
+
+/** Evaluate the quadric error (sum of the weighted squared distances to the planes) at a position */
+static double evaluate(simplification_quadric const& Q,vec3 const& p)
+{
+    double const x=p.x(),y=p.y(),z=p.z();
+    double const* const q = Q.q;
+    return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+         + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+         + q[7]*z*z + 2*q[8]*z
+         + q[9];
+}
+
+/** A collapse of the vertex "from" into the vertex "to" waiting in the priority queue.
+ *  It is outdated if one of the two vertices was modified since (different stamps). */
+struct simplification_collapse
+{
+    float cost;
+    int from;
+    int to;
+    int stamp_from;
+    int stamp_to;
+
+    bool operator>(simplification_collapse const& other) const {return cost>other.cost;}
+};
+
+std::vector<triangle_index> simplify_quadric(std::vector<vec3> const& positions,
+                                             std::vector<triangle_index> const& triangles,
+                                             int const N_triangle_target,
+                                             std::vector<int>& collapsed_into,
+                                             collapse_cost_function const& additional_cost,
+                                             collapse_callback_function const& on_collapse)
+{
+    int const N_vertex = positions.size();
+    int const N_triangle = triangles.size();
+
+    std::vector<triangle_index> current = triangles;
+    std::vector<bool> triangle_alive(N_triangle,true);
+    int N_alive = N_triangle;
+
+    //triangles around each vertex (may contain dead triangles, filtered when used)
+    std::vector<std::vector<int>> vertex_triangles(N_vertex);
+    std::vector<simplification_quadric> quadrics(N_vertex);
+    for(int k_triangle=0 ; k_triangle<N_triangle ; ++k_triangle)
+    {
+        triangle_index const& tri = current[k_triangle];
+        for(int const u : tri)
+        {
+            ASSERT_CPE(u>=0 && u<N_vertex,"Incorrect triangle index");
+            vertex_triangles[u].push_back(k_triangle);
+        }
+
+        //quadric of the plane of the triangle weighted by its area
+        vec3 const& p0 = positions[tri.u0()];
+        vec3 n = cross(positions[tri.u1()]-p0,positions[tri.u2()]-p0);
+        float const double_area = norm(n);
+        if(double_area<=0.0f)
+            continue;
+        n /= double_area;
+        simplification_quadric const Q = plane_quadric(n,-dot(n,p0),double_area/2.0);
+        for(int const u : tri)
+            quadrics[u] = quadrics[u]+Q;
+    }
+
+    //neighbors of a vertex through its alive triangles
+    std::vector<int> neighbors_buffer;
+    auto const neighbors = [&](int const u,std::vector<int>& result)
+    {
+        result.clear();
+        for(int const k_triangle : vertex_triangles[u])
+            if(triangle_alive[k_triangle])
+                for(int const w : current[k_triangle])
+                    if(w!=u)
+                        result.push_back(w);
+        std::sort(result.begin(),result.end());
+        result.erase(std::unique(result.begin(),result.end()),result.end());
+    };
+
+    //a vertex is on the border if one of its edges belongs to a single triangle
+    std::vector<bool> border(N_vertex,false);
+    for(int u=0 ; u<N_vertex ; ++u)
+    {
+        neighbors_buffer.clear();
+        for(int const k_triangle : vertex_triangles[u])
+            for(int const w : current[k_triangle])
+                if(w!=u)
+                    neighbors_buffer.push_back(w);
+        std::sort(neighbors_buffer.begin(),neighbors_buffer.end());
+        for(int k=0,N=neighbors_buffer.size() ; k<N && !border[u] ; )
+        {
+            int k_end = k;
+            while(k_end<N && neighbors_buffer[k_end]==neighbors_buffer[k])
+                ++k_end;
+            if(k_end-k==1)
+                border[u] = true;
+            k = k_end;
+        }
+    }
+
+    std::vector<int> stamp(N_vertex,0);
+    std::priority_queue<simplification_collapse,std::vector<simplification_collapse>,std::greater<simplification_collapse>> queue;
+
+    auto const push_collapse = [&](int const from,int const to)
+    {
+        if(border[from])
+            return;
+        double cost = evaluate(quadrics[from]+quadrics[to],positions[to]);
+        if(additional_cost)
+            cost += additional_cost(from,to);
+        queue.push({static_cast<float>(cost),from,to,stamp[from],stamp[to]});
+    };
+    auto const push_vertex = [&](int const u)
+    {
+        std::vector<int> around;
+        neighbors(u,around);
+        for(int const w : around)
+        {
+            push_collapse(u,w);
+            push_collapse(w,u);
+        }
+    };
+
+    for(int u=0 ; u<N_vertex ; ++u)
+    {
+        neighbors(u,neighbors_buffer);
+        for(int const w : neighbors_buffer)
+            push_collapse(u,w);
+    }
+
+    //check that the collapse keeps a manifold mesh without flipped triangles
+    std::vector<int> neighbors_to;
+    auto const is_valid = [&](int const from,int const to)
+    {
+        neighbors(from,neighbors_buffer);
+        neighbors(to,neighbors_to);
+        std::vector<int> common;
+        std::set_intersection(neighbors_buffer.begin(),neighbors_buffer.end(),neighbors_to.begin(),neighbors_to.end(),std::back_inserter(common));
+        if(common.size()>2)
+            return false;
+
+        for(int const k_triangle : vertex_triangles[from])
+        {
+            triangle_index const& tri = current[k_triangle];
+            if(!triangle_alive[k_triangle] || tri.u0()==to || tri.u1()==to || tri.u2()==to)
+                continue;
+
+            vec3 p[3],q[3];
+            for(int k=0 ; k<3 ; ++k)
+            {
+                p[k] = positions[tri[k]];
+                q[k] = tri[k]==from ? positions[to] : p[k];
+            }
+            vec3 const n_before = cross(p[1]-p[0],p[2]-p[0]);
+            vec3 const n_after = cross(q[1]-q[0],q[2]-q[0]);
+            float const norm_before = norm(n_before);
+            float const norm_after = norm(n_after);
+            if(norm_after<=1e-6f*norm_before || dot(n_before,n_after)<0.2f*norm_before*norm_after)
+                return false;
+        }
+        return true;
+    };
+
+    collapsed_into.resize(N_vertex);
+    std::iota(collapsed_into.begin(),collapsed_into.end(),0);
+
+    while(N_alive>N_triangle_target && !queue.empty())
+    {
+        simplification_collapse const c = queue.top();
+        queue.pop();
+
+        int const from = c.from;
+        int const to = c.to;
+        if(c.stamp_from!=stamp[from] || c.stamp_to!=stamp[to] || collapsed_into[from]!=from || collapsed_into[to]!=to)
+            continue;
+        if(!is_valid(from,to))
+            continue;
+
+        //the triangles of the edge disappear, the others are attached to the remaining vertex
+        for(int const k_triangle : vertex_triangles[from])
+        {
+            if(!triangle_alive[k_triangle])
+                continue;
+            triangle_index& tri = current[k_triangle];
+            if(tri.u0()==to || tri.u1()==to || tri.u2()==to)
+            {
+                triangle_alive[k_triangle] = false;
+                --N_alive;
+            }
+            else
+            {
+                for(int& u : tri)
+                    if(u==from)
+                        u = to;
+                vertex_triangles[to].push_back(k_triangle);
+            }
+        }
+        vertex_triangles[from].clear();
+
+        std::vector<int>& around_to = vertex_triangles[to];
+        around_to.erase(std::remove_if(around_to.begin(),around_to.end(),[&](int const k){return !triangle_alive[k];}),around_to.end());
+
+        quadrics[to] = quadrics[to]+quadrics[from];
+        collapsed_into[from] = to;
+        ++stamp[from];
+        ++stamp[to];
+
+        if(on_collapse)
+            on_collapse(from,to);
+
+        push_vertex(to);
+    }
+
+    //follow the chains of collapses up to the remaining vertices
+    for(int u=0 ; u<N_vertex ; ++u)
+    {
+        int v = u;
+        while(collapsed_into[v]!=v)
+            v = collapsed_into[v];
+        collapsed_into[u] = v;
+    }
+
+    std::vector<triangle_index> simplified;
+    simplified.reserve(N_alive);
+    for(int k_triangle=0 ; k_triangle<N_triangle ; ++k_triangle)
+        if(triangle_alive[k_triangle])
+            simplified.push_back(current[k_triangle]);
+
+    return simplified;
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_SIMPLIFICATION_HPP
+#define MESH_SIMPLIFICATION_HPP
+
+#include "../3d/vec3.hpp"
+#include "triangle_index.hpp"
+
+#include <vector>
+#include <functional>
+
+namespace cpe
+{
+
+/** Additional cost of the collapse of the vertex "from" into the vertex "to" (ex. difference of attributes) */
+typedef std::function<float(int from,int to)> collapse_cost_function;
+/** Called after the collapse of the vertex "from" into the vertex "to" (ex. to merge attributes in "to") */
+typedef std::function<void(int from,int to)> collapse_callback_function;
+
+/** Simplify a triangular mesh using half-edge collapses ordered by the quadric error metric (Garland & Heckbert 1997).
+ *  A vertex is always collapsed into one of its neighbors: the remaining vertices keep their position and attributes.
+ *  Collapses flipping a triangle or breaking the manifold are rejected, and the vertices on the border
+ *   (including texture seams) are never removed.
+ *  \param positions The positions of the vertices.
+ *  \param triangles The triangles to simplify.
+ *  \param N_triangle_target The simplification stops when the number of triangles is less or equal to this value
+ *   (or when no valid collapse remains).
+ *  \param collapsed_into Filled with, for each vertex, the remaining vertex it was collapsed into (itself if it remains).
+ *  \return The triangles of the simplified mesh, indexing the initial vertices.
+*/
+std::vector<triangle_index> simplify_quadric(std::vector<vec3> const& positions,
+                                             std::vector<triangle_index> const& triangles,
+                                             int N_triangle_target,
+                                             std::vector<int>& collapsed_into,
+                                             collapse_cost_function const& additional_cost=nullptr,
+                                             collapse_callback_function const& on_collapse=nullptr);
+
+}
+
+#endif
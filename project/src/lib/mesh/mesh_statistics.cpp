@@ -0,0 +1,332 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_statistics.hpp"
+
+#include "mesh_simd.hpp"
+#include "../common/parallel_for.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <sstream>
+
+namespace cpe
+{
+
+/** Number of elements reduced together, fixed to keep the result independent of the number of threads */
+static int const statistics_block_size = 4096;
+/** Largest absolute value expected for a coordinate */
+static float const statistics_coordinate_max = 50000.0f;
+/** Tolerance on the length of the normals */
+static float const statistics_normal_tolerance = 1e-6f;
+
+mesh_statistics::mesh_statistics()
+    :corner_min(),corner_max(),centroid(),
+      normal_length_min(0.0f),normal_length_max(0.0f),
+      N_vertex_too_large(0),first_vertex_too_large(-1),
+      N_normal_not_normalized(0),first_normal_not_normalized(-1),
+      N_color_outside(0),first_color_outside(-1),
+      N_triangle_degenerated(0),first_triangle_degenerated(-1),
+      N_triangle_out_of_range(0),first_triangle_out_of_range(-1),
+      valid(false),error()
+{}
+
+/** Partial result of the reduction of one block */
+struct mesh_statistics_block
+{
+    mesh_statistics_block()
+        :stats(),sum_x(0.0),sum_y(0.0),sum_z(0.0)
+    {
+        float const inf = std::numeric_limits<float>::infinity();
+        stats.corner_min = vec3(inf,inf,inf);
+        stats.corner_max = vec3(-inf,-inf,-inf);
+        stats.normal_length_min = inf;
+        stats.normal_length_max = -inf;
+    }
+
+    mesh_statistics stats;
+    double sum_x,sum_y,sum_z;
+};
+
+/** Count an element found in the reduction, keeping the first index */
+static void count_element(int& N,int& first,int const index)
+{
+    if(first<0 || index<first)
+        first = index;
+    ++N;
+}
+
+/** Count the elements of a group of 4 given by the bits of a mask */
+static void count_mask(int& N,int& first,int const mask,int const index)
+{
+    for(int k=0 ; k<4 ; ++k)
+        if(mask & (1<<k))
+            count_element(N,first,index+k);
+}
+
+static void reduce_vertices(vec3 const* const p,int const begin,int const end,mesh_statistics_block& block)
+{
+    mesh_statistics& s = block.stats;
+    int k = begin;
+
+#ifdef __SSE__
+    float const* const data = reinterpret_cast<float const*>(p);
+    __m128 min_x = _mm_set1_ps(s.corner_min.x()), min_y = _mm_set1_ps(s.corner_min.y()), min_z = _mm_set1_ps(s.corner_min.z());
+    __m128 max_x = _mm_set1_ps(s.corner_max.x()), max_y = _mm_set1_ps(s.corner_max.y()), max_z = _mm_set1_ps(s.corner_max.z());
+    __m128 sum_x = _mm_setzero_ps(), sum_y = _mm_setzero_ps(), sum_z = _mm_setzero_ps();
+    __m128 const limit = _mm_set1_ps(statistics_coordinate_max);
+
+    for( ; k+4<=end ; k+=4)
+    {
+        __m128 x,y,z;
+        load_soa(data+3*k,x,y,z);
+
+        min_x = _mm_min_ps(min_x,x); min_y = _mm_min_ps(min_y,y); min_z = _mm_min_ps(min_z,z);
+        max_x = _mm_max_ps(max_x,x); max_y = _mm_max_ps(max_y,y); max_z = _mm_max_ps(max_z,z);
+        sum_x = _mm_add_ps(sum_x,x); sum_y = _mm_add_ps(sum_y,y); sum_z = _mm_add_ps(sum_z,z);
+
+        __m128 const too_large = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(abs_ps(x),limit),_mm_cmpgt_ps(abs_ps(y),limit)),_mm_cmpgt_ps(abs_ps(z),limit));
+        int const mask = _mm_movemask_ps(too_large);
+        if(mask!=0)
+            count_mask(s.N_vertex_too_large,s.first_vertex_too_large,mask,k);
+    }
+
+    s.corner_min = vec3(horizontal_min(min_x),horizontal_min(min_y),horizontal_min(min_z));
+    s.corner_max = vec3(horizontal_max(max_x),horizontal_max(max_y),horizontal_max(max_z));
+    block.sum_x += horizontal_sum(sum_x);
+    block.sum_y += horizontal_sum(sum_y);
+    block.sum_z += horizontal_sum(sum_z);
+#endif
+
+    for( ; k<end ; ++k)
+    {
+        vec3 const& q = p[k];
+        for(int k_dim=0 ; k_dim<3 ; ++k_dim)
+        {
+            s.corner_min[k_dim] = std::min(s.corner_min[k_dim],q[k_dim]);
+            s.corner_max[k_dim] = std::max(s.corner_max[k_dim],q[k_dim]);
+        }
+        block.sum_x += q.x(); block.sum_y += q.y(); block.sum_z += q.z();
+
+        if(std::abs(q.x())>statistics_coordinate_max || std::abs(q.y())>statistics_coordinate_max || std::abs(q.z())>statistics_coordinate_max)
+            count_element(s.N_vertex_too_large,s.first_vertex_too_large,k);
+    }
+}
+
+static void reduce_normals(vec3 const* const n,int const begin,int const end,mesh_statistics& s)
+{
+    int k = begin;
+
+#ifdef __SSE__
+    float const* const data = reinterpret_cast<float const*>(n);
+    __m128 length_min = _mm_set1_ps(s.normal_length_min);
+    __m128 length_max = _mm_set1_ps(s.normal_length_max);
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const tolerance = _mm_set1_ps(statistics_normal_tolerance);
+
+    for( ; k+4<=end ; k+=4)
+    {
+        __m128 x,y,z;
+        load_soa(data+3*k,x,y,z);
+
+        __m128 const length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x),_mm_mul_ps(y,y)),_mm_mul_ps(z,z)));
+        length_min = _mm_min_ps(length_min,length);
+        length_max = _mm_max_ps(length_max,length);
+
+        int const mask = _mm_movemask_ps(_mm_cmpgt_ps(abs_ps(_mm_sub_ps(length,one)),tolerance));
+        if(mask!=0)
+            count_mask(s.N_normal_not_normalized,s.first_normal_not_normalized,mask,k);
+    }
+
+    s.normal_length_min = horizontal_min(length_min);
+    s.normal_length_max = horizontal_max(length_max);
+#endif
+
+    for( ; k<end ; ++k)
+    {
+        float const length = norm(n[k]);
+        s.normal_length_min = std::min(s.normal_length_min,length);
+        s.normal_length_max = std::max(s.normal_length_max,length);
+        if(std::abs(length-1.0f)>statistics_normal_tolerance)
+            count_element(s.N_normal_not_normalized,s.first_normal_not_normalized,k);
+    }
+}
+
+static void reduce_colors(vec3 const* const c,int const begin,int const end,mesh_statistics& s)
+{
+    int k = begin;
+
+#ifdef __SSE__
+    float const* const data = reinterpret_cast<float const*>(c);
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.0f);
+
+    for( ; k+4<=end ; k+=4)
+    {
+        __m128 x,y,z;
+        load_soa(data+3*k,x,y,z);
+
+        __m128 const below = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(x,zero),_mm_cmplt_ps(y,zero)),_mm_cmplt_ps(z,zero));
+        __m128 const above = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(x,one),_mm_cmpgt_ps(y,one)),_mm_cmpgt_ps(z,one));
+        int const mask = _mm_movemask_ps(_mm_or_ps(below,above));
+        if(mask!=0)
+            count_mask(s.N_color_outside,s.first_color_outside,mask,k);
+    }
+#endif
+
+    for( ; k<end ; ++k)
+    {
+        vec3 const& q = c[k];
+        if(q.x()<0 || q.x()>1 || q.y()<0 || q.y()>1 || q.z()<0 || q.z()>1)
+            count_element(s.N_color_outside,s.first_color_outside,k);
+    }
+}
+
+static void reduce_triangles(triangle_index const* const t,int const begin,int const end,int const N_vertex,mesh_statistics& s)
+{
+    for(int k=begin ; k<end ; ++k)
+    {
+        int const u0=t[k].u0(), u1=t[k].u1(), u2=t[k].u2();
+        if(u0==u1 || u0==u2 || u1==u2)
+            count_element(s.N_triangle_degenerated,s.first_triangle_degenerated,k);
+        if(u0<0 || u1<0 || u2<0 || u0>=N_vertex || u1>=N_vertex || u2>=N_vertex)
+            count_element(s.N_triangle_out_of_range,s.first_triangle_out_of_range,k);
+    }
+}
+
+/** Merge the counter of a block into the total */
+static void merge_count(int& N,int& first,int const N_block,int const first_block)
+{
+    if(first_block>=0 && (first<0 || first_block<first))
+        first = first_block;
+    N += N_block;
+}
+
+/** Describe the first problem of the mesh, in the same order than the historical checks of valid_mesh */
+static std::string first_error(mesh_statistics const& s,
+                               std::vector<vec3> const& vertices,std::vector<vec3> const& normals,std::vector<vec3> const& colors,
+                               std::vector<vec2> const& texture_coords,std::vector<triangle_index> const& triangles)
+{
+    std::stringstream msg;
+    int const N_vertex = vertices.size();
+
+    if(N_vertex<=0)
+        msg<<"mesh_basic has 0 vertex";
+    else if(triangles.size()==0)
+        msg<<"Connectivity has size 0";
+    else if(int(normals.size())!=N_vertex)
+        msg<<"Normal size is different than vertex size";
+    else if(int(colors.size())!=N_vertex)
+        msg<<"Color size is different than vertex size";
+    else if(int(texture_coords.size())!=N_vertex)
+        msg<<"Texture coordinates size is different than vertex size";
+    else if(s.first_vertex_too_large>=0)
+        msg<<"Vertex "<<s.first_vertex_too_large<<" ("<<vertices[s.first_vertex_too_large]<<") has very large size";
+    else if(s.first_normal_not_normalized>=0)
+        msg<<"Normal "<<s.first_normal_not_normalized<<" ("<<normals[s.first_normal_not_normalized]<<") is not normalized";
+    else if(s.first_color_outside>=0)
+        msg<<"Color "<<s.first_color_outside<<" ("<<colors[s.first_color_outside]<<") has values outside [0,1]";
+    else if(s.first_triangle_degenerated>=0 && (s.first_triangle_out_of_range<0 || s.first_triangle_degenerated<=s.first_triangle_out_of_range))
+        msg<<"Triangle index "<<s.first_triangle_degenerated<<" ("<<triangles[s.first_triangle_degenerated]<<") is degenerated";
+    else if(s.first_triangle_out_of_range>=0)
+        msg<<"Triangle index "<<s.first_triangle_out_of_range<<" ("<<triangles[s.first_triangle_out_of_range]<<") has incorrect value with respect to the current vertex list of size "<<N_vertex;
+
+    return msg.str();
+}
+
+mesh_statistics compute_mesh_statistics(std::vector<vec3> const& vertices,
+                                        std::vector<vec3> const& normals,
+                                        std::vector<vec3> const& colors,
+                                        std::vector<vec2> const& texture_coords,
+                                        std::vector<triangle_index> const& triangles)
+{
+    int const N_vertex = vertices.size();
+    int const N_normal = normals.size();
+    int const N_color = colors.size();
+    int const N_triangle = triangles.size();
+
+    int const N_element = std::max(std::max(N_vertex,N_normal),std::max(N_color,N_triangle));
+    int const N_block = (N_element+statistics_block_size-1)/statistics_block_size;
+
+    //each block reduces the same range of all the arrays in a single pass
+    std::vector<mesh_statistics_block> blocks(N_block);
+    parallel_for(N_block,[&](int const block_begin,int const block_end)
+    {
+        for(int k_block=block_begin ; k_block<block_end ; ++k_block)
+        {
+            int const begin = k_block*statistics_block_size;
+            int const end = begin+statistics_block_size;
+            mesh_statistics_block& block = blocks[k_block];
+
+            if(begin<N_vertex)
+                reduce_vertices(&vertices[0],begin,std::min(end,N_vertex),block);
+            if(begin<N_normal)
+                reduce_normals(&normals[0],begin,std::min(end,N_normal),block.stats);
+            if(begin<N_color)
+                reduce_colors(&colors[0],begin,std::min(end,N_color),block.stats);
+            if(begin<N_triangle)
+                reduce_triangles(&triangles[0],begin,std::min(end,N_triangle),N_vertex,block.stats);
+        }
+    },4);
+
+    //merge the blocks in order
+    mesh_statistics_block total;
+    mesh_statistics& s = total.stats;
+    for(mesh_statistics_block const& block : blocks)
+    {
+        mesh_statistics const& b = block.stats;
+        for(int k_dim=0 ; k_dim<3 ; ++k_dim)
+        {
+            s.corner_min[k_dim] = std::min(s.corner_min[k_dim],b.corner_min[k_dim]);
+            s.corner_max[k_dim] = std::max(s.corner_max[k_dim],b.corner_max[k_dim]);
+        }
+        total.sum_x += block.sum_x;
+        total.sum_y += block.sum_y;
+        total.sum_z += block.sum_z;
+        s.normal_length_min = std::min(s.normal_length_min,b.normal_length_min);
+        s.normal_length_max = std::max(s.normal_length_max,b.normal_length_max);
+
+        merge_count(s.N_vertex_too_large,s.first_vertex_too_large,b.N_vertex_too_large,b.first_vertex_too_large);
+        merge_count(s.N_normal_not_normalized,s.first_normal_not_normalized,b.N_normal_not_normalized,b.first_normal_not_normalized);
+        merge_count(s.N_color_outside,s.first_color_outside,b.N_color_outside,b.first_color_outside);
+        merge_count(s.N_triangle_degenerated,s.first_triangle_degenerated,b.N_triangle_degenerated,b.first_triangle_degenerated);
+        merge_count(s.N_triangle_out_of_range,s.first_triangle_out_of_range,b.N_triangle_out_of_range,b.first_triangle_out_of_range);
+    }
+
+    //empty data have zero statistics
+    if(N_vertex>0)
+        s.centroid = vec3(total.sum_x/N_vertex,total.sum_y/N_vertex,total.sum_z/N_vertex);
+    else
+    {
+        s.corner_min = vec3();
+        s.corner_max = vec3();
+    }
+    if(N_normal==0)
+    {
+        s.normal_length_min = 0.0f;
+        s.normal_length_max = 0.0f;
+    }
+
+    s.error = first_error(s,vertices,normals,colors,texture_coords,triangles);
+    s.valid = s.error.empty();
+
+    return s;
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_STATISTICS_HPP
+#define MESH_STATISTICS_HPP
+
+#include "../3d/vec3.hpp"
+#include "../3d/vec2.hpp"
+#include "triangle_index.hpp"
+
+#include <vector>
+#include <string>
+
+namespace cpe
+{
+
+/** Summary of the content of a mesh, and validity of its data.
+ *  The "first_..." indices are -1 when no element is concerned. */
+struct mesh_statistics
+{
+    mesh_statistics();
+
+    /** Minimal corner of the Axis Aligned Bounding Box of the vertices */
+    vec3 corner_min;
+    /** Maximal corner of the Axis Aligned Bounding Box of the vertices */
+    vec3 corner_max;
+    /** Average position of the vertices */
+    vec3 centroid;
+
+    /** Smallest length of the normals */
+    float normal_length_min;
+    /** Largest length of the normals */
+    float normal_length_max;
+
+    /** Number of vertices having a coordinate too large (in absolute value) */
+    int N_vertex_too_large;
+    /** Index of the first such vertex */
+    int first_vertex_too_large;
+    /** Number of normals not normalized */
+    int N_normal_not_normalized;
+    /** Index of the first such normal */
+    int first_normal_not_normalized;
+    /** Number of colors with a component outside [0,1] */
+    int N_color_outside;
+    /** Index of the first such color */
+    int first_color_outside;
+    /** Number of triangles using twice the same vertex */
+    int N_triangle_degenerated;
+    /** Index of the first such triangle */
+    int first_triangle_degenerated;
+    /** Number of triangles with an index outside the vertices */
+    int N_triangle_out_of_range;
+    /** Index of the first such triangle */
+    int first_triangle_out_of_range;
+
+    /** True if the mesh can be drawn (same conditions than mesh_basic::valid_mesh) */
+    bool valid;
+    /** Description of the first problem found when the mesh is not valid */
+    std::string error;
+};
+
+/** Compute the statistics of the data of a mesh in a single parallel pass.
+ *  The data are split in blocks of fixed size reduced independently (with SSE when available),
+ *   and the blocks are merged in order: the result does not depend on the number of threads.
+ *  Empty vectors are skipped, the texture coordinates are only used to check their number.
+*/
+mesh_statistics compute_mesh_statistics(std::vector<vec3> const& vertices,
+                                        std::vector<vec3> const& normals,
+                                        std::vector<vec3> const& colors,
+                                        std::vector<vec2> const& texture_coords,
+                                        std::vector<triangle_index> const& triangles);
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_transform.hpp"
+
+#include "../3d/vec3.hpp"
+#include "../3d/mat3.hpp"
+#include "../3d/mat4.hpp"
+#include "mesh_simd.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cpe
+{
+
+void transform_positions_affine(vec3* const positions,int const N,mat4 const& T)
+{
+    int k = 0;
+
+#ifdef __SSE__
+    __m128 m[3][4];
+    for(int row=0 ; row<3 ; ++row)
+        for(int col=0 ; col<4 ; ++col)
+            m[row][col] = _mm_set1_ps(T(row,col));
+
+    float* const data = reinterpret_cast<float*>(positions);
+    for( ; k+4<=N ; k+=4)
+    {
+        __m128 x,y,z;
+        load_soa(data+3*k,x,y,z);
+
+        __m128 r[3];
+        for(int row=0 ; row<3 ; ++row)
+            r[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row][0],x),_mm_mul_ps(m[row][1],y)),
+                                _mm_add_ps(_mm_mul_ps(m[row][2],z),m[row][3]));
+
+        store_soa(data+3*k,r[0],r[1],r[2]);
+    }
+#endif
+
+    //remaining positions (or all of them without SSE)
+    for( ; k<N ; ++k)
+    {
+        vec3 const p = positions[k];
+        positions[k] = vec3(T(0,0)*p.x()+T(0,1)*p.y()+T(0,2)*p.z()+T(0,3),
+                            T(1,0)*p.x()+T(1,1)*p.y()+T(1,2)*p.z()+T(1,3),
+                            T(2,0)*p.x()+T(2,1)*p.y()+T(2,2)*p.z()+T(2,3));
+    }
+}
+
+void transform_normals(vec3* const normals,int const N,mat3 const& M)
+{
+    int k = 0;
+
+#ifdef __SSE__
+    __m128 m[3][3];
+    for(int row=0 ; row<3 ; ++row)
+        for(int col=0 ; col<3 ; ++col)
+            m[row][col] = _mm_set1_ps(M(row,col));
+    __m128 const epsilon = _mm_set1_ps(1e-12f);
+
+    float* const data = reinterpret_cast<float*>(normals);
+    for( ; k+4<=N ; k+=4)
+    {
+        __m128 x,y,z;
+        load_soa(data+3*k,x,y,z);
+
+        __m128 r[3];
+        for(int row=0 ; row<3 ; ++row)
+            r[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row][0],x),_mm_mul_ps(m[row][1],y)),_mm_mul_ps(m[row][2],z));
+
+        //exact square root and division: the normals must stay normalized to float precision
+        __m128 const norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0],r[0]),_mm_mul_ps(r[1],r[1])),_mm_mul_ps(r[2],r[2]));
+        __m128 const norm = _mm_sqrt_ps(_mm_max_ps(norm2,epsilon));
+
+        store_soa(data+3*k,_mm_div_ps(r[0],norm),_mm_div_ps(r[1],norm),_mm_div_ps(r[2],norm));
+    }
+#endif
+
+    for( ; k<N ; ++k)
+    {
+        vec3 const& n = normals[k];
+        vec3 const r(M(0,0)*n.x()+M(0,1)*n.y()+M(0,2)*n.z(),
+                     M(1,0)*n.x()+M(1,1)*n.y()+M(1,2)*n.z(),
+                     M(2,0)*n.x()+M(2,1)*n.y()+M(2,2)*n.z());
+        normals[k] = r/std::sqrt(std::max(dot(r,r),1e-12f));
+    }
+}
+
+mat3 build_normal_matrix_affine(mat4 const& T)
+{
+    //the normals are normalized after transformation: the cofactor matrix (det*inverse transpose) is enough,
+    // and stays defined for very small scalings
+    float const a=T(0,0),b=T(0,1),c=T(0,2);
+    float const d=T(1,0),e=T(1,1),f=T(1,2);
+    float const g=T(2,0),h=T(2,1),i=T(2,2);
+
+    mat3 const cofactor( e*i-f*h, -(d*i-f*g),  d*h-e*g,
+                       -(b*i-c*h),  a*i-c*g, -(a*h-b*g),
+                         b*f-c*e, -(a*f-c*d),  a*e-b*d);
+
+    //a transformation with negative determinant (mirror) keeps the orientation of the normals
+    float const det = a*(e*i-f*h)-b*(d*i-f*g)+c*(d*h-e*g);
+    return det<0.0f ? -1.0f*cofactor : cofactor;
+}
+
+}
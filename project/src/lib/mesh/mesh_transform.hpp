@@ -0,0 +1,45 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_TRANSFORM_HPP
+#define MESH_TRANSFORM_HPP
+
+namespace cpe
+{
+
+class vec3;
+class mat3;
+class mat4;
+
+/** Apply an affine transformation to N positions (the last row of T is assumed to be (0,0,0,1)).
+ *  Vectorized with SSE when available (4 positions at a time). */
+void transform_positions_affine(vec3* positions,int N,mat4 const& T);
+
+/** Multiply N normals by a matrix (usually the normal matrix, ie. the inverse transpose of the linear part of the transformation)
+ *  and normalize them. Vectorized with SSE when available (4 normals at a time). */
+void transform_normals(vec3* normals,int N,mat3 const& M);
+
+/** Normal matrix of an affine transformation: inverse transpose of its linear part, up to a positive factor */
+mat3 build_normal_matrix_affine(mat4 const& T);
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_vertex_cache.hpp"
+
+#include "../common/error_handling.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cpe
+{
+
+/** Score of a vertex for the Forsyth algorithm given its position in the LRU cache (-1 if not in the cache)
+ *  and its number of triangles not yet emitted */
+static float forsyth_vertex_score(int const cache_position,int const remaining_valence,int const cache_size)
+{
+    if(remaining_valence==0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if(cache_position>=0)
+    {
+        //the vertices of the last triangle get a fixed score: it is not desirable to reuse them immediately
+        if(cache_position<3)
+            score = 0.75f;
+        else
+        {
+            float const s = 1.0f-float(cache_position-3)/float(cache_size-3);
+            score = std::pow(s,1.5f);
+        }
+    }
+
+    //vertices with few remaining triangles are favored, to get rid of them
+    score += 2.0f/std::sqrt(float(remaining_valence));
+
+    return score;
+}
+
+std::vector<triangle_index> optimize_triangle_order(std::vector<triangle_index> const& triangles,int const N_vertex,int const cache_size)
+{
+    ASSERT_CPE(cache_size>3,"Cache size must be larger than 3");
+
+    int const N_triangle = triangles.size();
+    for(triangle_index const& tri : triangles)
+        for(int const u : tri)
+            ASSERT_CPE(u>=0 && u<N_vertex,"Incorrect triangle index");
+
+    //triangles adjacent to each vertex: vertex k is adjacent to adjacency[offset[k] , offset[k]+valence[k]]
+    //the triangles not yet emitted are kept at the beginning of this range
+    std::vector<int> valence(N_vertex,0);
+    for(triangle_index const& tri : triangles)
+        for(int const u : tri)
+            ++valence[u];
+
+    std::vector<int> offset(N_vertex+1,0);
+    for(int k=0 ; k<N_vertex ; ++k)
+        offset[k+1] = offset[k]+valence[k];
+
+    std::vector<int> adjacency(offset[N_vertex]);
+    {
+        std::vector<int> filled(N_vertex,0);
+        for(int k_triangle=0 ; k_triangle<N_triangle ; ++k_triangle)
+            for(int const u : triangles[k_triangle])
+                adjacency[offset[u]+filled[u]++] = k_triangle;
+    }
+
+    std::vector<int> cache_position(N_vertex,-1);
+    std::vector<float> vertex_score(N_vertex);
+    for(int k=0 ; k<N_vertex ; ++k)
+        vertex_score[k] = forsyth_vertex_score(-1,valence[k],cache_size);
+
+    std::vector<float> triangle_score(N_triangle);
+    std::vector<bool> emitted(N_triangle,false);
+    int best = -1;
+    for(int k_triangle=0 ; k_triangle<N_triangle ; ++k_triangle)
+    {
+        triangle_index const& tri = triangles[k_triangle];
+        triangle_score[k_triangle] = vertex_score[tri.u0()]+vertex_score[tri.u1()]+vertex_score[tri.u2()];
+        if(best<0 || triangle_score[k_triangle]>triangle_score[best])
+            best = k_triangle;
+    }
+
+    std::vector<triangle_index> ordered;
+    ordered.reserve(N_triangle);
+
+    //simulated LRU cache, the most recent vertex first (with room for the 3 vertices of the new triangle)
+    std::vector<int> cache;
+    std::vector<int> cache_next;
+    cache.reserve(cache_size+3);
+    cache_next.reserve(cache_size+3);
+
+    int first_not_emitted = 0;
+    while(best>=0)
+    {
+        triangle_index const& tri = triangles[best];
+        emitted[best] = true;
+        ordered.push_back(tri);
+
+        //remove the triangle from the adjacency of its vertices
+        for(int const u : tri)
+        {
+            int* const begin = &adjacency[offset[u]];
+            int* const end = begin+valence[u];
+            std::iter_swap(std::find(begin,end,best),end-1);
+            --valence[u];
+        }
+
+        //the vertices of the triangle are moved to the front of the cache
+        cache_next.assign(tri.begin(),tri.end());
+        for(int const u : cache)
+            if(u!=tri.u0() && u!=tri.u1() && u!=tri.u2())
+                cache_next.push_back(u);
+
+        //update the scores of the vertices in the cache (including the ones going out)
+        for(int k=0,N=cache_next.size() ; k<N ; ++k)
+        {
+            int const u = cache_next[k];
+            cache_position[u] = k<cache_size ? k : -1;
+            vertex_score[u] = forsyth_vertex_score(cache_position[u],valence[u],cache_size);
+        }
+
+        //the next triangle is the best one touching the cache
+        best = -1;
+        for(int const u : cache_next)
+        {
+            for(int k=offset[u],end=offset[u]+valence[u] ; k<end ; ++k)
+            {
+                int const k_triangle = adjacency[k];
+                triangle_index const& t = triangles[k_triangle];
+                triangle_score[k_triangle] = vertex_score[t.u0()]+vertex_score[t.u1()]+vertex_score[t.u2()];
+                if(best<0 || triangle_score[k_triangle]>triangle_score[best])
+                    best = k_triangle;
+            }
+        }
+
+        if(static_cast<int>(cache_next.size())>cache_size)
+            cache_next.resize(cache_size);
+        std::swap(cache,cache_next);
+
+        //nothing left around the cache: restart from any remaining triangle
+        if(best<0)
+        {
+            while(first_not_emitted<N_triangle && emitted[first_not_emitted])
+                ++first_not_emitted;
+            if(first_not_emitted<N_triangle)
+                best = first_not_emitted;
+        }
+    }
+
+    return ordered;
+}
+
+std::vector<int> vertex_order_by_first_use(std::vector<triangle_index> const& triangles,int const N_vertex)
+{
+    std::vector<bool> used(N_vertex,false);
+    std::vector<int> new_to_old;
+    new_to_old.reserve(N_vertex);
+
+    for(triangle_index const& tri : triangles)
+    {
+        for(int const u : tri)
+        {
+            ASSERT_CPE(u>=0 && u<N_vertex,"Incorrect triangle index");
+            if(!used[u])
+            {
+                used[u] = true;
+                new_to_old.push_back(u);
+            }
+        }
+    }
+
+    for(int k=0 ; k<N_vertex ; ++k)
+        if(!used[k])
+            new_to_old.push_back(k);
+
+    return new_to_old;
+}
+
+float compute_acmr(std::vector<triangle_index> const& triangles,int const N_vertex,int const cache_size)
+{
+    if(triangles.size()==0)
+        return 0.0f;
+
+    //a vertex is in the FIFO cache if less than cache_size vertices were transformed since its own transformation
+    std::vector<int> time_stamp(N_vertex,-cache_size-1);
+    int N_miss = 0;
+    for(triangle_index const& tri : triangles)
+    {
+        for(int const u : tri)
+        {
+            ASSERT_CPE(u>=0 && u<N_vertex,"Incorrect triangle index");
+            if(N_miss-time_stamp[u]>cache_size)
+            {
+                time_stamp[u] = N_miss;
+                ++N_miss;
+            }
+        }
+    }
+
+    return float(N_miss)/float(triangles.size());
+}
+
+}
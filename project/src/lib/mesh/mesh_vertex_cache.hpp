@@ -0,0 +1,50 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_VERTEX_CACHE_HPP
+#define MESH_VERTEX_CACHE_HPP
+
+#include "triangle_index.hpp"
+
+#include <vector>
+
+namespace cpe
+{
+
+/** Reorder the triangles to maximize the reuse of the post-transform vertex cache of the GPU.
+ *  Greedy algorithm of T. Forsyth (Linear-Speed Vertex Cache Optimisation, 2006) using a simulated LRU cache of the given size.
+ *  The indices of the triangles are not modified.
+*/
+std::vector<triangle_index> optimize_triangle_order(std::vector<triangle_index> const& triangles,int N_vertex,int cache_size=32);
+
+/** Give the order of the vertices by first use in the triangles: new_to_old[k_new] is the previous index of the vertex.
+ *  Vertices not referenced by any triangle are placed at the end, in their previous order.
+*/
+std::vector<int> vertex_order_by_first_use(std::vector<triangle_index> const& triangles,int N_vertex);
+
+/** Average Cache Miss Ratio: number of vertices transformed per triangle using a FIFO cache of the given size.
+ *  Lies in [0.5,3], 3 means that no vertex is ever reused.
+*/
+float compute_acmr(std::vector<triangle_index> const& triangles,int N_vertex,int cache_size=32);
+
+}
+
+#endif
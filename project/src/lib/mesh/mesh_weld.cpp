@@ -0,0 +1,127 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_weld.hpp"
+
+#include "../common/error_handling.hpp"
+
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace cpe
+{
+
+/** Hash key of a cell of the grid (21 bits per dimension) */
+static uint64_t cell_key(int64_t const x,int64_t const y,int64_t const z)
+{
+    uint64_t const mask = (1ull<<21)-1;
+    return (uint64_t(x)&mask) | ((uint64_t(y)&mask)<<21) | ((uint64_t(z)&mask)<<42);
+}
+
+/** Hash key of an exact position (-0 and +0 are the same value) */
+static uint64_t exact_key(vec3 const& p)
+{
+    uint64_t key = 14695981039346656037ull;
+    for(int k_dim=0 ; k_dim<3 ; ++k_dim)
+    {
+        float const value = p[k_dim]+0.0f;
+        uint32_t bits = 0;
+        std::memcpy(&bits,&value,sizeof(float));
+        key = (key^bits)*1099511628211ull;
+    }
+    return key;
+}
+
+std::vector<int> weld_positions(std::vector<vec3> const& positions,float const tolerance,weld_compare_function const& same_attributes)
+{
+    ASSERT_CPE(tolerance>=0.0f,"Tolerance must be positive");
+
+    int const N_vertex = positions.size();
+    std::vector<int> merged_into(N_vertex);
+
+    //kept vertices stored in the cells as linked lists: first vertex of each cell, and next vertex in the same cell
+    std::unordered_map<uint64_t,int> cell_first;
+    cell_first.reserve(N_vertex);
+    std::vector<int> cell_next(N_vertex,-1);
+
+    auto const find_in_cell = [&](uint64_t const key,int const k_vertex)
+    {
+        auto const it = cell_first.find(key);
+        if(it==cell_first.end())
+            return -1;
+        vec3 const& p = positions[k_vertex];
+        for(int k=it->second ; k>=0 ; k=cell_next[k])
+        {
+            vec3 const d = positions[k]-p;
+            bool const same_position = tolerance>0.0f ? dot(d,d)<=tolerance*tolerance : (d.x()==0.0f && d.y()==0.0f && d.z()==0.0f);
+            if(same_position && (!same_attributes || same_attributes(k,k_vertex)))
+                return k;
+        }
+        return -1;
+    };
+    auto const insert_in_cell = [&](uint64_t const key,int const k_vertex)
+    {
+        auto const it = cell_first.find(key);
+        if(it!=cell_first.end())
+        {
+            cell_next[k_vertex] = it->second;
+            it->second = k_vertex;
+        }
+        else
+            cell_first[key] = k_vertex;
+    };
+
+    for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+    {
+        vec3 const& p = positions[k_vertex];
+        int found = -1;
+        uint64_t key = 0;
+
+        if(tolerance>0.0f)
+        {
+            //cells of the size of the tolerance: the close vertices are in the 27 neighboring cells
+            int64_t const x = static_cast<int64_t>(std::floor(p.x()/tolerance));
+            int64_t const y = static_cast<int64_t>(std::floor(p.y()/tolerance));
+            int64_t const z = static_cast<int64_t>(std::floor(p.z()/tolerance));
+            for(int dx=-1 ; dx<=1 && found<0 ; ++dx)
+                for(int dy=-1 ; dy<=1 && found<0 ; ++dy)
+                    for(int dz=-1 ; dz<=1 && found<0 ; ++dz)
+                        found = find_in_cell(cell_key(x+dx,y+dy,z+dz),k_vertex);
+            key = cell_key(x,y,z);
+        }
+        else
+        {
+            key = exact_key(p);
+            found = find_in_cell(key,k_vertex);
+        }
+
+        if(found>=0)
+            merged_into[k_vertex] = found;
+        else
+        {
+            merged_into[k_vertex] = k_vertex;
+            insert_in_cell(key,k_vertex);
+        }
+    }
+
+    return merged_into;
+}
+
+}
@@ -0,0 +1,45 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_WELD_HPP
+#define MESH_WELD_HPP
+
+#include "../3d/vec3.hpp"
+
+#include <vector>
+#include <functional>
+
+namespace cpe
+{
+
+/** Check if two vertices (given their index) have the same attributes and can be merged */
+typedef std::function<bool(int k0,int k1)> weld_compare_function;
+
+/** Find the vertices to merge using a hash grid (expected linear time).
+ *  Two vertices are merged if their positions are distant of at most tolerance (exactly equal if tolerance is 0)
+ *   and if the compare function (when given) accepts them.
+ *  \return For each vertex, the index of the vertex it is merged into (the first one met, itself if it is kept).
+*/
+std::vector<int> weld_positions(std::vector<vec3> const& positions,float tolerance,weld_compare_function const& same_attributes=nullptr);
+
+}
+
+#endif
@@ -25,7 +25,7 @@ namespace cpe
 {
 
 axes_helper::axes_helper()
-    :vbo_data(0),shader_id_data(0)
+    :vbo_data(0),shader_id_data(0),uniform_camera_modelview_data(-1),uniform_camera_projection_data(-1)
 {}
 
 void axes_helper::init()
@@ -43,6 +43,8 @@ void axes_helper::init()
     //load shaders
     shader_id_data = read_shader("shaders/shader_axes.vert",
                                  "shaders/shader_axes.frag");
+    uniform_camera_modelview_data  = get_uni_loc(shader_id_data,"camera_modelview");
+    uniform_camera_projection_data = get_uni_loc(shader_id_data,"camera_projection");
 
     ASSERT_CPE(vbo_data==0,"VBO should have initial value 0");
     glGenBuffers(1,&vbo_data); PRINT_OPENGL_ERROR();
@@ -73,4 +75,14 @@ GLuint axes_helper::shader_id() const
     return shader_id_data;
 }
 
+GLint axes_helper::uniform_camera_modelview() const
+{
+    return uniform_camera_modelview_data;
+}
+
+GLint axes_helper::uniform_camera_projection() const
+{
+    return uniform_camera_projection_data;
+}
+
 }
@@ -40,6 +40,10 @@ public:
 
     /** The associated shader id */
     GLuint shader_id() const;
+    /** Location of the uniform camera_modelview of the shader */
+    GLint uniform_camera_modelview() const;
+    /** Location of the uniform camera_projection of the shader */
+    GLint uniform_camera_projection() const;
 
 private:
 
@@ -47,6 +51,9 @@ private:
     GLuint vbo_data;
     /** Storage of the Shader ID */
     GLuint shader_id_data;
+    /** Uniform locations resolved once after loading the shader */
+    GLint uniform_camera_modelview_data;
+    GLint uniform_camera_projection_data;
 
 };
 }
@@ -52,6 +52,68 @@ bool print_opengl_error(const char *file, int line)
   return ret_code;
 }
 
+/*****************************************************************************\
+ * opengl error check state                                                  *
+\*****************************************************************************/
+bool opengl_error_check_state = true;
+
+void set_opengl_error_check(bool const is_enabled)
+{
+  opengl_error_check_state = is_enabled;
+}
+
+/*****************************************************************************\
+ * opengl_debug_callback                                                     *
+\*****************************************************************************/
+static void GLAPIENTRY opengl_debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                             GLsizei length, const GLchar *message, const void *user_param)
+{
+  if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+    return;
+
+  std::string type_str = "message";
+  switch (type)
+  {
+  case GL_DEBUG_TYPE_ERROR:               type_str = "error";               break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: type_str = "deprecated behavior"; break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  type_str = "undefined behavior";  break;
+  case GL_DEBUG_TYPE_PERFORMANCE:         type_str = "performance";         break;
+  case GL_DEBUG_TYPE_PORTABILITY:         type_str = "portability";         break;
+  }
+
+  std::cerr << "OpenGL debug (" << type_str << "): " << message << std::endl;
+}
+
+/*****************************************************************************\
+ * setup_opengl_debug_output                                                 *
+\*****************************************************************************/
+void setup_opengl_debug_output()
+{
+  bool has_callback = false;
+
+  if (GLEW_KHR_debug)
+  {
+    glDebugMessageCallback(opengl_debug_callback, NULL);
+    glEnable(GL_DEBUG_OUTPUT);
+    // The callback replaces the check after every call: the error must be reported inside the faulty call
+    // (meaningful backtrace in a debugger), also in release builds.
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    has_callback = true;
+  }
+  else if (GLEW_ARB_debug_output)
+  {
+    glDebugMessageCallbackARB(opengl_debug_callback, NULL);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+    has_callback = true;
+  }
+
+  // The synchronous check is only needed when no callback reports the errors.
+  set_opengl_error_check(!has_callback);
+
+  if (char const *env = getenv("CPE_OPENGL_ERROR_CHECK"))
+    set_opengl_error_check(std::string(env) != "0");
+}
+
 /*****************************************************************************\
  * get_gl_version                                                            *
 \*****************************************************************************/
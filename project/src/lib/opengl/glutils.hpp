@@ -27,8 +27,15 @@
 #include <GL/gl.h>
 
 
-/** Macro indicating OpenGL errors (file and line) */
-#define PRINT_OPENGL_ERROR() print_opengl_error(__FILE__, __LINE__)
+/** Macro indicating OpenGL errors (file and line).
+ *  The synchronous check (glGetError) is only done when the full error check is enabled
+ *   (see set_opengl_error_check), otherwise errors are reported by the debug callback (KHR_debug) when available.
+ *  The check is compiled out in release (NDEBUG) builds, unless CPE_OPENGL_ERROR_CHECK is defined. */
+#if !defined(NDEBUG) || defined(CPE_OPENGL_ERROR_CHECK)
+#define PRINT_OPENGL_ERROR() ((void)(opengl_error_check_enabled() && print_opengl_error(__FILE__, __LINE__)))
+#else
+#define PRINT_OPENGL_ERROR() ((void)0)
+#endif
 
 
 /** Draw OpenGL Informations */
@@ -38,6 +45,22 @@ void print_opengl_info();
  *  Function called by the macro PRINT_OPENGL_ERROR */
 bool print_opengl_error(const char *file, int line);
 
+/** Enable/Disable the synchronous check of OpenGL errors after every call (PRINT_OPENGL_ERROR) */
+void set_opengl_error_check(bool is_enabled);
+
+/** Is the synchronous check of OpenGL errors enabled */
+inline bool opengl_error_check_enabled()
+{
+    extern bool opengl_error_check_state;
+    return opengl_error_check_state;
+}
+
+/** Setup the report of OpenGL errors once the context is created.
+ *  Use a synchronous KHR_debug (or ARB_debug_output) message callback when available,
+ *  otherwise fall back on the synchronous check after every call.
+ *  The environment variable CPE_OPENGL_ERROR_CHECK=1 (resp. 0) forces the full synchronous check on (resp. off). */
+void setup_opengl_debug_output();
+
 /** Returns the OpenGL Version */
 void get_gl_version(int *major, int *minor);
 
@@ -22,15 +22,93 @@
 #include "glutils.hpp"
 #include "../common/error_handling.hpp"
 
+#include <vector>
+#include <algorithm>
 
 
 namespace cpe
 {
 
-mesh_opengl::mesh_opengl()
-    :vbo_vertex(0),vbo_normal(0),vbo_color(0),vbo_texture(0),vbo_index(0),number_of_triangles(0)
+/** Number of floats of the interleaved attributes: [position (3) normal (3)] color (3) texture (2) */
+static int interleaved_stride(bool const with_position)
 {
+    return with_position? 11 : 5;
+}
+
+/** Maximal number of unmodified vertices sent again to merge two dirty ranges into a single upload:
+ *  a few hundred bytes cost less than another call to the driver */
+static int const update_max_gap = 32;
+
+/** Pack the attributes of the vertices [begin,end[ of the mesh into a single interleaved array.
+ *  The positions and the normals are omitted if position is nullptr (they have their own VBOs). */
+static void pack_interleaved(mesh_basic const& m,float const* position,int const begin,int const end,std::vector<float>& data)
+{
+    int const stride = interleaved_stride(position!=nullptr);
+    data.resize(stride*(end-begin));
+
+    float const* normal  = m.pointer_normal();
+    float const* color   = m.pointer_color();
+    float const* texture = m.pointer_texture_coord();
+
+    float* current = &data[0];
+    for(int k=begin;k<end;++k)
+    {
+        if(position!=nullptr)
+        {
+            *current++ = position[3*k+0];
+            *current++ = position[3*k+1];
+            *current++ = position[3*k+2];
+            *current++ = normal[3*k+0];
+            *current++ = normal[3*k+1];
+            *current++ = normal[3*k+2];
+        }
+        *current++ = color[3*k+0];
+        *current++ = color[3*k+1];
+        *current++ = color[3*k+2];
+        *current++ = texture[2*k+0];
+        *current++ = texture[2*k+1];
+    }
+}
+
+std::vector<vertex_range> coalesced(std::vector<vertex_range> const& ranges,int const N_vertex,int const max_gap)
+{
+    std::vector<vertex_range> sorted;
+    for(vertex_range r : ranges)
+    {
+        r.begin=std::max(r.begin,0);
+        r.end=std::min(r.end,N_vertex);
+        if(r.begin<r.end)
+            sorted.push_back(r);
+    }
+    std::sort(sorted.begin(),sorted.end(),[](vertex_range const& a,vertex_range const& b){return a.begin<b.begin;});
+
+    std::vector<vertex_range> merged;
+    for(vertex_range const& r : sorted)
+    {
+        if(merged.size()>0 && r.begin<=merged.back().end+max_gap)
+            merged.back().end=std::max(merged.back().end,r.end);
+        else
+            merged.push_back(r);
+    }
+    return merged;
+}
+
+long int mesh_opengl::bytes_uploaded_counter=0;
 
+long int mesh_opengl::bytes_uploaded()
+{
+    return bytes_uploaded_counter;
+}
+
+void mesh_opengl::reset_bytes_uploaded()
+{
+    bytes_uploaded_counter=0;
+}
+
+mesh_opengl::mesh_opengl(mesh_opengl_layout const layout_param)
+    :layout_data(layout_param),vao(0),vbo_vertex(0),vbo_normal(0),vbo_attribute(0),vbo_index(0),number_of_vertices(0),number_of_triangles(0),uploaded_generation()
+{
+    uploaded_generation.fill(0);
 }
 
 mesh_opengl::~mesh_opengl()
@@ -38,74 +116,168 @@ mesh_opengl::~mesh_opengl()
     delete_vbo();
 }
 
+mesh_opengl_layout mesh_opengl::layout() const
+{
+    return layout_data;
+}
 
+static_assert(mesh_attribute_count==5,"mesh_opengl::uploaded_generation must store one generation per mesh attribute");
+
+/** Current generations of all the attributes of a mesh */
+static std::array<unsigned long long,mesh_attribute_count> mesh_generation(mesh_basic const& m)
+{
+    std::array<unsigned long long,mesh_attribute_count> g;
+    for(int k=0 ; k<mesh_attribute_count ; ++k)
+        g[k] = m.generation(static_cast<mesh_attribute>(k));
+    return g;
+}
 
 void mesh_opengl::fill_vbo(mesh_basic const& m)
 {
-    if(m.valid_mesh()!=true)
-        throw cpe::exception_cpe("Mesh is considered as invalid, cannot fill vbo",EXCEPTION_PARAMETERS_CPE);
+    std::array<unsigned long long,mesh_attribute_count> const current_generation = mesh_generation(m);
+    if(vao!=0 && current_generation==uploaded_generation)
+        return;
+
+    fill_vbo(m,m.pointer_vertex());
+    uploaded_generation = current_generation;
+}
 
+void mesh_opengl::fill_vbo(mesh_basic const& m,float const* position)
+{
+    //the positions may not be the vertices of the mesh: the content of the VBOs is not tracked
+    uploaded_generation.fill(0);
+
+    mesh_statistics const stats=m.compute_statistics();
+    if(stats.valid!=true)
+        throw cpe::exception_cpe("Mesh is considered as invalid, cannot fill vbo: "+stats.error,EXCEPTION_PARAMETERS_CPE);
+
+    number_of_vertices=m.size_vertex();
     number_of_triangles=m.size_connectivity();
     if(number_of_triangles<=0)
         throw cpe::exception_cpe("incorrect number of triangles",MACRO_EXCEPTION_PARAMETER);
 
-    //create the new vbo
-    if(vbo_vertex==0)
-    {glGenBuffers(1,&vbo_vertex);PRINT_OPENGL_ERROR();}
-    ASSERT_CPE(vbo_vertex!=0,"Problem creation of VBO");
+    bool const dynamic_position = layout_data==mesh_opengl_layout::dynamic_position;
 
-    if(vbo_normal==0)
-    {glGenBuffers(1,&vbo_normal);PRINT_OPENGL_ERROR();}
-    ASSERT_CPE(vbo_normal!=0,"Problem creation of VBO");
+    //create the new vao and vbo
+    if(vao==0)
+    {glGenVertexArrays(1,&vao);PRINT_OPENGL_ERROR();}
+    ASSERT_CPE(vao!=0,"Problem creation of VAO");
 
-    if(vbo_color==0)
-    {glGenBuffers(1,&vbo_color);PRINT_OPENGL_ERROR();}
-    ASSERT_CPE(vbo_color!=0,"Problem creation of VBO");
+    if(vbo_attribute==0)
+    {glGenBuffers(1,&vbo_attribute);PRINT_OPENGL_ERROR();}
+    ASSERT_CPE(vbo_attribute!=0,"Problem creation of VBO");
 
-    if(vbo_texture==0)
-    {glGenBuffers(1,&vbo_texture);PRINT_OPENGL_ERROR();}
-    ASSERT_CPE(vbo_texture!=0,"Problem creation of VBO");
+    if(dynamic_position && vbo_vertex==0)
+    {glGenBuffers(1,&vbo_vertex);PRINT_OPENGL_ERROR();}
+    ASSERT_CPE(!dynamic_position || vbo_vertex!=0,"Problem creation of VBO");
+
+    if(dynamic_position && vbo_normal==0)
+    {glGenBuffers(1,&vbo_normal);PRINT_OPENGL_ERROR();}
+    ASSERT_CPE(!dynamic_position || vbo_normal!=0,"Problem creation of VBO");
 
     if(vbo_index==0)
     {glGenBuffers(1,&vbo_index);PRINT_OPENGL_ERROR();}
     ASSERT_CPE(vbo_index!=0,"Problem creation of VBO");
 
 
+    //the index buffer binding is part of the VAO state
+    glBindVertexArray(vao); PRINT_OPENGL_ERROR();
+
+    //VBO interleaved attributes
+    send_vbo_attribute(m,dynamic_position? nullptr : position,true);
+
+    GLsizei const stride=interleaved_stride(!dynamic_position)*sizeof(float);
+    int offset=0;
+    if(!dynamic_position)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY); PRINT_OPENGL_ERROR();
+        glVertexPointer(3, GL_FLOAT, stride, buffer_offset(offset)); PRINT_OPENGL_ERROR();
+        offset+=3*sizeof(float);
+
+        glEnableClientState(GL_NORMAL_ARRAY); PRINT_OPENGL_ERROR();
+        glNormalPointer(GL_FLOAT, stride, buffer_offset(offset)); PRINT_OPENGL_ERROR();
+        offset+=3*sizeof(float);
+    }
 
-    //VBO vertex
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_vertex); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_vertex))
-        throw cpe::exception_cpe("vbo_buffer incorrect",EXCEPTION_PARAMETERS_CPE);
-    glBufferData(GL_ARRAY_BUFFER,3*sizeof(float)*m.size_vertex(),m.pointer_vertex(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+    glEnableClientState(GL_COLOR_ARRAY); PRINT_OPENGL_ERROR();
+    glColorPointer(3,GL_FLOAT, stride, buffer_offset(offset)); PRINT_OPENGL_ERROR();
+    offset+=3*sizeof(float);
+
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY); PRINT_OPENGL_ERROR();
+    glTexCoordPointer(2,GL_FLOAT, stride, buffer_offset(offset)); PRINT_OPENGL_ERROR();
 
-    //VBO normal
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_normal); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_normal))
-        throw cpe::exception_cpe("vbo_normal incorrect",EXCEPTION_PARAMETERS_CPE);
-    glBufferData(GL_ARRAY_BUFFER,3*sizeof(float)*m.size_normal(),m.pointer_normal(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+    //VBO vertex and VBO normal
+    if(dynamic_position)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER,vbo_vertex); PRINT_OPENGL_ERROR();
+        glBufferData(GL_ARRAY_BUFFER,3*sizeof(float)*number_of_vertices,position,GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+        bytes_uploaded_counter+=3*sizeof(float)*number_of_vertices;
 
-    //VBO color
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_color); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_color))
-        throw cpe::exception_cpe("vbo_color incorrect",EXCEPTION_PARAMETERS_CPE);
-    glBufferData(GL_ARRAY_BUFFER,3*sizeof(float)*m.size_color(),m.pointer_color(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+        glEnableClientState(GL_VERTEX_ARRAY); PRINT_OPENGL_ERROR();
+        glVertexPointer(3, GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
 
-    //VBO texture
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_texture); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_texture))
-        throw cpe::exception_cpe("vbo_texture incorrect",EXCEPTION_PARAMETERS_CPE);
-    glBufferData(GL_ARRAY_BUFFER,2*sizeof(float)*m.size_texture_coord(),m.pointer_texture_coord(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+        glBindBuffer(GL_ARRAY_BUFFER,vbo_normal); PRINT_OPENGL_ERROR();
+        glBufferData(GL_ARRAY_BUFFER,3*sizeof(float)*number_of_vertices,m.pointer_normal(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+        bytes_uploaded_counter+=3*sizeof(float)*number_of_vertices;
+
+        glEnableClientState(GL_NORMAL_ARRAY); PRINT_OPENGL_ERROR();
+        glNormalPointer(GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
+    }
 
     //VBO index
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,vbo_index); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_index))
-        throw cpe::exception_cpe("vbo_index incorrect",EXCEPTION_PARAMETERS_CPE);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,3*sizeof(int)*m.size_connectivity(),m.pointer_triangle_index(),GL_DYNAMIC_DRAW); PRINT_OPENGL_ERROR();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,3*sizeof(int)*m.size_connectivity(),m.pointer_triangle_index(),GL_STATIC_DRAW); PRINT_OPENGL_ERROR();
+    bytes_uploaded_counter+=3*sizeof(int)*m.size_connectivity();
+
+    glBindVertexArray(0); PRINT_OPENGL_ERROR();
 
 }
 
+void mesh_opengl::send_vbo_attribute(mesh_basic const& m,float const* position,bool const allocate)
+{
+    ASSERT_CPE(static_cast<unsigned int>(m.size_vertex())==number_of_vertices,"Mesh size differs from the size of the VBO");
+
+    if(allocate)
+    {
+        std::vector<float> data;
+        pack_interleaved(m,position,0,number_of_vertices,data);
+
+        glBindBuffer(GL_ARRAY_BUFFER,vbo_attribute); PRINT_OPENGL_ERROR();
+        glBufferData(GL_ARRAY_BUFFER,sizeof(float)*data.size(),&data[0],GL_STATIC_DRAW); PRINT_OPENGL_ERROR();
+        bytes_uploaded_counter+=sizeof(float)*data.size();
+    }
+    else
+        send_vbo_attribute(m,position,0,number_of_vertices);
+}
+
+void mesh_opengl::send_vbo_attribute(mesh_basic const& m,float const* position,int const begin,int const end)
+{
+    ASSERT_CPE(static_cast<unsigned int>(m.size_vertex())==number_of_vertices,"Mesh size differs from the size of the VBO");
+    ASSERT_CPE(0<=begin && begin<end && end<=static_cast<int>(number_of_vertices),"Incorrect vertex range");
+
+    std::vector<float> data;
+    pack_interleaved(m,position,begin,end,data);
+
+    int const stride = interleaved_stride(position!=nullptr)*sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER,vbo_attribute); PRINT_OPENGL_ERROR();
+    glBufferSubData(GL_ARRAY_BUFFER,stride*begin,sizeof(float)*data.size(),&data[0]); PRINT_OPENGL_ERROR();
+    bytes_uploaded_counter+=sizeof(float)*data.size();
+}
+
+void mesh_opengl::send_vbo_dynamic(GLuint const vbo,float const* const values,int const begin,int const end)
+{
+    ASSERT_CPE(0<=begin && begin<end && end<=static_cast<int>(number_of_vertices),"Incorrect vertex range");
+
+    int const size = 3*sizeof(float)*(end-begin);
+    glBindBuffer(GL_ARRAY_BUFFER,vbo); PRINT_OPENGL_ERROR();
+    glBufferSubData(GL_ARRAY_BUFFER,3*sizeof(float)*begin,size,values+3*begin); PRINT_OPENGL_ERROR();
+    bytes_uploaded_counter+=size;
+}
+
 void mesh_opengl::delete_vbo()
 {
+    if(vao!=0)
+    {glDeleteVertexArrays(1,&vao); PRINT_OPENGL_ERROR();}
 
     if(vbo_vertex!=0)
     {glDeleteBuffers(1,&vbo_vertex); PRINT_OPENGL_ERROR();}
@@ -113,17 +285,18 @@ void mesh_opengl::delete_vbo()
     if(vbo_normal!=0)
     {glDeleteBuffers(1,&vbo_normal); PRINT_OPENGL_ERROR();}
 
-    if(vbo_color!=0)
-    {glDeleteBuffers(1,&vbo_color); PRINT_OPENGL_ERROR();}
-
-    if(vbo_texture!=0)
-    {glDeleteBuffers(1,&vbo_texture); PRINT_OPENGL_ERROR();}
-
+    if(vbo_attribute!=0)
+    {glDeleteBuffers(1,&vbo_attribute); PRINT_OPENGL_ERROR();}
 
     if(vbo_index!=0)
     {glDeleteBuffers(1,&vbo_index); PRINT_OPENGL_ERROR();}
 
-
+    vao=0;
+    uploaded_generation.fill(0);
+    vbo_vertex=0;
+    vbo_normal=0;
+    vbo_attribute=0;
+    vbo_index=0;
 }
 
 void mesh_opengl::draw() const
@@ -131,78 +304,134 @@ void mesh_opengl::draw() const
     if(number_of_triangles<=0)
         throw cpe::exception_cpe("Incorrect number of triangles",EXCEPTION_PARAMETERS_CPE);
 
-
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_vertex); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_vertex))
-        throw cpe::exception_cpe("vbo_vertex incorrect",EXCEPTION_PARAMETERS_CPE);
-    glEnableClientState(GL_VERTEX_ARRAY); PRINT_OPENGL_ERROR();
-    glVertexPointer(3, GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
-
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_normal); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_normal))
-        throw cpe::exception_cpe("vbo_normal incorrect",EXCEPTION_PARAMETERS_CPE);
-    glEnableClientState(GL_NORMAL_ARRAY); PRINT_OPENGL_ERROR();
-    glNormalPointer(GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
-
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_color); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_color))
-        throw cpe::exception_cpe("vbo_color incorrect",EXCEPTION_PARAMETERS_CPE);
-    glEnableClientState(GL_COLOR_ARRAY); PRINT_OPENGL_ERROR();
-    glColorPointer(3,GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
-
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_texture); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_texture))
-        throw cpe::exception_cpe("vbo_texture incorrect",EXCEPTION_PARAMETERS_CPE);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY); PRINT_OPENGL_ERROR();
-    glTexCoordPointer(2,GL_FLOAT, 0, 0); PRINT_OPENGL_ERROR();
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,vbo_index); PRINT_OPENGL_ERROR();
-    if(!glIsBuffer(vbo_index))
-        throw cpe::exception_cpe("vbo_index incorrect",EXCEPTION_PARAMETERS_CPE);
+    glBindVertexArray(vao); PRINT_OPENGL_ERROR();
     glDrawElements(GL_TRIANGLES, 3*number_of_triangles, GL_UNSIGNED_INT, 0); PRINT_OPENGL_ERROR();
+    glBindVertexArray(0); PRINT_OPENGL_ERROR();
+}
+
+void mesh_opengl::draw_instanced(int const N_instance) const
+{
+    if(number_of_triangles<=0)
+        throw cpe::exception_cpe("Incorrect number of triangles",EXCEPTION_PARAMETERS_CPE);
+    if(N_instance<=0)
+        return;
 
+    glBindVertexArray(vao); PRINT_OPENGL_ERROR();
+    glDrawElementsInstanced(GL_TRIANGLES, 3*number_of_triangles, GL_UNSIGNED_INT, 0, N_instance); PRINT_OPENGL_ERROR();
+    glBindVertexArray(0); PRINT_OPENGL_ERROR();
 }
 
 
 void mesh_opengl::update_vbo_vertex(mesh_basic const& m)
 {
-    //VBO vertex
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_vertex); PRINT_OPENGL_ERROR();
-    ASSERT_CPE(glIsBuffer(vbo_vertex),"vbo_buffer incorrect");
-
-    glBufferSubData(GL_ARRAY_BUFFER,0,3*sizeof(float)*m.size_vertex(),m.pointer_vertex()); PRINT_OPENGL_ERROR();
+    if(layout_data==mesh_opengl_layout::dynamic_position)
+        update_vbo_vertex(m,{{0,m.size_vertex()}});
+    else
+    {
+        uploaded_generation.fill(0);
+        send_vbo_attribute(m,m.pointer_vertex(),false);
+    }
 }
 
 void mesh_opengl::update_vbo_normal(mesh_basic const& m)
 {
-    //VBO vertex
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_normal); PRINT_OPENGL_ERROR();
-    ASSERT_CPE(glIsBuffer(vbo_normal),"vbo_buffer incorrect");
-
-    glBufferSubData(GL_ARRAY_BUFFER,0,3*sizeof(float)*m.size_normal(),m.pointer_normal()); PRINT_OPENGL_ERROR();
+    if(layout_data==mesh_opengl_layout::dynamic_position)
+        update_vbo_normal(m,{{0,m.size_vertex()}});
+    else
+    {
+        uploaded_generation.fill(0);
+        send_vbo_attribute(m,m.pointer_vertex(),false);
+    }
 }
 
 void mesh_opengl::update_vbo_color(mesh_basic const& m)
 {
-    //VBO vertex
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_color); PRINT_OPENGL_ERROR();
-    ASSERT_CPE(glIsBuffer(vbo_color),"vbo_buffer incorrect");
-
-    glBufferSubData(GL_ARRAY_BUFFER,0,3*sizeof(float)*m.size_color(),m.pointer_color()); PRINT_OPENGL_ERROR();
+    uploaded_generation.fill(0);
+    bool const dynamic_position = layout_data==mesh_opengl_layout::dynamic_position;
+    send_vbo_attribute(m,dynamic_position? nullptr : m.pointer_vertex(),false);
 }
 
 void mesh_opengl::update_vbo_texture(mesh_basic const& m)
 {
-    //VBO vertex
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_texture); PRINT_OPENGL_ERROR();
-    ASSERT_CPE(glIsBuffer(vbo_texture),"vbo_buffer incorrect");
+    uploaded_generation.fill(0);
+    bool const dynamic_position = layout_data==mesh_opengl_layout::dynamic_position;
+    send_vbo_attribute(m,dynamic_position? nullptr : m.pointer_vertex(),false);
+}
+
+void mesh_opengl::update_vbo_vertex(mesh_basic const& m,std::vector<vertex_range> const& dirty)
+{
+    uploaded_generation.fill(0);
+    ASSERT_CPE(static_cast<unsigned int>(m.size_vertex())==number_of_vertices,"Mesh size differs from the size of the VBO");
+
+    //one upload per coalesced range: the interleaved layout sends all the attributes of the range
+    bool const dynamic_position = layout_data==mesh_opengl_layout::dynamic_position;
+    for(vertex_range const& r : coalesced(dirty,number_of_vertices,update_max_gap))
+    {
+        if(dynamic_position)
+            send_vbo_dynamic(vbo_vertex,m.pointer_vertex(),r.begin,r.end);
+        else
+            send_vbo_attribute(m,m.pointer_vertex(),r.begin,r.end);
+    }
+}
+
+float* mesh_opengl::map_vbo_vertex(int const N_vertex)
+{
+    return map_vbo_dynamic(vbo_vertex,N_vertex);
+}
+
+bool mesh_opengl::unmap_vbo_vertex()
+{
+    return unmap_vbo_dynamic(vbo_vertex);
+}
 
-    glBufferSubData(GL_ARRAY_BUFFER,0,3*sizeof(float)*m.size_texture_coord(),m.pointer_texture_coord()); PRINT_OPENGL_ERROR();
+float* mesh_opengl::map_vbo_normal(int const N_vertex)
+{
+    return map_vbo_dynamic(vbo_normal,N_vertex);
 }
 
+bool mesh_opengl::unmap_vbo_normal()
+{
+    return unmap_vbo_dynamic(vbo_normal);
+}
 
+float* mesh_opengl::map_vbo_dynamic(GLuint const vbo,int const N_vertex)
+{
+    ASSERT_CPE(layout_data==mesh_opengl_layout::dynamic_position,"Only the dynamic_position layout has position and normal VBOs");
+    ASSERT_CPE(vbo!=0,"fill_vbo must be called before mapping the VBO");
+    ASSERT_CPE(static_cast<unsigned int>(N_vertex)==number_of_vertices,"Incorrect number of vertices for the VBO");
+    uploaded_generation.fill(0);
+
+    int const size = 3*sizeof(float)*number_of_vertices;
+    glBindBuffer(GL_ARRAY_BUFFER,vbo);                                                                 PRINT_OPENGL_ERROR();
+    void* const p = glMapBufferRange(GL_ARRAY_BUFFER,0,size,GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT); PRINT_OPENGL_ERROR();
+    if(p==nullptr)
+        throw cpe::exception_cpe("Cannot map vertex buffer",EXCEPTION_PARAMETERS_CPE);
+    bytes_uploaded_counter+=size;
+    return static_cast<float*>(p);
+}
 
+bool mesh_opengl::unmap_vbo_dynamic(GLuint const vbo)
+{
+    glBindBuffer(GL_ARRAY_BUFFER,vbo);                                                                 PRINT_OPENGL_ERROR();
+    GLboolean const valid = glUnmapBuffer(GL_ARRAY_BUFFER);                                            PRINT_OPENGL_ERROR();
+    return valid==GL_TRUE;
+}
 
+void mesh_opengl::update_vbo_normal(mesh_basic const& m,std::vector<vertex_range> const& dirty)
+{
+    uploaded_generation.fill(0);
+    ASSERT_CPE(static_cast<unsigned int>(m.size_vertex())==number_of_vertices,"Mesh size differs from the size of the VBO");
+
+    //one upload per coalesced range: the interleaved layout sends all the attributes of the range
+    bool const dynamic_position = layout_data==mesh_opengl_layout::dynamic_position;
+    for(vertex_range const& r : coalesced(dirty,number_of_vertices,update_max_gap))
+    {
+        if(dynamic_position)
+            send_vbo_dynamic(vbo_normal,m.pointer_normal(),r.begin,r.end);
+        else
+            send_vbo_attribute(m,m.pointer_vertex(),r.begin,r.end);
+    }
 }
 
+}
 
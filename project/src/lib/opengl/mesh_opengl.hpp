@@ -24,52 +24,140 @@
 #include "GL/glew.h"
 #include "GL/gl.h"
 
+#include <vector>
+#include <array>
+
 namespace cpe
 {
 
 class mesh_basic;
 
-/** Class to manipulate meshes to be drawn by opendGL */
+/** A range of consecutive vertices [begin,end[ */
+struct vertex_range
+{
+    /** Index of the first vertex of the range */
+    int begin;
+    /** Index following the last vertex of the range */
+    int end;
+};
+
+/** Sort the ranges and merge the ones that overlap, are contiguous, or are separated by at most max_gap vertices.
+ *  The ranges are clamped to [0,N_vertex[ and the empty ones are removed. */
+std::vector<vertex_range> coalesced(std::vector<vertex_range> const& ranges,int N_vertex,int max_gap=0);
+
+/** Organization of the vertex attributes in the VBOs of a mesh_opengl */
+enum class mesh_opengl_layout
+{
+    /** Position, normal, color and texture coordinates are interleaved in a single VBO */
+    interleaved,
+    /** Positions and normals are stored in their own VBOs (cheap to update at every frame),
+     *  color and texture coordinates are interleaved in a static VBO */
+    dynamic_position
+};
+
+/** Class to manipulate meshes to be drawn by opendGL.
+ *  The vertex attributes are stored in interleaved VBOs, and all the
+ *  attribute pointers are recorded once in a Vertex Array Object (VAO) in fill_vbo.
+ *  Drawing only needs to bind the VAO.
+*/
 class mesh_opengl
 {
 public:
 
-    mesh_opengl();
+    mesh_opengl(mesh_opengl_layout layout_param=mesh_opengl_layout::interleaved);
     ~mesh_opengl();
 
-    /** Send the mesh data to the VBO, setup all vbos*/
+    /** Send the mesh data to the VBO, setup all vbos and the vao.
+     *  Nothing is sent if the VBOs already store this mesh and none of its attributes was modified since (see mesh_basic::generation). */
     void fill_vbo(mesh_basic const& m);
     /** Ask the GPU to draw the data.
      *  fill_vbo must have been called previously */
     void draw() const;
+    /** Draw N_instance instances of the mesh in a single draw call (gl_InstanceID identifies the instance in the shader) */
+    void draw_instanced(int N_instance) const;
 
-    /** Update only the vertex on the GPU */
+    /** Update only the vertex on the GPU
+     *  \note Only the position VBO is sent with the dynamic_position layout, the full interleaved VBO otherwise
+     *   (a single upload of all the attributes is cheaper than one upload per vertex) */
     void update_vbo_vertex(mesh_basic const& m);
-    /** Update only the normal on the GPU */
+    /** Update only the normal on the GPU
+     *  \note Only the normal VBO is sent with the dynamic_position layout, the full interleaved VBO otherwise */
     void update_vbo_normal(mesh_basic const& m);
     /** Update only the color on the GPU */
     void update_vbo_color(mesh_basic const& m);
     /** Update only the texture on the GPU */
     void update_vbo_texture(mesh_basic const& m);
 
-private:
+    /** Update on the GPU only the vertices in the given ranges.
+     *  The ranges are coalesced (small gaps included) and each one is sent in a single upload: 12 bytes per vertex
+     *   with the dynamic_position layout, but all the interleaved attributes (44 bytes per vertex) otherwise. */
+    void update_vbo_vertex(mesh_basic const& m,std::vector<vertex_range> const& dirty);
+    /** Update on the GPU only the normals in the given ranges (same cost as update_vbo_vertex) */
+    void update_vbo_normal(mesh_basic const& m,std::vector<vertex_range> const& dirty);
+
+    /** Map the position VBO to write the N_vertex positions directly in the GPU buffer (dynamic_position layout only).
+     *  The previous positions are discarded: the GPU can still draw them while the new ones are written.
+     *  Return the 3*N_vertex floats to be written, unmap_vbo_vertex must be called before drawing. */
+    float* map_vbo_vertex(int N_vertex);
+    /** Unmap the position VBO after map_vbo_vertex.
+     *  Return false if the content of the buffer was lost while it was mapped (ex. change of screen mode): it must be written again. */
+    bool unmap_vbo_vertex();
+    /** Map the normal VBO to write the N_vertex normals directly in the GPU buffer (see map_vbo_vertex) */
+    float* map_vbo_normal(int N_vertex);
+    /** Unmap the normal VBO after map_vbo_normal (see unmap_vbo_vertex) */
+    bool unmap_vbo_normal();
+
+    /** Number of bytes sent to the GPU by all the mesh_opengl since the last reset (ex. per frame) */
+    static long int bytes_uploaded();
+    /** Reset the counter of bytes sent to the GPU */
+    static void reset_bytes_uploaded();
+
+    /** The layout of the vertex attributes */
+    mesh_opengl_layout layout() const;
+
+protected:
+
+    /** Send the mesh data to the VBO using the given array of positions instead of the vertices of the mesh */
+    void fill_vbo(mesh_basic const& m,float const* position);
+
+    /** Send the interleaved attributes of the mesh to the VBO (allocate it when needed) */
+    void send_vbo_attribute(mesh_basic const& m,float const* position,bool allocate);
+    /** Send the interleaved attributes of the vertices [begin,end[ of the mesh to the VBO */
+    void send_vbo_attribute(mesh_basic const& m,float const* position,int begin,int end);
+    /** Send the 3 floats of the vertices [begin,end[ to a VBO of the dynamic_position layout (positions or normals) */
+    void send_vbo_dynamic(GLuint vbo,float const* values,int begin,int end);
+    /** Map a VBO of the dynamic_position layout (positions or normals), see map_vbo_vertex */
+    float* map_vbo_dynamic(GLuint vbo,int N_vertex);
+    /** Unmap a VBO of the dynamic_position layout, see unmap_vbo_vertex */
+    bool unmap_vbo_dynamic(GLuint vbo);
 
     /** Helper function to delete the vbos */
     void delete_vbo();
 
-    /** VBO for the vertices */
+    /** Layout of the attributes */
+    mesh_opengl_layout layout_data;
+
+    /** VAO storing all the attribute pointers */
+    GLuint vao;
+    /** VBO for the positions (only used with the dynamic_position layout) */
     GLuint vbo_vertex;
-    /** VBO for the normals */
+    /** VBO for the normals (only used with the dynamic_position layout) */
     GLuint vbo_normal;
-    /** VBO for the colors */
-    GLuint vbo_color;
-    /** VBO for the texture coords */
-    GLuint vbo_texture;
+    /** VBO for the interleaved attributes */
+    GLuint vbo_attribute;
     /** VBO for the triangle index */
     GLuint vbo_index;
 
+    /** Store the number of vertices of the mesh */
+    unsigned int number_of_vertices;
     /** Store the number of triangles of the mesh */
     unsigned int number_of_triangles;
+
+    /** Generations of the attributes of the mesh stored in the VBOs (0 if unknown, ex. after a partial update) */
+    std::array<unsigned long long,5> uploaded_generation;
+
+    /** Counter of bytes sent to the GPU (shared by all the meshes) */
+    static long int bytes_uploaded_counter;
 };
 
 }
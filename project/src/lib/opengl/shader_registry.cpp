@@ -0,0 +1,291 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shader_registry.hpp"
+
+#include "glutils.hpp"
+#include "../common/error_handling.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <sys/stat.h>
+
+namespace cpe
+{
+
+/** Read the full content of a text file */
+static std::string read_file(std::string const& filename)
+{
+    std::ifstream fid(filename.c_str(),std::ios::binary);
+    if(!fid.good())
+        throw exception_cpe("Cannot load shader file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    std::stringstream content;
+    content << fid.rdbuf();
+    return content.str();
+}
+
+/** 64 bits FNV-1a hash of a string */
+static uint64_t hash_fnv1a(std::string const& data)
+{
+    uint64_t h = 14695981039346656037ull;
+    for(unsigned char const c : data)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/** Get an OpenGL string, empty if unavailable */
+static std::string gl_string(GLenum name)
+{
+    GLubyte const* const s = glGetString(name);
+    return s!=nullptr ? std::string(reinterpret_cast<char const*>(s)) : std::string();
+}
+
+/** Print the info log of a shader or a program if it is not empty */
+static void print_info_log(GLuint id,bool is_program,std::string const& title)
+{
+    GLint length = 0;
+    if(is_program)
+        glGetProgramiv(id,GL_INFO_LOG_LENGTH,&length);
+    else
+        glGetShaderiv(id,GL_INFO_LOG_LENGTH,&length);
+    PRINT_OPENGL_ERROR();
+
+    if(length<=1)
+        return;
+
+    std::string log(length,'\0');
+    if(is_program)
+        glGetProgramInfoLog(id,length,nullptr,&log[0]);
+    else
+        glGetShaderInfoLog(id,length,nullptr,&log[0]);
+    PRINT_OPENGL_ERROR();
+
+    std::cout<<title<<" InfoLog:"<<std::endl<<log<<std::endl;
+}
+
+/** Compile a shader of a given type, throw an exception on error */
+static GLuint compile_shader(GLenum type,std::string const& source,std::string const& filename)
+{
+    GLuint const shader = glCreateShader(type);                                    PRINT_OPENGL_ERROR();
+    char const* cstring = source.c_str();
+    glShaderSource(shader,1,&cstring,nullptr);                                     PRINT_OPENGL_ERROR();
+    glCompileShader(shader);                                                       PRINT_OPENGL_ERROR();
+
+    GLint status = 0;
+    glGetShaderiv(shader,GL_COMPILE_STATUS,&status);                               PRINT_OPENGL_ERROR();
+    print_info_log(shader,false,"Shader "+filename);
+    if(!status)
+    {
+        glDeleteShader(shader);                                                    PRINT_OPENGL_ERROR();
+        throw exception_cpe("Cannot compile shader "+filename,EXCEPTION_PARAMETERS_CPE);
+    }
+    return shader;
+}
+
+
+shader_registry::shader_registry(std::string const& cache_directory_param)
+    :programs(),uniform_locations(),cache_directory(cache_directory_param),binary_cache_enabled(true)
+{}
+
+shader_registry::~shader_registry()
+{
+    //the programs are not deleted here: the OpenGL context may already be destroyed
+}
+
+GLuint shader_registry::load(std::string const& vertex_filename,
+                             std::string const& fragment_filename,
+                             std::vector<shader_attribute> const& attributes)
+{
+    //key identifying the program in this registry
+    std::string key = vertex_filename+"|"+fragment_filename;
+    for(shader_attribute const& a : attributes)
+        key += "|"+std::to_string(a.location)+":"+a.name;
+
+    auto const it = programs.find(key);
+    if(it!=programs.end())
+        return it->second;
+
+    std::string const vertex_source   = read_file(vertex_filename);
+    std::string const fragment_source = read_file(fragment_filename);
+
+    //a binary is only valid for the exact same sources, attributes and driver
+    std::string binary_filename;
+    GLuint program = 0;
+    if(binary_cache_available())
+    {
+        std::string const signature = vertex_source+'\0'+fragment_source+'\0'+key+'\0'+
+                gl_string(GL_VENDOR)+'\0'+gl_string(GL_RENDERER)+'\0'+gl_string(GL_VERSION);
+        std::stringstream name;
+        name<<cache_directory<<"/"<<std::hex<<std::setw(16)<<std::setfill('0')<<hash_fnv1a(signature)<<".bin";
+        binary_filename = name.str();
+
+        program = load_program_binary(binary_filename);
+    }
+
+    if(program==0)
+    {
+        program = build_program(vertex_source,fragment_source,attributes);
+        if(binary_filename.size()>0)
+            save_program_binary(program,binary_filename);
+    }
+
+    programs[key] = program;
+    return program;
+}
+
+GLint shader_registry::uniform(GLuint const program,std::string const& name)
+{
+    std::unordered_map<std::string,GLint>& locations = uniform_locations[program];
+
+    auto const it = locations.find(name);
+    if(it!=locations.end())
+        return it->second;
+
+    GLint const loc = get_uni_loc(program,name.c_str());
+    locations[name] = loc;
+    return loc;
+}
+
+void shader_registry::set_binary_cache(bool const is_enabled)
+{
+    binary_cache_enabled = is_enabled;
+}
+
+void shader_registry::clear()
+{
+    for(auto const& p : programs)
+    {glDeleteProgram(p.second);                                                    PRINT_OPENGL_ERROR();}
+    programs.clear();
+    uniform_locations.clear();
+}
+
+GLuint shader_registry::build_program(std::string const& vertex_source,
+                                      std::string const& fragment_source,
+                                      std::vector<shader_attribute> const& attributes) const
+{
+    GLuint const vertex_shader   = compile_shader(GL_VERTEX_SHADER,vertex_source,"vertex");
+    GLuint const fragment_shader = compile_shader(GL_FRAGMENT_SHADER,fragment_source,"fragment");
+
+    GLuint const program = glCreateProgram();                                      PRINT_OPENGL_ERROR();
+    glAttachShader(program,vertex_shader);                                         PRINT_OPENGL_ERROR();
+    glAttachShader(program,fragment_shader);                                       PRINT_OPENGL_ERROR();
+
+    for(shader_attribute const& a : attributes)
+    {glBindAttribLocation(program,a.location,a.name.c_str());                      PRINT_OPENGL_ERROR();}
+
+    if(binary_cache_available())
+    {glProgramParameteri(program,GL_PROGRAM_BINARY_RETRIEVABLE_HINT,GL_TRUE);      PRINT_OPENGL_ERROR();}
+
+    glLinkProgram(program);                                                        PRINT_OPENGL_ERROR();
+
+    //the shaders are kept alive by the program as long as it needs them
+    glDetachShader(program,vertex_shader);                                         PRINT_OPENGL_ERROR();
+    glDetachShader(program,fragment_shader);                                       PRINT_OPENGL_ERROR();
+    glDeleteShader(vertex_shader);                                                 PRINT_OPENGL_ERROR();
+    glDeleteShader(fragment_shader);                                               PRINT_OPENGL_ERROR();
+
+    GLint status = 0;
+    glGetProgramiv(program,GL_LINK_STATUS,&status);                                PRINT_OPENGL_ERROR();
+    print_info_log(program,true,"Program");
+    if(!status)
+    {
+        glDeleteProgram(program);                                                  PRINT_OPENGL_ERROR();
+        throw exception_cpe("Cannot link shader program",EXCEPTION_PARAMETERS_CPE);
+    }
+
+    return program;
+}
+
+GLuint shader_registry::load_program_binary(std::string const& filename) const
+{
+    std::ifstream fid(filename.c_str(),std::ios::binary);
+    if(!fid.good())
+        return 0;
+
+    //file layout: binary format (GLenum) followed by the binary
+    GLenum format = 0;
+    fid.read(reinterpret_cast<char*>(&format),sizeof(GLenum));
+    std::vector<char> const binary((std::istreambuf_iterator<char>(fid)),std::istreambuf_iterator<char>());
+    if(!fid.eof() || binary.size()==0)
+        return 0;
+
+    GLuint const program = glCreateProgram();                                      PRINT_OPENGL_ERROR();
+    glProgramBinary(program,format,&binary[0],static_cast<GLsizei>(binary.size()));
+    //an outdated binary is rejected by the driver, this is not an error: the program is rebuilt.
+    // A format no longer supported raises GL_INVALID_ENUM (read here only), other rejections give a failed link status.
+    bool const format_supported = glGetError()!=GL_INVALID_ENUM;
+
+    GLint status = 0;
+    glGetProgramiv(program,GL_LINK_STATUS,&status);                                PRINT_OPENGL_ERROR();
+    if(!format_supported || !status)
+    {
+        glDeleteProgram(program);                                                  PRINT_OPENGL_ERROR();
+        return 0;
+    }
+
+    return program;
+}
+
+void shader_registry::save_program_binary(GLuint const program,std::string const& filename) const
+{
+    GLint length = 0;
+    glGetProgramiv(program,GL_PROGRAM_BINARY_LENGTH,&length);                      PRINT_OPENGL_ERROR();
+    if(length<=0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program,length,nullptr,&format,&binary[0]);                 PRINT_OPENGL_ERROR();
+
+    mkdir(cache_directory.c_str(),0755);
+
+    //write in a temporary file first: a concurrent run never reads a partial binary
+    std::string const temporary_filename = filename+".tmp";
+    {
+        std::ofstream fid(temporary_filename.c_str(),std::ios::binary);
+        if(!fid.good())
+        {
+            std::cerr<<"Cannot write shader cache file "<<temporary_filename<<std::endl;
+            return;
+        }
+        fid.write(reinterpret_cast<char const*>(&format),sizeof(GLenum));
+        fid.write(&binary[0],binary.size());
+    }
+    std::rename(temporary_filename.c_str(),filename.c_str());
+}
+
+bool shader_registry::binary_cache_available() const
+{
+    if(!binary_cache_enabled || !GLEW_ARB_get_program_binary)
+        return false;
+
+    GLint N_format = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,&N_format);                        PRINT_OPENGL_ERROR();
+    return N_format>0;
+}
+
+}
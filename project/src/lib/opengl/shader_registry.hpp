@@ -0,0 +1,100 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef SHADER_REGISTRY_HPP
+#define SHADER_REGISTRY_HPP
+
+#include "GL/glew.h"
+#include "GL/gl.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+namespace cpe
+{
+
+/** Location to which a vertex attribute of a shader is bound before linking */
+struct shader_attribute
+{
+    /** The location of the attribute */
+    GLuint location;
+    /** The name of the attribute in the shader */
+    std::string name;
+};
+
+/** Registry of the shader programs.
+ *   - A program is compiled and linked only once and shared by all its users.
+ *   - The uniform locations are queried once per program and cached.
+ *   - The linked programs are stored on disk (GL_ARB_get_program_binary) in a file named after the hash of
+ *     their sources: the next startups skip the compilation as long as the shaders do not change.
+*/
+class shader_registry
+{
+public:
+
+    shader_registry(std::string const& cache_directory_param="shader_cache");
+    ~shader_registry();
+
+    /** Get the program built from the given vertex and fragment shader files (compiled at the first call).
+     *  The vertex attributes are bound to their location before linking. */
+    GLuint load(std::string const& vertex_filename,
+                std::string const& fragment_filename,
+                std::vector<shader_attribute> const& attributes=std::vector<shader_attribute>());
+
+    /** Get the location of a uniform variable of a program (queried on the GPU only once) */
+    GLint uniform(GLuint program,std::string const& name);
+
+    /** Enable/Disable the storage of the program binaries on disk */
+    void set_binary_cache(bool is_enabled);
+
+    /** Delete all the programs */
+    void clear();
+
+private:
+
+    /** Compile and link a program from its sources */
+    GLuint build_program(std::string const& vertex_source,
+                         std::string const& fragment_source,
+                         std::vector<shader_attribute> const& attributes) const;
+
+    /** Create a program from a binary stored on disk, return 0 if there is no valid binary */
+    GLuint load_program_binary(std::string const& filename) const;
+    /** Store the binary of a linked program on disk */
+    void save_program_binary(GLuint program,std::string const& filename) const;
+
+    /** Is the storage of the binaries available (and enabled) */
+    bool binary_cache_available() const;
+
+    /** Programs already loaded, indexed by their file names and attributes */
+    std::map<std::string,GLuint> programs;
+    /** Cached uniform locations of each program */
+    std::unordered_map<GLuint,std::unordered_map<std::string,GLint>> uniform_locations;
+
+    /** Directory storing the program binaries */
+    std::string cache_directory;
+    /** Is the storage of the binaries enabled */
+    bool binary_cache_enabled;
+};
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_buffer_opengl.hpp"
+
+#include "glutils.hpp"
+#include "../common/error_handling.hpp"
+
+#include <cstring>
+
+namespace cpe
+{
+
+/** Alignment (in bytes) of the data pushed in the buffer */
+static int const stream_alignment = 16;
+
+stream_buffer_opengl::stream_buffer_opengl(int const capacity_param)
+    :vbo(0),capacity(capacity_param),head(0)
+{}
+
+stream_buffer_opengl::~stream_buffer_opengl()
+{
+    if(vbo!=0)
+    {glDeleteBuffers(1,&vbo); PRINT_OPENGL_ERROR();}
+}
+
+void stream_buffer_opengl::init()
+{
+    ASSERT_CPE(vbo==0,"Stream buffer is already initialized");
+    ASSERT_CPE(capacity>0,"Stream buffer must have a positive capacity");
+
+    glGenBuffers(1,&vbo);                                              PRINT_OPENGL_ERROR();
+    ASSERT_CPE(vbo!=0,"Problem creation of VBO");
+
+    glBindBuffer(GL_ARRAY_BUFFER,vbo);                                 PRINT_OPENGL_ERROR();
+    glBufferData(GL_ARRAY_BUFFER,capacity,nullptr,GL_STREAM_DRAW);     PRINT_OPENGL_ERROR();
+    head=0;
+}
+
+int stream_buffer_opengl::push(void const* data,int const size)
+{
+    ASSERT_CPE(vbo!=0,"Stream buffer must be initialized before being used");
+    ASSERT_CPE(size>0,"Cannot push empty data");
+
+    glBindBuffer(GL_ARRAY_BUFFER,vbo);                                 PRINT_OPENGL_ERROR();
+
+    int offset=(head+stream_alignment-1)/stream_alignment*stream_alignment;
+    if(offset+size>capacity)
+    {
+        //grow when the data do not fit in the whole buffer
+        while(size>capacity)
+            capacity*=2;
+
+        //orphan the current storage: the GPU can still read the previous one
+        glBufferData(GL_ARRAY_BUFFER,capacity,nullptr,GL_STREAM_DRAW); PRINT_OPENGL_ERROR();
+        offset=0;
+    }
+
+    //the range was never used since the last orphaning: no need to synchronize with the GPU
+    void* const p = glMapBufferRange(GL_ARRAY_BUFFER,offset,size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT); PRINT_OPENGL_ERROR();
+    if(p==nullptr)
+        throw cpe::exception_cpe("Cannot map stream buffer",EXCEPTION_PARAMETERS_CPE);
+    std::memcpy(p,data,size);
+    glUnmapBuffer(GL_ARRAY_BUFFER);                                    PRINT_OPENGL_ERROR();
+
+    head=offset+size;
+    return offset;
+}
+
+GLuint stream_buffer_opengl::id() const
+{
+    return vbo;
+}
+
+}
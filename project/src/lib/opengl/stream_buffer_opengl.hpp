@@ -0,0 +1,65 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef STREAM_BUFFER_OPENGL_HPP
+#define STREAM_BUFFER_OPENGL_HPP
+
+#include "GL/glew.h"
+#include "GL/gl.h"
+
+namespace cpe
+{
+
+/** A persistent VBO used to send data regenerated at every frame (skeletons, debug lines, etc).
+ *  The data are sub-allocated one after the other in a ring buffer.
+ *  When the end of the buffer is reached, its storage is orphaned (glBufferData with a null pointer):
+ *  the driver gives a new storage without waiting for the GPU to finish drawing the previous data.
+ *  No buffer is allocated or destroyed during a frame.
+*/
+class stream_buffer_opengl
+{
+public:
+
+    stream_buffer_opengl(int capacity_param=1<<20);
+    ~stream_buffer_opengl();
+
+    /** Create the buffer on the GPU */
+    void init();
+
+    /** Copy data in the buffer and return the offset (in bytes) where they are stored.
+     *  The buffer is left bound to GL_ARRAY_BUFFER so that the offset can directly be used by gl*Pointer. */
+    int push(void const* data,int size);
+
+    /** The id of the VBO */
+    GLuint id() const;
+
+private:
+
+    /** VBO storing the data */
+    GLuint vbo;
+    /** Size of the buffer in bytes */
+    int capacity;
+    /** Offset of the next free byte of the buffer */
+    int head;
+};
+
+}
+
+#endif
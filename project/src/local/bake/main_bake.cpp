@@ -0,0 +1,122 @@
+#include "../../skinning/vertex_animation_cache.hpp"
+#include "../../skinning/vertex_animation_pca.hpp"
+#include "../../skinning/mesh_skinned.hpp"
+#include "../../skinning/skeleton_parent_id.hpp"
+#include "../../skinning/skeleton_geometry.hpp"
+#include "../../skinning/skeleton_animation.hpp"
+#include "../../skinning/format/mesh_skinned_io_glb.hpp"
+#include "../../lib/mesh/format/mesh_io_obj.hpp"
+#include "../../lib/common/error_handling.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+
+/** Keyframe rate of the legacy .animations files (same as the interactive scene) */
+static float const animation_keyframe_per_second = 25.0f;
+
+/** Load the model to bake: a .glb file, or the legacy files (obj mesh, .skeleton bind pose and .animations keyframes) */
+static cpe::skinned_model load_model(std::string const& mesh_file,std::string const& skeleton_file,std::string const& animation_file)
+{
+    using namespace cpe;
+    if(mesh_file.find(".glb")!=std::string::npos)
+        return load_skinned_model_file_glb(mesh_file);
+
+    skinned_model model;
+    obj_load_report report;
+    model.mesh.load(mesh_file,&report);
+    if(report.size_file>0)
+        std::cout<<mesh_file<<": "<<report.size_file/(1024.0*1024.0)<<" MB parsed in "<<report.time_parse+report.time_merge<<" ms"
+                 <<" ("<<report.N_chunk<<" chunks): "<<report.throughput()<<" MB/s"<<std::endl;
+    model.mesh.fill_empty_field_by_default();
+    model.parent_id.load(skeleton_file);
+    model.bind_pose.load(skeleton_file);
+    model.animation.load(animation_file,model.bind_pose.size());
+    //the joints are stored after their parent: the data read in the file order follow the order of the skeleton
+    model.bind_pose.remap_joints(model.parent_id.load_order());
+    model.animation.remap_joints(model.parent_id.load_order());
+    model.mesh.remap_joints(model.parent_id.load_order());
+    model.keyframe_duration = 1.0f/animation_keyframe_per_second;
+    model.bind_pose = bind_pose_file_to_global(model.bind_pose);
+    return model;
+}
+
+/** Convert the model to a single .glb file (mesh, skeleton and animation) */
+static void convert_model(cpe::skinned_model const& model,std::string const& output)
+{
+    auto const time_start = std::chrono::steady_clock::now();
+    cpe::save_skinned_model_file_glb(output,model);
+    double const time = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-time_start).count();
+
+    std::ifstream fid(output.c_str(),std::ios::binary|std::ios::ate);
+    double const size = static_cast<double>(fid.tellg())/(1024.0*1024.0);
+    std::cout<<model.mesh.size_vertex()<<" vertices, "<<model.parent_id.size()<<" joints and "<<model.animation.size()<<" keyframes"
+             <<" written in "<<output<<" in "<<time<<" ms ("<<size<<" MB)"<<std::endl;
+}
+
+/** Bake the deformed mesh of every frame of an animation cycle into a vertex animation cache.
+ *  usage: pgm_bake [output] [frame_per_second] [with_normal] [mesh] [skeleton] [animations] [pca_tolerance]
+ *  A frame rate of 0 keeps the rate of the keyframes, the skeleton and the animations are not used for a .glb mesh.
+ *  With a positive pca_tolerance, the positions are also compressed in [output].pca with a maximal vertex error of pca_tolerance.
+ *  If the output is a .glb file, the model is converted instead of being baked (ex. to move the legacy files to glTF):
+ *   pgm_bake cat.glb 0 0 data/cat.obj data/cat_bind_pose.skeleton data/cat.animations */
+int main(int argc, char *argv[])
+{
+    std::string const output         = argc>1? argv[1] : "cat.vac";
+    float const frame_per_second     = argc>2? std::atof(argv[2]) : 0.0f;
+    bool const with_normal           = argc>3? std::atoi(argv[3])!=0 : false;
+    std::string const mesh_file      = argc>4? argv[4] : "data/cat.obj";
+    std::string const skeleton_file  = argc>5? argv[5] : "data/cat_bind_pose.skeleton";
+    std::string const animation_file = argc>6? argv[6] : "data/cat.animations";
+    float const pca_tolerance        = argc>7? std::atof(argv[7]) : 0.0f;
+
+    if(frame_per_second<0.0f)
+    {
+        std::cerr<<"usage: "<<argv[0]<<" [output] [frame_per_second] [with_normal] [mesh] [skeleton] [animations] [pca_tolerance]"<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        cpe::skinned_model const model = load_model(mesh_file,skeleton_file,animation_file);
+        if(output.find(".glb")!=std::string::npos)
+        {
+            convert_model(model,output);
+            return EXIT_SUCCESS;
+        }
+
+        cpe::vertex_animation_bake_parameter parameter;
+        parameter.frame_per_second = frame_per_second;
+        parameter.with_normal = with_normal;
+        cpe::vertex_animation_bake_report const report = cpe::bake_vertex_animation(output,model.mesh,model.parent_id,model.bind_pose,
+                                                                                    model.animation,1.0f/model.keyframe_duration,parameter);
+
+        std::cout<<report.N_frame<<" frames ("<<model.mesh.size_vertex()<<" vertices) baked in "<<1000.0*report.time_total<<" ms"
+                 <<" (evaluation: "<<1000.0*report.time_evaluation<<" ms, write: "<<1000.0*report.time_write<<" ms)"<<std::endl;
+        std::cout<<report.size_file/(1024.0*1024.0)<<" MB written in "<<output<<": "<<report.write_throughput()<<" MB/s"<<std::endl;
+
+        if(pca_tolerance>0.0f)
+        {
+            cpe::vertex_animation_pca_parameter pca_parameter;
+            pca_parameter.tolerance = pca_tolerance;
+            cpe::vertex_animation_pca_report const pca = cpe::compress_vertex_animation(cpe::vertex_animation_cache(output),output+".pca",pca_parameter);
+
+            std::cout<<"PCA compression with "<<pca.N_component<<" components in "<<1000.0*pca.time_total<<" ms: ratio "<<pca.compression_ratio()
+                     <<" ("<<pca.size_compressed/(1024.0*1024.0)<<" MB), vertex error max "<<pca.max_error<<" rms "<<pca.rms_error<<std::endl;
+        }
+    }
+    catch(cpe::exception_cpe& e)
+    {
+        std::cout<<e.report_exception()<<std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(std::exception& e)
+    {
+        std::cout<<"Exception thrown (std):"<<e.what()<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -121,8 +121,9 @@ void myWidgetGL::initializeGL()
     setup_opengl();
 
     //Init Scene 3D
-    scene_3d.set_widget(this);
+    scene_3d.set_host(this);
     scene_3d.load_scene();
+    time_start = std::chrono::steady_clock::now();
 
     //Activate depth buffer
     glEnable(GL_DEPTH_TEST); PRINT_OPENGL_ERROR();
@@ -150,6 +151,7 @@ void myWidgetGL::setup_opengl()
     print_opengl_info();
     print_current_opengl_context();
     setup_glew();
+    setup_opengl_debug_output();
 
     axes.init();
 }
@@ -207,24 +209,6 @@ void myWidgetGL::mousePressEvent(QMouseEvent *event)
 
 
 
-cpe::mat4 build_normal_matrix(const cpe::mat4& w)
-{
-    //the normal matrix is used to compute the transformation of the normals of the meshes
-    cpe::mat4 normal_matrix=cpe::mat4(w(0,0),w(1,0),w(2,0),0,
-                                      w(0,1),w(1,1),w(2,1),0,
-                                      w(0,2),w(1,2),w(2,2),0,
-                                      0,0,0,1);
-    cpe::vec4 tr(w(0,3),w(1,3),w(2,3),1.0f);
-    cpe::vec4 tr_inv=-normal_matrix*tr;
-    normal_matrix(0,3)=tr_inv[0];
-    normal_matrix(1,3)=tr_inv[1];
-    normal_matrix(2,3)=tr_inv[2];
-
-    normal_matrix=transposed(normal_matrix);
-
-    return normal_matrix;
-}
-
 void myWidgetGL::setup_camera()
 {
     // SETUP PROJECTION MATRIX
@@ -239,7 +223,7 @@ void myWidgetGL::setup_camera()
     cpe::mat4 world_matrix=world_matrix_zoom*world_matrix_rotation*world_matrix_translation;
 
     // SETUP NORMAL MATRIX
-    cpe::mat4 normal_matrix=build_normal_matrix(world_matrix);
+    cpe::mat4 normal_matrix=cpe::build_normal_matrix(world_matrix);
 
     camera_data={world_matrix,projection_matrix,normal_matrix};
 }
@@ -248,6 +232,11 @@ cpe::camera_matrices const& myWidgetGL::camera() const
     return camera_data;
 }
 
+float myWidgetGL::time() const
+{
+    return std::chrono::duration<float>(std::chrono::steady_clock::now()-time_start).count();
+}
+
 void myWidgetGL::draw_axes()
 {
     glUseProgram(axes.shader_id());
@@ -259,8 +248,8 @@ void myWidgetGL::draw_axes()
                                       0.0f,ratio,0.0f,0.0f,
                                       0.0f,0.0f,1.0f,0.0f,
                                       0.0f,0.0f,0.0f,1.0f);
-    glUniformMatrix4fv(get_uni_loc(axes.shader_id(),"camera_modelview"),1,false,orientation.pointer()); PRINT_OPENGL_ERROR();
-    glUniformMatrix4fv(get_uni_loc(axes.shader_id(),"camera_projection"),1,false,scaling.pointer());    PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(axes.uniform_camera_modelview(),1,false,orientation.pointer());  PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(axes.uniform_camera_projection(),1,false,scaling.pointer());     PRINT_OPENGL_ERROR();
 
     glClear(GL_DEPTH_BUFFER_BIT); PRINT_OPENGL_ERROR();
 
@@ -15,10 +15,13 @@
 #include "../../lib/opengl/axes_helper.hpp"
 #include "../../lib/interface/camera_matrices.hpp"
 #include "../scene/scene.hpp"
+#include "../scene/scene_host.hpp"
+
+#include <chrono>
 
 
 /** Qt Widget to render OpenGL scene */
-class myWidgetGL : public QGLWidget
+class myWidgetGL : public QGLWidget, public scene_host
 {
     Q_OBJECT
 
@@ -32,10 +35,13 @@ public:
     /** Set the wireframe on/off */
     void wireframe(bool est_actif);
     /** Get the current cameras values */
-    cpe::camera_matrices const& camera() const;
+    cpe::camera_matrices const& camera() const override;
 
     /** Load a texture given by its filename */
-    GLuint load_texture_file(std::string const& filename);
+    GLuint load_texture_file(std::string const& filename) override;
+
+    /** Time elapsed since the scene is loaded (in seconds) */
+    float time() const override;
 
 protected:
 
@@ -86,6 +92,9 @@ private:
     /** Storage class for the camera data */
     cpe::camera_matrices camera_data;
 
+    /** Time at which the animations started */
+    std::chrono::steady_clock::time_point time_start;
+
 };
 
 #endif
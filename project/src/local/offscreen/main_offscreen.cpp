@@ -0,0 +1,44 @@
+#include "offscreen_renderer.hpp"
+#include "../../lib/common/error_handling.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+/** Render the animation without display.
+ *  usage: pgm_offscreen [N_frame] [width] [height] [output_prefix]
+ *  An output prefix "-" only measures the rendering speed (no file written). */
+int main(int argc, char *argv[])
+{
+    int const N_frame          = argc>1? std::atoi(argv[1]) : 100;
+    int const width            = argc>2? std::atoi(argv[2]) : 800;
+    int const height           = argc>3? std::atoi(argv[3]) : 800;
+    std::string output_prefix  = argc>4? argv[4] : "frame";
+    if(output_prefix=="-")
+        output_prefix="";
+
+    if(N_frame<=0 || width<=0 || height<=0)
+    {
+        std::cerr<<"usage: "<<argv[0]<<" [N_frame] [width] [height] [output_prefix]"<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        offscreen_renderer renderer(width,height);
+        renderer.init();
+        renderer.render(N_frame,output_prefix);
+    }
+    catch(cpe::exception_cpe& e)
+    {
+        std::cout<<e.report_exception()<<std::endl;
+        return EXIT_FAILURE;
+    }
+    catch(std::exception& e)
+    {
+        std::cout<<"Exception thrown (std):"<<e.what()<<std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,315 @@
+#include "offscreen_renderer.hpp"
+
+#include <EGL/eglext.h>
+#include <QImage>
+
+#include "../../lib/3d/mat4.hpp"
+#include "../../lib/opengl/glutils.hpp"
+#include "../../lib/common/error_handling.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <future>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+
+/** Number of frames per second of the output sequence */
+static float const output_frame_per_second = 25.0f;
+/** Number of pixel buffer objects: a frame is read back N_pbo-1 frames after being rendered */
+static int const N_pbo = 3;
+
+
+offscreen_renderer::offscreen_renderer(int const width_param,int const height_param)
+    :width(width_param),height(height_param),
+      display(EGL_NO_DISPLAY),surface(EGL_NO_SURFACE),context(EGL_NO_CONTEXT),
+      fbo(0),rbo_color(0),rbo_depth(0),pbo(),pbo_fence(),
+      scene_3d(),camera_data(),time_data(0.0f)
+{
+    ASSERT_CPE(width>0 && height>0,"Incorrect size of the rendered images");
+}
+
+offscreen_renderer::~offscreen_renderer()
+{
+    if(context!=EGL_NO_CONTEXT)
+    {
+        //the OpenGL objects of the scene are released while the context still exists
+        scene_3d.reset();
+
+        for(GLsync& fence : pbo_fence)
+            if(fence!=nullptr)
+                glDeleteSync(fence);
+        if(pbo.size()>0)
+            glDeleteBuffers(pbo.size(),&pbo[0]);
+        glDeleteRenderbuffers(1,&rbo_color);
+        glDeleteRenderbuffers(1,&rbo_depth);
+        glDeleteFramebuffers(1,&fbo);
+
+        eglMakeCurrent(display,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+        eglDestroyContext(display,context);
+    }
+    if(surface!=EGL_NO_SURFACE)
+        eglDestroySurface(display,surface);
+    if(display!=EGL_NO_DISPLAY)
+        eglTerminate(display);
+}
+
+void offscreen_renderer::init()
+{
+    setup_context();
+
+    //glewInit expects a GLX display: only the OpenGL entry points are loaded
+    GLenum const glew_status=glewContextInit();
+    if(glew_status!=GLEW_OK)
+        throw cpe::exception_cpe(std::string("Cannot initialize Glew: ")+reinterpret_cast<char const*>(glewGetErrorString(glew_status)),EXCEPTION_PARAMETERS_CPE);
+
+    print_opengl_info();
+    setup_opengl_debug_output();
+    setup_framebuffer();
+
+    scene_3d.reset(new scene);
+    scene_3d->set_host(this);
+    scene_3d->load_scene();
+    //the rendered frames must not depend on the loading time
+    scene_3d->wait_loading();
+
+    glEnable(GL_DEPTH_TEST); PRINT_OPENGL_ERROR();
+}
+
+void offscreen_renderer::setup_context()
+{
+    //the surfaceless platform needs neither a X server nor a window
+    char const* const client_extensions=eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+    if(client_extensions!=nullptr && std::strstr(client_extensions,"EGL_MESA_platform_surfaceless")!=nullptr)
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC const get_platform_display=
+                reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if(get_platform_display!=nullptr)
+            display=get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,nullptr);
+    }
+    if(display==EGL_NO_DISPLAY)
+        display=eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(display==EGL_NO_DISPLAY)
+        throw cpe::exception_cpe("Cannot get an EGL display",EXCEPTION_PARAMETERS_CPE);
+
+    EGLint major=0,minor=0;
+    if(eglInitialize(display,&major,&minor)!=EGL_TRUE)
+        throw cpe::exception_cpe("Cannot initialize EGL",EXCEPTION_PARAMETERS_CPE);
+    std::cout<<"EGL initialized ("<<major<<"."<<minor<<")"<<std::endl;
+
+    if(eglBindAPI(EGL_OPENGL_API)!=EGL_TRUE)
+        throw cpe::exception_cpe("EGL does not support desktop OpenGL",EXCEPTION_PARAMETERS_CPE);
+
+    //without surfaceless context, a small pbuffer is created only to make the context current
+    char const* const display_extensions=eglQueryString(display,EGL_EXTENSIONS);
+    bool const surfaceless=display_extensions!=nullptr && std::strstr(display_extensions,"EGL_KHR_surfaceless_context")!=nullptr;
+
+    EGLint const config_attributes[]={EGL_SURFACE_TYPE   , surfaceless? 0 : EGL_PBUFFER_BIT,
+                                      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                      EGL_RED_SIZE       , 8,
+                                      EGL_GREEN_SIZE     , 8,
+                                      EGL_BLUE_SIZE      , 8,
+                                      EGL_NONE};
+    EGLConfig config;
+    EGLint N_config=0;
+    if(eglChooseConfig(display,config_attributes,&config,1,&N_config)!=EGL_TRUE || N_config==0)
+        throw cpe::exception_cpe("Cannot find an EGL configuration for OpenGL",EXCEPTION_PARAMETERS_CPE);
+
+    if(!surfaceless)
+    {
+        EGLint const pbuffer_attributes[]={EGL_WIDTH,1,EGL_HEIGHT,1,EGL_NONE};
+        surface=eglCreatePbufferSurface(display,config,pbuffer_attributes);
+        if(surface==EGL_NO_SURFACE)
+            throw cpe::exception_cpe("Cannot create EGL pbuffer",EXCEPTION_PARAMETERS_CPE);
+    }
+
+    //no attributes: compatibility profile, as expected by the shaders of the scene
+    context=eglCreateContext(display,config,EGL_NO_CONTEXT,nullptr);
+    if(context==EGL_NO_CONTEXT)
+        throw cpe::exception_cpe("Cannot create EGL context",EXCEPTION_PARAMETERS_CPE);
+
+    if(eglMakeCurrent(display,surface,surface,context)!=EGL_TRUE)
+        throw cpe::exception_cpe("Cannot make the EGL context current",EXCEPTION_PARAMETERS_CPE);
+}
+
+void offscreen_renderer::setup_framebuffer()
+{
+    glGenFramebuffers(1,&fbo);                                                            PRINT_OPENGL_ERROR();
+    glGenRenderbuffers(1,&rbo_color);                                                     PRINT_OPENGL_ERROR();
+    glGenRenderbuffers(1,&rbo_depth);                                                     PRINT_OPENGL_ERROR();
+
+    glBindRenderbuffer(GL_RENDERBUFFER,rbo_color);                                        PRINT_OPENGL_ERROR();
+    glRenderbufferStorage(GL_RENDERBUFFER,GL_RGBA8,width,height);                         PRINT_OPENGL_ERROR();
+    glBindRenderbuffer(GL_RENDERBUFFER,rbo_depth);                                        PRINT_OPENGL_ERROR();
+    glRenderbufferStorage(GL_RENDERBUFFER,GL_DEPTH_COMPONENT24,width,height);             PRINT_OPENGL_ERROR();
+    glBindRenderbuffer(GL_RENDERBUFFER,0);                                                PRINT_OPENGL_ERROR();
+
+    glBindFramebuffer(GL_FRAMEBUFFER,fbo);                                                PRINT_OPENGL_ERROR();
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,rbo_color); PRINT_OPENGL_ERROR();
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_DEPTH_ATTACHMENT,GL_RENDERBUFFER,rbo_depth);  PRINT_OPENGL_ERROR();
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+        throw cpe::exception_cpe("Incomplete framebuffer",EXCEPTION_PARAMETERS_CPE);
+
+    //the scene draws in the framebuffer object as if it was the default one
+    glReadBuffer(GL_COLOR_ATTACHMENT0);                                                   PRINT_OPENGL_ERROR();
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);                                                   PRINT_OPENGL_ERROR();
+
+    pbo.resize(N_pbo);
+    pbo_fence.assign(N_pbo,nullptr);
+    glGenBuffers(N_pbo,&pbo[0]);                                                          PRINT_OPENGL_ERROR();
+    for(GLuint const buffer : pbo)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,buffer);                                        PRINT_OPENGL_ERROR();
+        glBufferData(GL_PIXEL_PACK_BUFFER,4*width*height,nullptr,GL_STREAM_READ);         PRINT_OPENGL_ERROR();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER,0);                                                 PRINT_OPENGL_ERROR();
+}
+
+void offscreen_renderer::setup_camera(float const angle)
+{
+    cpe::mat4 projection_matrix;
+    float const ratio=static_cast<float>(width)/height;
+    projection_matrix.set_projection_perspective(55.0f*M_PI/180.0f,ratio,1e-3f,500.0f);
+
+    //turntable: the camera turns around the vertical axis, slightly above the scene
+    cpe::mat4 world_matrix_zoom; world_matrix_zoom.set_translation({0.0f,0.0f,-150.0f});
+    cpe::mat4 world_matrix_tilt; world_matrix_tilt.set_rotation({1.0f,0.0f,0.0f},0.35f);
+    cpe::mat4 world_matrix_turn; world_matrix_turn.set_rotation({0.0f,1.0f,0.0f},angle);
+    cpe::mat4 const world_matrix=world_matrix_zoom*world_matrix_tilt*world_matrix_turn;
+
+    camera_data={world_matrix,projection_matrix,cpe::build_normal_matrix(world_matrix)};
+}
+
+void offscreen_renderer::render(int const N_frame,std::string const& output_prefix)
+{
+    ASSERT_CPE(scene_3d!=nullptr,"Renderer must be initialized before rendering");
+    bool const write_output=output_prefix.size()>0;
+
+    std::vector<unsigned char> pixels(4*width*height);
+    std::future<void> writing;
+    double time_wait_readback=0.0;
+
+    auto const time_start=std::chrono::steady_clock::now();
+
+    //the last iterations only read back the frames still in flight
+    for(int k=0 ; k<N_frame+N_pbo-1 ; ++k)
+    {
+        if(k<N_frame)
+        {
+            time_data=k/output_frame_per_second;
+            setup_camera(2.0f*M_PI*k/N_frame);
+
+            glBindFramebuffer(GL_FRAMEBUFFER,fbo);                                        PRINT_OPENGL_ERROR();
+            glViewport(0,0,width,height);                                                 PRINT_OPENGL_ERROR();
+            glClearColor(1.0f,1.0f,1.0f,1.0f);                                            PRINT_OPENGL_ERROR();
+            glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);                             PRINT_OPENGL_ERROR();
+
+            scene_3d->draw_scene();
+
+            //asynchronous copy of the frame in a PBO
+            int const slot=k%N_pbo;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[slot]);                                 PRINT_OPENGL_ERROR();
+            glReadPixels(0,0,width,height,GL_RGBA,GL_UNSIGNED_BYTE,buffer_offset(0));     PRINT_OPENGL_ERROR();
+            pbo_fence[slot]=glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);                 PRINT_OPENGL_ERROR();
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,0);                                         PRINT_OPENGL_ERROR();
+        }
+
+        //frame rendered N_pbo-1 iterations ago
+        int const k_ready=k-(N_pbo-1);
+        if(k_ready<0)
+            continue;
+        int const slot=k_ready%N_pbo;
+
+        auto const time_wait_start=std::chrono::steady_clock::now();
+        GLenum const wait_status=glClientWaitSync(pbo_fence[slot],GL_SYNC_FLUSH_COMMANDS_BIT,GL_TIMEOUT_IGNORED); PRINT_OPENGL_ERROR();
+        glDeleteSync(pbo_fence[slot]);                                                    PRINT_OPENGL_ERROR();
+        pbo_fence[slot]=nullptr;
+        time_wait_readback+=std::chrono::duration<double>(std::chrono::steady_clock::now()-time_wait_start).count();
+        if(wait_status!=GL_ALREADY_SIGNALED && wait_status!=GL_CONDITION_SATISFIED)
+            throw cpe::exception_cpe("Failed to wait for the readback of frame "+std::to_string(k_ready),EXCEPTION_PARAMETERS_CPE);
+
+        if(!write_output)
+            continue;
+
+        //the previous image must be written before its buffer is reused
+        if(writing.valid())
+            writing.get();
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,pbo[slot]);                                     PRINT_OPENGL_ERROR();
+        void const* const data=glMapBufferRange(GL_PIXEL_PACK_BUFFER,0,pixels.size(),GL_MAP_READ_BIT); PRINT_OPENGL_ERROR();
+        if(data==nullptr)
+            throw cpe::exception_cpe("Cannot map the pixel buffer",EXCEPTION_PARAMETERS_CPE);
+        std::memcpy(&pixels[0],data,pixels.size());
+        GLboolean const unmapped=glUnmapBuffer(GL_PIXEL_PACK_BUFFER);                     PRINT_OPENGL_ERROR();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,0);                                             PRINT_OPENGL_ERROR();
+        if(unmapped==GL_FALSE)
+            throw cpe::exception_cpe("The pixel buffer of frame "+std::to_string(k_ready)+" was corrupted while mapped",EXCEPTION_PARAMETERS_CPE);
+
+        std::stringstream filename;
+        filename<<output_prefix<<"_"<<std::setw(4)<<std::setfill('0')<<k_ready<<".ppm";
+        std::string const name=filename.str();
+        writing=std::async(std::launch::async,[this,&pixels,name](){write_frame(pixels,name);});
+    }
+    if(writing.valid())
+        writing.get();
+
+    double const time_total=std::chrono::duration<double>(std::chrono::steady_clock::now()-time_start).count();
+    std::cout<<N_frame<<" frames ("<<width<<"x"<<height<<") rendered in "<<time_total<<" s: "
+             <<N_frame/time_total<<" fps (waiting for readback: "<<1000.0*time_wait_readback<<" ms)"<<std::endl;
+}
+
+void offscreen_renderer::write_frame(std::vector<unsigned char> const& pixels,std::string const& filename) const
+{
+    //PPM stores the rows from top to bottom, without alpha
+    std::vector<unsigned char> rgb(3*width*height);
+    for(int y=0 ; y<height ; ++y)
+    {
+        unsigned char const* src=&pixels[4*width*(height-1-y)];
+        unsigned char* dst=&rgb[3*width*y];
+        for(int x=0 ; x<width ; ++x)
+        {
+            dst[3*x+0]=src[4*x+0];
+            dst[3*x+1]=src[4*x+1];
+            dst[3*x+2]=src[4*x+2];
+        }
+    }
+
+    std::ofstream fid(filename.c_str(),std::ios::binary);
+    if(!fid.good())
+        throw cpe::exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+    fid<<"P6\n"<<width<<" "<<height<<"\n255\n";
+    fid.write(reinterpret_cast<char const*>(&rgb[0]),rgb.size());
+}
+
+cpe::camera_matrices const& offscreen_renderer::camera() const
+{
+    return camera_data;
+}
+
+float offscreen_renderer::time() const
+{
+    return time_data;
+}
+
+GLuint offscreen_renderer::load_texture_file(std::string const& filename)
+{
+    QImage const image(QString(filename.c_str()));
+    if(image.isNull())
+        throw cpe::exception_cpe("Failed to load texture "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    //OpenGL expects the first row at the bottom, ARGB32 is stored as BGRA bytes
+    QImage const data=image.convertToFormat(QImage::Format_ARGB32).mirrored();
+
+    GLuint texture=0;
+    glGenTextures(1,&texture);                                                            PRINT_OPENGL_ERROR();
+    glBindTexture(GL_TEXTURE_2D,texture);                                                 PRINT_OPENGL_ERROR();
+    glTexImage2D(GL_TEXTURE_2D,0,GL_RGBA,data.width(),data.height(),0,GL_BGRA,GL_UNSIGNED_BYTE,data.bits()); PRINT_OPENGL_ERROR();
+    glGenerateMipmap(GL_TEXTURE_2D);                                                      PRINT_OPENGL_ERROR();
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR_MIPMAP_LINEAR);         PRINT_OPENGL_ERROR();
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);                       PRINT_OPENGL_ERROR();
+
+    return texture;
+}
@@ -0,0 +1,86 @@
+
+/** TP 5ETI - CPE Lyon - 2015/2016 */
+
+#pragma once
+
+#ifndef OFFSCREEN_RENDERER_HPP
+#define OFFSCREEN_RENDERER_HPP
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+#include <EGL/egl.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "../../lib/interface/camera_matrices.hpp"
+#include "../scene/scene.hpp"
+#include "../scene/scene_host.hpp"
+
+/** Render the scene without any window (EGL context and framebuffer object).
+ *  Used to output image sequences of the animations on machines without display.
+ *  The frames are read back asynchronously through a ring of pixel buffer objects:
+ *   the pixels of a frame are only accessed a few frames later, when the GPU is done with them.
+*/
+class offscreen_renderer : public scene_host
+{
+public:
+
+    offscreen_renderer(int width_param,int height_param);
+    ~offscreen_renderer();
+
+    /** Create the OpenGL context and the framebuffer, then load the scene */
+    void init();
+
+    /** Render N_frame frames of the animation (turntable camera).
+     *  Each frame is written in the file output_prefix_XXXX.ppm, nothing is written if output_prefix is empty. */
+    void render(int N_frame,std::string const& output_prefix);
+
+    /** Get the current cameras values */
+    cpe::camera_matrices const& camera() const override;
+    /** Load a texture given by its filename */
+    GLuint load_texture_file(std::string const& filename) override;
+    /** Time of the frame currently rendered (in seconds) */
+    float time() const override;
+
+private:
+
+    /** Create an EGL context (surfaceless when possible, pbuffer otherwise) and make it current */
+    void setup_context();
+    /** Create the framebuffer object and the pixel buffer objects used for the readback */
+    void setup_framebuffer();
+    /** Compute the camera turning around the scene for a given angle */
+    void setup_camera(float angle);
+
+    /** Write the pixels (RGBA, bottom to top) of a frame in a PPM file */
+    void write_frame(std::vector<unsigned char> const& pixels,std::string const& filename) const;
+
+    /** Size of the rendered images */
+    int width;
+    int height;
+
+    /** EGL display, surface and context */
+    EGLDisplay display;
+    EGLSurface surface;
+    EGLContext context;
+
+    /** Framebuffer object and its color/depth attachments */
+    GLuint fbo;
+    GLuint rbo_color;
+    GLuint rbo_depth;
+
+    /** Ring of pixel buffer objects receiving the frames, and the fences signaling that their copy is done */
+    std::vector<GLuint> pbo;
+    std::vector<GLsync> pbo_fence;
+
+    /** All the content of the 3D scene (released before the context) */
+    std::unique_ptr<scene> scene_3d;
+
+    /** Storage for the camera data */
+    cpe::camera_matrices camera_data;
+    /** Time of the current frame */
+    float time_data;
+};
+
+#endif
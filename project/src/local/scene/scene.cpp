@@ -4,23 +4,38 @@
 
 #include "scene.hpp"
 #include "../../lib/opengl/glutils.hpp"
+#include "../../lib/common/error_handling.hpp"
 
 #include "../../lib/perlin/perlin.hpp"
 #include "../../lib/3d/quaternion.hpp"
 
-#include "../interface/myWidgetGL.hpp"
 
 #include <cmath>
 
 
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <iostream>
+#include <exception>
 #include "../../lib/mesh/mesh_io.hpp"
+#include "../../lib/mesh/format/mesh_io_obj.hpp"
+#include "../../skinning/vertex_animation_cache_opengl.hpp"
 
 
 
 using namespace cpe;
 
+/** Number of animation keyframes played per second */
+static float const animation_keyframe_per_second = 25.0f;
+
+/** Number of cats of the crowd along each side of the grid */
+static int const crowd_cat_side = 32;
+/** Distance between two cats of the crowd */
+static float const crowd_cat_spacing = 80.0f;
+/** Number of distinct animation phases in the crowd (the skeletons are only computed once per phase) */
+static int const crowd_cat_phase = 8;
+
 
 static cpe::mesh build_ground(float const L,float const h)
 {
@@ -83,6 +98,16 @@ static cpe::mesh_skinned build_cylinder(float const R, float const L, int const
 }
 
 
+/** Merge the duplicated vertices of a mesh and print the memory saved */
+static void weld_mesh(cpe::mesh_basic& m,std::string const& name)
+{
+    int const N_vertex = m.size_vertex();
+    std::size_t const memory = m.size_memory();
+    m.weld_vertices();
+    std::cout<<name<<" welding: "<<N_vertex<<" -> "<<m.size_vertex()<<" vertices, "
+             <<memory/1024<<" -> "<<m.size_memory()/1024<<" KB"<<std::endl;
+}
+
 void scene::init_cylinder_sk(float const L, int const sample_axis)
 {
     for(int i = 0; i<sample_axis;i++)
@@ -104,10 +129,20 @@ void scene::load_scene()
     // Preload default structure               //
     //*****************************************//
     texture_default = load_texture_file("data/white.jpg");
-    shader_mesh     = read_shader("shaders/shader_mesh.vert",
-                                  "shaders/shader_mesh.frag");           PRINT_OPENGL_ERROR();
-    shader_skeleton = read_shader("shaders/shader_skeleton.vert",
-                                  "shaders/shader_skeleton.frag");       PRINT_OPENGL_ERROR();
+    stream_buffer.init();
+    shader_mesh         = shaders.load("shaders/shader_mesh.vert",
+                                       "shaders/shader_mesh.frag");
+    shader_skeleton     = shaders.load("shaders/shader_skeleton.vert",
+                                       "shaders/shader_skeleton.frag");
+    shader_mesh_skinned = shaders.load("shaders/shader_mesh_skinned.vert",
+                                       "shaders/shader_mesh.frag",
+                                       mesh_skinned_opengl::shader_attributes());
+    if(GLEW_ARB_texture_buffer_object && GLEW_ARB_draw_instanced)
+        shader_mesh_skinned_instanced = shaders.load("shaders/shader_mesh_skinned_instanced.vert",
+                                                     "shaders/shader_mesh.frag",
+                                                     mesh_skinned_opengl::shader_attributes());
+    else
+        std::cerr<<"Instanced skinning is not supported, the crowd is not drawn"<<std::endl;
 
 
     //*****************************************//
@@ -122,20 +157,343 @@ void scene::load_scene()
     int const sample_size = 6;
     int const sample_axis = 6;
     mesh_cylinder = build_cylinder(r_cylinder, l_cylinder,sample_size,sample_axis);
+    weld_mesh(mesh_cylinder,"Cylinder");
     mesh_cylinder.fill_empty_field_by_default();
     mesh_cylinder_opengl.fill_vbo(mesh_cylinder);
 
     init_cylinder_sk(l_cylinder, sample_axis);
+
+
+    //*****************************************//
+    // Load cat (background threads)
+    //*****************************************//
+    load_cat();
+}
+
+/** Files of the cat (watched for hot reload) */
+static std::string const cat_mesh_file = "data/cat.obj";
+static std::string const cat_skeleton_file = "data/cat_bind_pose.skeleton";
+static std::string const cat_animation_file = "data/cat.animations";
+/** Baked animation of the cat (optional, not watched) */
+static std::string const cat_cache_file = "data/cat.vac";
+
+/** Parse the mesh of the cat, optimize it and build its levels of detail.
+ *  Its joints follow the order of the skeleton file (reordered if a joint is stored before its parent). */
+static scene_cat_mesh parse_cat_mesh(std::string const& filename,std::string const& skeleton_filename,int const N_level)
+{
+    scene_cat_mesh cat;
+    cat.parent_id.load(skeleton_filename);
+    obj_load_report report;
+    cat.mesh.load(filename,&report);
+    if(report.size_file>0)
+        std::cout<<"Cat obj file: "<<report.size_file/(1024.0*1024.0)<<" MB parsed in "<<report.time_parse+report.time_merge<<" ms"
+                 <<" ("<<report.N_chunk<<" chunks): "<<report.throughput()<<" MB/s"<<std::endl;
+    cat.mesh.remap_joints(cat.parent_id.load_order());
+    weld_mesh(cat.mesh,"Cat");
+    cat.mesh.fill_empty_field_by_default();
+    float const acmr_cat = cat.mesh.compute_acmr();
+    cat.mesh.optimize_vertex_cache();
+    std::cout<<"Cat vertex cache optimization: ACMR "<<acmr_cat<<" -> "<<cat.mesh.compute_acmr()<<std::endl;
+    cat.lod.build(cat.mesh,N_level);
+    return cat;
+}
+
+/** Parse the bind pose of the cat and compute its inverse */
+static scene_cat_skeleton parse_cat_skeleton(std::string const& filename)
+{
+    scene_cat_skeleton cat;
+    cat.parent_id.load(filename);
+    cat.bind_pose.load(filename);
+    cat.bind_pose.remap_joints(cat.parent_id.load_order());
+    cat.bind_pose_inverse = inversed(bind_pose_file_to_global(cat.bind_pose));
+    return cat;
+}
+
+/** Parse the animation of the cat (its number of joints is read in the skeleton file) */
+static scene_cat_animation parse_cat_animation(std::string const& filename,std::string const& skeleton_filename)
+{
+    scene_cat_animation cat;
+    cat.parent_id.load(skeleton_filename);
+    cat.animation.load(filename,cat.parent_id.size());
+    cat.animation.remap_joints(cat.parent_id.load_order());
+    return cat;
+}
+
+/** True if two skeletons read from files have the same hierarchy and the same joints once loaded:
+ *   the data remapped by the load order of one can be used with the other. */
+static bool same_joints(skeleton_parent_id const& a,skeleton_parent_id const& b)
+{
+    if(a.size()!=b.size() || a.load_order()!=b.load_order())
+        return false;
+    for(int k=0 ; k<a.size() ; ++k)
+        if(a[k]!=b[k])
+            return false;
+    return true;
+}
+
+/** True if each vertex has skinning weights referring to the N_joint joints of the skeleton */
+static bool valid_joint_ids(mesh_skinned const& mesh,int const N_joint)
+{
+    if(mesh.size_vertex_weight()!=mesh.size_vertex())
+        return false;
+    for(int k_vertex=0 ; k_vertex<mesh.size_vertex() ; ++k_vertex)
+        for(skinning_weight const& s : mesh.vertex_weight(k_vertex))
+            if(s.joint_id<0 || s.joint_id>=N_joint)
+                return false;
+    return true;
+}
+
+void scene::load_cat()
+{
+    //mesh: parsing and processing of the levels of detail in a worker thread
+    loader.add("Cat mesh",[this]()
+    {
+        scene_cat_mesh cat = parse_cat_mesh(cat_mesh_file,cat_skeleton_file,cat_lod_count);
+        mesh_cat = std::move(cat.mesh);
+        mesh_cat_lod = std::move(cat.lod);
+    },
+    [this]()
+    {
+        for(int k_level=0 ; k_level<cat_lod_count ; ++k_level)
+        {
+            mesh_cat_opengl[k_level].fill_vbo(mesh_cat_lod[k_level]);
+            std::cout<<"Cat level of detail "<<k_level<<": "<<mesh_cat_lod[k_level].size_connectivity()<<" triangles"<<std::endl;
+        }
+        texture_cat = load_texture_file("data/cat.png");
+    });
+
+    //skeleton and animation, parsed in parallel with the mesh
+    loader.add("Cat skeleton",[this]()
+    {
+        scene_cat_skeleton cat = parse_cat_skeleton(cat_skeleton_file);
+        sk_cat_bind_pose = std::move(cat.bind_pose);
+        sk_cat_parent_id = std::move(cat.parent_id);
+        sk_cat_bind_pose_inverse = std::move(cat.bind_pose_inverse);
+        sk_cat_animation = parse_cat_animation(cat_animation_file,cat_skeleton_file).animation;
+    },
+    [this]()
+    {
+        //uploaded after the mesh: both are available
+        cat_bounds.build(mesh_cat,sk_cat_bind_pose.size());
+        init_crowd_cat();
+    });
+
+    //baked animation of the crowd: the cats are skinned on the GPU if it is not available
+    if(!std::ifstream(cat_cache_file.c_str()).good())
+        return;
+    loader.add("Cat vertex cache",[this]()
+    {
+        try
+        {
+            cat_cache.open(cat_cache_file);
+            //same vertices as the ones baked by pgm_bake
+            mesh_cat_cache.load(cat_mesh_file);
+            mesh_cat_cache.fill_empty_field_by_default();
+            if(cat_cache.size()==0 || cat_cache.size_vertex()!=mesh_cat_cache.size_vertex())
+                std::cerr<<"Vertex cache "<<cat_cache_file<<" ("<<cat_cache.size_vertex()<<" vertices) does not match "<<cat_mesh_file<<": the crowd is skinned on the GPU"<<std::endl;
+            else
+                cat_cache_loaded = true;
+        }
+        catch(exception_cpe const& e)
+        {
+            std::cerr<<"Vertex cache not used, the crowd is skinned on the GPU: "<<e.info()<<std::endl;
+        }
+    },
+    [this]()
+    {
+        if(cat_cache_loaded)
+        {
+            mesh_cat_cache_opengl.fill_vbo(mesh_cat_cache);
+            std::cout<<"Crowd animated by the vertex cache "<<cat_cache_file<<" ("<<cat_cache.size()<<" frames"<<(cat_cache.has_normal()?" with normals":"")<<")"<<std::endl;
+        }
+    });
+}
+
+void scene::start_hot_reload()
+{
+    try
+    {
+        watcher.reset(new file_watcher);
+    }
+    catch(exception_cpe const& e)
+    {
+        std::cerr<<"Hot reload of the files is disabled: "<<e.info()<<std::endl;
+        return;
+    }
+
+    //the files are parsed in the watcher thread, then swapped in the scene by update_hot_reload
+    watcher->watch(cat_mesh_file,[this](std::string const& filename)
+    {
+        reload_cat_mesh.set(parse_cat_mesh(filename,cat_skeleton_file,cat_lod_count));
+    });
+    watcher->watch(cat_skeleton_file,[this](std::string const& filename)
+    {
+        reload_cat_skeleton.set(parse_cat_skeleton(filename));
+    });
+    watcher->watch(cat_animation_file,[this](std::string const& filename)
+    {
+        reload_cat_animation.set(parse_cat_animation(filename,cat_skeleton_file));
+    });
+    watcher->start();
+}
+
+void scene::update_hot_reload()
+{
+    //the joints are referenced by the mesh, the bounds and the animation by their index:
+    // the hierarchy and the load order of the skeleton must be kept, and the data are checked before being swapped
+    int const N_joint = sk_cat_bind_pose.size();
+
+    scene_cat_mesh cat_mesh;
+    if(reload_cat_mesh.take(cat_mesh))
+    {
+        if(!same_joints(cat_mesh.parent_id,sk_cat_parent_id))
+            std::cerr<<"Cat mesh not reloaded: the joints of the skeleton file differ from the current skeleton"<<std::endl;
+        else if(!valid_joint_ids(cat_mesh.mesh,N_joint))
+            std::cerr<<"Cat mesh not reloaded: its skinning weights must refer to the "<<N_joint<<" joints of the skeleton"<<std::endl;
+        else
+        {
+            skinning_bounds bounds;
+            bounds.build(cat_mesh.mesh,N_joint);
+
+            mesh_cat = std::move(cat_mesh.mesh);
+            mesh_cat_lod = std::move(cat_mesh.lod);
+            cat_bounds = std::move(bounds);
+            for(int k_level=0 ; k_level<cat_lod_count ; ++k_level)
+                mesh_cat_opengl[k_level].fill_vbo(mesh_cat_lod[k_level]);
+            std::cout<<"Cat mesh reloaded"<<std::endl;
+        }
+    }
+
+    scene_cat_skeleton cat_skeleton;
+    if(reload_cat_skeleton.take(cat_skeleton))
+    {
+        if(!same_joints(cat_skeleton.parent_id,sk_cat_parent_id))
+            std::cerr<<"Cat skeleton not reloaded: only the bind pose can change, not the hierarchy or the order of the joints"<<std::endl;
+        else
+        {
+            sk_cat_bind_pose = std::move(cat_skeleton.bind_pose);
+            sk_cat_parent_id = std::move(cat_skeleton.parent_id);
+            sk_cat_bind_pose_inverse = std::move(cat_skeleton.bind_pose_inverse);
+            std::cout<<"Cat skeleton reloaded"<<std::endl;
+        }
+    }
+
+    scene_cat_animation cat_animation;
+    if(reload_cat_animation.take(cat_animation))
+    {
+        if(!same_joints(cat_animation.parent_id,sk_cat_parent_id))
+            std::cerr<<"Cat animation not reloaded: the joints of the skeleton file differ from the current skeleton"<<std::endl;
+        else if(cat_animation.animation.size()==0 || cat_animation.animation[0].size()!=N_joint)
+            std::cerr<<"Cat animation not reloaded: it must have keyframes of "<<N_joint<<" joints"<<std::endl;
+        else
+        {
+            sk_cat_animation = std::move(cat_animation.animation);
+            std::cout<<"Cat animation reloaded ("<<sk_cat_animation.size()<<" keyframes)"<<std::endl;
+        }
+    }
+}
+
+/** Print the time spent on each asset */
+static void print_loading_timings(asset_loader const& loader)
+{
+    for(asset_load_timing const& timing : loader.timings())
+        std::cout<<timing.name<<" loaded: parsing "<<1000*timing.time_parse<<" ms, upload "<<1000*timing.time_upload<<" ms, ready after "<<1000*timing.time_ready<<" ms"<<std::endl;
+    std::cout<<"Scene loaded in "<<1000*loader.time_total()<<" ms"<<std::endl;
+}
+
+void scene::update_loading()
+{
+    if(loader.finished() || loader.failed())
+        return;
+
+    //a failure is reported once: the scene is then drawn without the cat
+    try
+    {
+        if(loader.update())
+        {
+            print_loading_timings(loader);
+            start_hot_reload();
+        }
+    }
+    catch(exception_cpe const& e)
+    {
+        std::cerr<<"Failed to load the cat: "<<e.info()<<std::endl;
+    }
+    catch(std::exception const& e)
+    {
+        std::cerr<<"Failed to load the cat: "<<e.what()<<std::endl;
+    }
+}
+
+void scene::wait_loading()
+{
+    if(loader.finished())
+        return;
+    loader.wait();
+    print_loading_timings(loader);
+    start_hot_reload();
+}
+
+cpe::asset_loader const& scene::loading() const
+{
+    return loader;
+}
+
+void scene::add_loading_bar(std::vector<vec3>& lines) const
+{
+    //frame of the bar, then its filled part at the place of the cat
+    float const L = 40.0f;
+    float const h = 5.0f;
+    float const x_progress = -L+2*L*loader.progress();
+    vec3 const p[] = {vec3(-L,-h,0),vec3(L,-h,0),vec3(L,h,0),vec3(-L,h,0)};
+    for(int k=0 ; k<4 ; ++k)
+    {
+        lines.push_back(p[k]);
+        lines.push_back(p[(k+1)%4]);
+    }
+    for(float y=-h ; y<=h ; y+=1.0f)
+    {
+        lines.push_back(vec3(-L,y,0));
+        lines.push_back(vec3(x_progress,y,0));
+    }
 }
 
 
 
 void scene::draw_scene()
 {
+    //count the bytes of mesh data sent to the GPU during this frame
+    mesh_opengl::reset_bytes_uploaded();
 
-    setup_shader_skeleton(shader_skeleton);
+    //the cat data are written by the loading threads: they are only read once loaded
+    update_loading();
+    bool const cat_loaded = loader.finished();
+    if(cat_loaded)
+        update_hot_reload();
+
+    skeleton_geometry sk_cat_global;
+    if(cat_loaded && sk_cat_animation.size()>0)
+    {
+        int frame=0;
+        float alpha=0.0f;
+        animation_keyframe(sk_cat_animation.size(),frame,alpha);
+        sk_cat_global = local_to_global(sk_cat_animation(frame,alpha),sk_cat_parent_id);
+    }
 
-    //Here we can draw skeletons as 3D segments
+    //All the skeletons are gathered and drawn as a single set of 3D segments
+    skeleton_lines.clear();
+    std::vector<vec3> const bones_cylinder = extract_bones(local_to_global(sk_cylinder_bind_pose,sk_cylinder_parent_id),sk_cylinder_parent_id);
+    skeleton_lines.insert(skeleton_lines.end(),bones_cylinder.begin(),bones_cylinder.end());
+    if(sk_cat_global.size()>0)
+    {
+        std::vector<vec3> const bones_cat = extract_bones(sk_cat_global,sk_cat_parent_id);
+        skeleton_lines.insert(skeleton_lines.end(),bones_cat.begin(),bones_cat.end());
+    }
+    if(!cat_loaded && !loader.failed())
+        add_loading_bar(skeleton_lines);
+
+    setup_shader_skeleton(shader_skeleton);
+    draw_lines(skeleton_lines);
 
     setup_shader_mesh(shader_mesh);
 
@@ -144,6 +502,155 @@ void scene::draw_scene()
     mesh_cylinder_opengl.draw();
 
 
+    //The cat is deformed on the GPU: only the skinning palette is sent at each frame
+    if(sk_cat_global.size()>0)
+    {
+        view_frustum const frustum = build_view_frustum(phost->camera());
+        skeleton_geometry const palette_cat = multiply(sk_cat_global,sk_cat_bind_pose_inverse);
+
+        //the cat is neither skinned nor drawn when its deformed bounding box is out of the view
+        //otherwise its level of detail depends on its size on the screen (full detail if it has no box)
+        vec3 corner_min,corner_max;
+        bool const has_box = cat_bounds.compute_aabb(palette_cat,corner_min,corner_max);
+        if(!has_box || is_aabb_visible(frustum,corner_min,corner_max))
+        {
+            int const level = has_box? mesh_cat_lod.select(projected_size(phost->camera(),corner_min,corner_max)) : 0;
+
+            setup_shader_mesh(shader_mesh_skinned);
+            glBindTexture(GL_TEXTURE_2D,texture_cat);                                                  PRINT_OPENGL_ERROR();
+            upload_skinning_palette(shaders.uniform(shader_mesh_skinned,"skinning_palette"),palette_cat);
+            mesh_cat_opengl[level].draw();
+        }
+
+        draw_crowd_cat(frustum);
+    }
+
+}
+
+void scene::init_crowd_cat()
+{
+    crowd_cat_model.clear();
+    for(int kx=0 ; kx<crowd_cat_side ; ++kx)
+    {
+        for(int kz=0 ; kz<crowd_cat_side ; ++kz)
+        {
+            //grid behind the main cat, with a small varying orientation around the vertical axis
+            vec3 const position((kx-crowd_cat_side/2)*crowd_cat_spacing,0.0f,-(kz+2)*crowd_cat_spacing);
+            float const angle = 0.3f*std::sin(1.7f*kx+2.3f*kz);
+
+            mat4 R; R.set_rotation(vec3(0.0f,1.0f,0.0f),angle);
+            mat4 T; T.set_translation(position);
+            crowd_cat_model.push_back(T*R);
+        }
+    }
+}
+
+void scene::draw_crowd_cat(view_frustum const& frustum)
+{
+    if((!cat_cache_loaded && shader_mesh_skinned_instanced==0) || crowd_cat_model.size()==0)
+        return;
+
+    int const N_frame = sk_cat_animation.size();
+    int frame=0;
+    float alpha=0.0f;
+    animation_keyframe(N_frame,frame,alpha);
+
+    //the skeletons and their bounding boxes are computed once per phase, then shared by all the cats of this phase
+    //a phase without box (no vertex influenced by the skeleton) is not culled
+    std::vector<skeleton_geometry> palette_phase;
+    std::vector<vec3> corner_min_phase,corner_max_phase;
+    std::vector<bool> has_box_phase;
+    for(int k_phase=0 ; k_phase<crowd_cat_phase ; ++k_phase)
+    {
+        int const frame_phase = (frame+(k_phase*N_frame)/crowd_cat_phase)%N_frame;
+        skeleton_geometry const sk_global = local_to_global(sk_cat_animation(frame_phase,alpha),sk_cat_parent_id);
+        palette_phase.push_back(multiply(sk_global,sk_cat_bind_pose_inverse));
+
+        vec3 corner_min,corner_max;
+        has_box_phase.push_back(cat_bounds.compute_aabb(palette_phase.back(),corner_min,corner_max));
+        corner_min_phase.push_back(corner_min);
+        corner_max_phase.push_back(corner_max);
+    }
+
+    //only the cats in the view are drawn, with the level of detail fitting their size on the screen (-1 if culled)
+    int const N_instance = crowd_cat_model.size();
+    std::vector<int> level_instance(N_instance,-1);
+    for(int k=0 ; k<N_instance ; ++k)
+    {
+        int const k_phase = k%crowd_cat_phase;
+        if(!has_box_phase[k_phase])
+        {
+            level_instance[k] = 0;
+            continue;
+        }
+
+        vec3 corner_min = corner_min_phase[k_phase];
+        vec3 corner_max = corner_max_phase[k_phase];
+        transform_aabb(crowd_cat_model[k],corner_min,corner_max);
+        if(is_aabb_visible(frustum,corner_min,corner_max))
+            level_instance[k] = mesh_cat_lod.select(projected_size(phost->camera(),corner_min,corner_max));
+    }
+
+    //with the vertex cache, the frame of each phase is written once in the VBOs and drawn for all the visible cats of this phase
+    if(cat_cache_loaded)
+    {
+        camera_matrices const& cam = phost->camera();
+        setup_shader_mesh(shader_mesh);
+        glBindTexture(GL_TEXTURE_2D,texture_cat);                                                      PRINT_OPENGL_ERROR();
+        GLint const uniform_modelview = shaders.uniform(shader_mesh,"camera_modelview");
+        GLint const uniform_normal = shaders.uniform(shader_mesh,"normal_matrix");
+        for(int k_phase=0 ; k_phase<crowd_cat_phase ; ++k_phase)
+        {
+            float const time_phase = phost->time()+((k_phase*N_frame)/crowd_cat_phase)/animation_keyframe_per_second;
+            bool is_uploaded = false;
+            for(int k=k_phase ; k<N_instance ; k+=crowd_cat_phase)
+            {
+                if(level_instance[k]<0)
+                    continue;
+                if(!is_uploaded)
+                {
+                    upload_vertex_cache(mesh_cat_cache_opengl,cat_cache,time_phase);
+                    is_uploaded = true;
+                }
+
+                mat4 const modelview = cam.modelview*crowd_cat_model[k];
+                glUniformMatrix4fv(uniform_modelview,1,false,modelview.pointer());                     PRINT_OPENGL_ERROR();
+                glUniformMatrix4fv(uniform_normal,1,false,build_normal_matrix(modelview).pointer());   PRINT_OPENGL_ERROR();
+                mesh_cat_cache_opengl.draw();
+            }
+        }
+        setup_shader_mesh(shader_mesh);
+        return;
+    }
+
+    for(crowd_skinned_opengl& crowd : crowd_cat)
+        crowd.clear(sk_cat_bind_pose.size());
+    for(int k=0 ; k<N_instance ; ++k)
+        if(level_instance[k]>=0)
+            crowd_cat[level_instance[k]].add_instance(crowd_cat_model[k],palette_phase[k%crowd_cat_phase]);
+
+    setup_shader_mesh(shader_mesh_skinned_instanced);
+    glBindTexture(GL_TEXTURE_2D,texture_cat);                                                          PRINT_OPENGL_ERROR();
+    for(int k_level=0 ; k_level<cat_lod_count ; ++k_level)
+    {
+        if(crowd_cat[k_level].size()==0)
+            continue;
+        crowd_cat[k_level].update_tbo();
+        crowd_cat[k_level].draw(mesh_cat_opengl[k_level],
+                                shaders.uniform(shader_mesh_skinned_instanced,"skinning_palettes"),
+                                shaders.uniform(shader_mesh_skinned_instanced,"skinning_joint_count"));
+    }
+}
+
+void scene::animation_keyframe(int const N_frame,int& frame,float& alpha) const
+{
+    ASSERT_CPE(N_frame>0,"Animation without keyframe");
+
+    float const t = phost->time();
+    float const keyframe = t*animation_keyframe_per_second;
+
+    frame = static_cast<int>(keyframe)%N_frame;
+    alpha = keyframe-std::floor(keyframe);
 }
 
 
@@ -153,12 +660,12 @@ void scene::setup_shader_mesh(GLuint const shader_id)
     glUseProgram(shader_id);                                                                           PRINT_OPENGL_ERROR();
 
     //Get cameras parameters (modelview,projection,normal).
-    camera_matrices const& cam=pwidget->camera();
+    camera_matrices const& cam=phost->camera();
 
     //Set Uniform data to GPU
-    glUniformMatrix4fv(get_uni_loc(shader_id,"camera_modelview"),1,false,cam.modelview.pointer());     PRINT_OPENGL_ERROR();
-    glUniformMatrix4fv(get_uni_loc(shader_id,"camera_projection"),1,false,cam.projection.pointer());   PRINT_OPENGL_ERROR();
-    glUniformMatrix4fv(get_uni_loc(shader_id,"normal_matrix"),1,false,cam.normal.pointer());           PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(shaders.uniform(shader_id,"camera_modelview"),1,false,cam.modelview.pointer()); PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(shaders.uniform(shader_id,"camera_projection"),1,false,cam.projection.pointer()); PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(shaders.uniform(shader_id,"normal_matrix"),1,false,cam.normal.pointer());       PRINT_OPENGL_ERROR();
 
     //load white texture
     glBindTexture(GL_TEXTURE_2D,texture_default);                                                      PRINT_OPENGL_ERROR();
@@ -172,49 +679,44 @@ void scene::setup_shader_skeleton(GLuint const shader_id)
     glUseProgram(shader_id);                                                                           PRINT_OPENGL_ERROR();
 
     //Get cameras parameters (modelview,projection,normal).
-    camera_matrices const& cam=pwidget->camera();
+    camera_matrices const& cam=phost->camera();
 
     //Set Uniform data to GPU
-    glUniformMatrix4fv(get_uni_loc(shader_id,"camera_modelview"),1,false,cam.modelview.pointer());     PRINT_OPENGL_ERROR();
-    glUniformMatrix4fv(get_uni_loc(shader_id,"camera_projection"),1,false,cam.projection.pointer());   PRINT_OPENGL_ERROR();
-    glUniform3f(get_uni_loc(shader_id,"color") , 0.0f,0.0f,0.0f);                                      PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(shaders.uniform(shader_id,"camera_modelview"),1,false,cam.modelview.pointer()); PRINT_OPENGL_ERROR();
+    glUniformMatrix4fv(shaders.uniform(shader_id,"camera_projection"),1,false,cam.projection.pointer()); PRINT_OPENGL_ERROR();
+    glUniform3f(shaders.uniform(shader_id,"color") , 0.0f,0.0f,0.0f);                                  PRINT_OPENGL_ERROR();
 
     //size of the lines
     glLineWidth(3.0f);                                                                                 PRINT_OPENGL_ERROR();
 }
 
-void scene::draw_skeleton(std::vector<vec3> const& positions) const
+void scene::draw_lines(std::vector<vec3> const& positions)
 {
-    // Create temporary a VBO to store data
-    GLuint vbo_skeleton=0;
-    glGenBuffers(1,&vbo_skeleton);                                                                     PRINT_OPENGL_ERROR();
-    glBindBuffer(GL_ARRAY_BUFFER,vbo_skeleton);                                                        PRINT_OPENGL_ERROR();
+    if(positions.size()==0)
+        return;
 
-    // Update data on the GPU
-    glBufferData(GL_ARRAY_BUFFER , sizeof(vec3)*positions.size() , &positions[0] , GL_STATIC_DRAW);    PRINT_OPENGL_ERROR();
+    // Copy the data in the stream buffer (no allocation on the GPU)
+    int const offset = stream_buffer.push(&positions[0],sizeof(vec3)*positions.size());
 
     // Draw data
     glEnableClientState(GL_VERTEX_ARRAY);                                                              PRINT_OPENGL_ERROR();
-    glVertexPointer(3, GL_FLOAT, 0, 0);                                                                PRINT_OPENGL_ERROR();
+    glVertexPointer(3, GL_FLOAT, 0, buffer_offset(offset));                                            PRINT_OPENGL_ERROR();
     glDrawArrays(GL_LINES,0,positions.size());                                                         PRINT_OPENGL_ERROR();
-
-    // Delete temporary VBO
-    glDeleteBuffers(1,&vbo_skeleton);                                                                  PRINT_OPENGL_ERROR();
 }
 
 scene::scene()
-    :shader_mesh(0)
+    :phost(nullptr),mesh_cat_cache_opengl(mesh_opengl_layout::dynamic_position),cat_cache_loaded(false),shader_mesh(0),shader_skeleton(0),shader_mesh_skinned(0),shader_mesh_skinned_instanced(0)
 {}
 
 
 GLuint scene::load_texture_file(std::string const& filename)
 {
-    return pwidget->load_texture_file(filename);
+    return phost->load_texture_file(filename);
 }
 
-void scene::set_widget(myWidgetGL* widget_param)
+void scene::set_host(scene_host* host_param)
 {
-    pwidget=widget_param;
+    phost=host_param;
 }
 
 
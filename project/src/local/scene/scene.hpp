@@ -9,21 +9,52 @@
 #include <GL/gl.h>
 #include <GL/glew.h>
 
-#include <QTime>
-
 #include "../../lib/3d/mat3.hpp"
 #include "../../lib/3d/vec3.hpp"
 #include "../../lib/mesh/mesh.hpp"
 #include "../../lib/opengl/mesh_opengl.hpp"
+#include "../../lib/opengl/stream_buffer_opengl.hpp"
+#include "../../lib/opengl/shader_registry.hpp"
 #include "../../lib/interface/camera_matrices.hpp"
+#include "../../lib/common/asset_loader.hpp"
+#include "../../lib/common/file_watcher.hpp"
+#include "../../lib/common/pending_value.hpp"
 #include "../../skinning/mesh_skinned.hpp"
+#include "../../skinning/mesh_skinned_opengl.hpp"
+#include "../../skinning/crowd_skinned_opengl.hpp"
+#include "../../skinning/skinning_bounds.hpp"
+#include "../../skinning/mesh_skinned_lod.hpp"
 #include "../../skinning/skeleton_parent_id.hpp"
 #include "../../skinning/skeleton_animation.hpp"
+#include "../../skinning/vertex_animation_cache.hpp"
+#include "scene_host.hpp"
 
+#include <memory>
 #include <vector>
 
 
-class myWidgetGL;
+/** Mesh of the cat and its levels of detail, parsed together */
+struct scene_cat_mesh
+{
+    cpe::mesh_skinned mesh;
+    cpe::mesh_skinned_lod lod;
+    cpe::skeleton_parent_id parent_id; // skeleton read to order the joints of the mesh
+};
+
+/** Skeleton of the cat in bind pose, parsed together */
+struct scene_cat_skeleton
+{
+    cpe::skeleton_geometry bind_pose;
+    cpe::skeleton_parent_id parent_id;
+    cpe::skeleton_geometry bind_pose_inverse; // global coordinates
+};
+
+/** Animation of the cat, parsed with the skeleton giving its order of joints */
+struct scene_cat_animation
+{
+    cpe::skeleton_animation animation;
+    cpe::skeleton_parent_id parent_id; // skeleton read to order the joints of the animation
+};
 
 class scene
 {
@@ -33,14 +64,19 @@ public:
 
 
 
-    /**  Method called only once at the beginning (load off files ...) */
+    /**  Method called only once at the beginning (load off files ...)
+     *   The files of the cat are parsed in background threads: the scene is drawn without it until they are loaded. */
     void load_scene();
+    /** Block until all the assets of the scene are loaded */
+    void wait_loading();
+    /** Loading state of the assets of the scene (progress and timings) */
+    cpe::asset_loader const& loading() const;
 
     /**  Method called at every frame */
     void draw_scene();
 
-    /** Set the pointer to the parent Widget */
-    void set_widget(myWidgetGL* widget_param);
+    /** Set the pointer to the application running the scene (Qt widget or offscreen renderer) */
+    void set_host(scene_host* host_param);
 
 
 private:
@@ -48,14 +84,31 @@ private:
     /** Initialize a cylinder skeleton */
     void init_cylinder_sk(float const L, int const sample_axis);
 
-    /** Draw a set of line representing a skeleton */
-    void draw_skeleton(std::vector<cpe::vec3> const& positions) const;
+    /** Draw a set of lines (pairs of positions) in a single draw call using the stream buffer */
+    void draw_lines(std::vector<cpe::vec3> const& positions);
+
+    /** Start the parsing of the cat files in background threads, its OpenGL data are filled once they are parsed */
+    void load_cat();
+    /** Upload the assets parsed since the previous frame, print the timings once everything is loaded */
+    void update_loading();
+    /** Placeholder drawn at the place of the assets still loading: a bar filled with the progress */
+    void add_loading_bar(std::vector<cpe::vec3>& lines) const;
+
+    /** Watch the files of the cat: a modified file is parsed again in the background */
+    void start_hot_reload();
+    /** Swap the reparsed data of the cat in the scene, only the data depending on them are updated */
+    void update_hot_reload();
 
     /** Load a texture from a given file and returns its id */
     GLuint load_texture_file(std::string const& filename);
 
-    /** Access to the parent object */
-    myWidgetGL* pwidget;
+    /** Access to the application running the scene */
+    scene_host* phost;
+
+    /** Buffer shared by all the geometry regenerated at every frame (skeletons, debug lines) */
+    cpe::stream_buffer_opengl stream_buffer;
+    /** Bones of all the skeletons of the scene, gathered to be drawn at once */
+    std::vector<cpe::vec3> skeleton_lines;
 
     /** Default id for the texture (white texture) */
     GLuint texture_default;
@@ -78,10 +131,15 @@ private:
     /** Animation of the skeleton for the cylinder */
     cpe::skeleton_animation sk_cylinder_animation;
 
+    /** Number of levels of detail of the cat */
+    static constexpr int cat_lod_count = 4;
+
     /** Mesh of the skinned cat */
     cpe::mesh_skinned mesh_cat;
-    /** Mesh of the skinned cat for OpenGL drawing */
-    cpe::mesh_opengl mesh_cat_opengl;
+    /** Levels of detail of the cat (level 0 is mesh_cat) */
+    cpe::mesh_skinned_lod mesh_cat_lod;
+    /** Levels of detail of the skinned cat for OpenGL drawing (deformed on the GPU) */
+    cpe::mesh_skinned_opengl mesh_cat_opengl[cat_lod_count];
     /** Texture of the cat */
     GLuint texture_cat;
 
@@ -91,18 +149,61 @@ private:
     cpe::skeleton_parent_id sk_cat_parent_id;
     /** Animation of the skeleton for the cat */
     cpe::skeleton_animation sk_cat_animation;
+    /** Inverse of the bind pose of the cat expressed in global coordinates (B^{-1}) */
+    cpe::skeleton_geometry sk_cat_bind_pose_inverse;
+    /** Per-joint bounding boxes of the cat used to cull it when it is out of the view */
+    cpe::skinning_bounds cat_bounds;
+
+    /** Crowd of cats sharing the VBOs of mesh_cat_opengl (instanced drawing), one set of instances per level of detail */
+    cpe::crowd_skinned_opengl crowd_cat[cat_lod_count];
+    /** Model matrix of each cat of the crowd */
+    std::vector<cpe::mat4> crowd_cat_model;
+
+    /** Baked animation of the cat played by the crowd instead of the GPU skinning (only if the file exists, see pgm_bake) */
+    cpe::vertex_animation_cache cat_cache;
+    /** Mesh of the cat in the order of the vertices of the cache (order of the obj file) */
+    cpe::mesh_skinned mesh_cat_cache;
+    /** Mesh of the cat for OpenGL drawing, its positions and normals are written from the cache for each phase of the crowd */
+    cpe::mesh_opengl mesh_cat_cache_opengl;
+    /** True if the crowd is drawn with the vertex animation cache */
+    bool cat_cache_loaded;
 
+    /** Build the crowd of cats placed on a grid */
+    void init_crowd_cat();
+    /** Update the palettes of the visible cats of the crowd for the current frame and draw them */
+    void draw_crowd_cat(cpe::view_frustum const& frustum);
 
+    /** Compute the current keyframe and interpolation value of an animation of N_frame keyframes */
+    void animation_keyframe(int N_frame,int& frame,float& alpha) const;
+
+
+
+    /** Programs of the scene with their cached uniform locations */
+    cpe::shader_registry shaders;
 
     /** The id of the shader to draw meshes */
     GLuint shader_mesh;
     /** The id of the shader to draw skeleton */
     GLuint shader_skeleton;
+    /** The id of the shader to draw meshes deformed by skinning on the GPU */
+    GLuint shader_mesh_skinned;
+    /** The id of the shader to draw instances of a mesh deformed by skinning on the GPU (0 if not supported) */
+    GLuint shader_mesh_skinned_instanced;
 
 
     void setup_shader_mesh(GLuint shader_id);
     void setup_shader_skeleton(GLuint shader_id);
 
+    /** Data of the cat parsed again after a modification of its files, waiting to be swapped in the scene */
+    cpe::pending_value<scene_cat_mesh> reload_cat_mesh;
+    cpe::pending_value<scene_cat_skeleton> reload_cat_skeleton;
+    cpe::pending_value<scene_cat_animation> reload_cat_animation;
+    /** Watcher of the files of the cat, parsing them again in its thread (null if not available) */
+    std::unique_ptr<cpe::file_watcher> watcher;
+
+    /** Assets parsed in background threads (the cat).
+     *  Declared last: it is destroyed first and waits for the threads still writing in the other members. */
+    cpe::asset_loader loader;
 
 
 };
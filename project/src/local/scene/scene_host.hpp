@@ -0,0 +1,33 @@
+
+/** TP 5ETI - CPE Lyon - 2015/2016 */
+
+#pragma once
+
+#ifndef SCENE_HOST_HPP
+#define SCENE_HOST_HPP
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include <string>
+
+#include "../../lib/interface/camera_matrices.hpp"
+
+/** Services the scene needs from the application running it (Qt widget, offscreen renderer, etc). */
+class scene_host
+{
+public:
+
+    virtual ~scene_host() {}
+
+    /** Get the current cameras values */
+    virtual cpe::camera_matrices const& camera() const = 0;
+
+    /** Load a texture given by its filename */
+    virtual GLuint load_texture_file(std::string const& filename) = 0;
+
+    /** Time (in seconds) driving the animations */
+    virtual float time() const = 0;
+};
+
+#endif
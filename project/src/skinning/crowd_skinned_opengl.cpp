@@ -0,0 +1,172 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "crowd_skinned_opengl.hpp"
+
+#include "skeleton_geometry.hpp"
+#include "../lib/3d/mat4.hpp"
+#include "../lib/opengl/mesh_opengl.hpp"
+#include "../lib/opengl/glutils.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <algorithm>
+
+namespace cpe
+{
+
+/** Number of floats stored per joint (3 rows of the affine matrix, ie. 3 RGBA texels) */
+static int const floats_per_joint = 12;
+
+crowd_skinned_opengl::crowd_skinned_opengl()
+    :N_joint(0),palettes(),tbo(),tbo_texture()
+{}
+
+crowd_skinned_opengl::~crowd_skinned_opengl()
+{
+    delete_tbo();
+}
+
+void crowd_skinned_opengl::clear(int const N_joint_param)
+{
+    ASSERT_CPE(N_joint_param>0,"Incorrect number of joints");
+    N_joint = N_joint_param;
+    palettes.clear();
+}
+
+void crowd_skinned_opengl::add_instance(mat4 const& model,skeleton_geometry const& palette)
+{
+    ASSERT_CPE(palette.size()==N_joint,"Palette has incorrect number of joints ("+std::to_string(palette.size())+")");
+
+    std::size_t const offset = palettes.size();
+    palettes.resize(offset+floats_per_joint*N_joint);
+    float* current = &palettes[offset];
+
+    for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+    {
+        mat4 const M = model*palette[k_joint].to_mat4();
+        for(int row=0 ; row<3 ; ++row)
+            for(int col=0 ; col<4 ; ++col)
+                *current++ = M(row,col);
+    }
+}
+
+int crowd_skinned_opengl::size() const
+{
+    if(N_joint==0)
+        return 0;
+    return palettes.size()/(floats_per_joint*N_joint);
+}
+
+int crowd_skinned_opengl::instance_per_batch() const
+{
+    ASSERT_CPE(N_joint>0,"Crowd not initialized");
+
+    //a texture buffer is limited in number of texels (at least 65536)
+    GLint max_texel=0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE,&max_texel);                                              PRINT_OPENGL_ERROR();
+    int const texel_per_instance = 3*N_joint;
+    return std::max(1,max_texel/texel_per_instance);
+}
+
+int crowd_skinned_opengl::size_batch() const
+{
+    int const N_instance = size();
+    if(N_instance==0)
+        return 0;
+    int const N_per_batch = instance_per_batch();
+    return (N_instance+N_per_batch-1)/N_per_batch;
+}
+
+void crowd_skinned_opengl::update_tbo()
+{
+    int const N_instance = size();
+    if(N_instance==0)
+        return;
+
+    int const N_per_batch = instance_per_batch();
+    int const N_batch = size_batch();
+    std::size_t const floats_per_instance = floats_per_joint*N_joint;
+
+    //create the missing buffers
+    while(static_cast<int>(tbo.size())<N_batch)
+    {
+        GLuint buffer=0,texture=0;
+        glGenBuffers(1,&buffer);                                                                       PRINT_OPENGL_ERROR();
+        glGenTextures(1,&texture);                                                                     PRINT_OPENGL_ERROR();
+        ASSERT_CPE(buffer!=0 && texture!=0,"Problem creation of texture buffer");
+
+        //the buffer object only exists once bound
+        glBindBuffer(GL_TEXTURE_BUFFER,buffer);                                                        PRINT_OPENGL_ERROR();
+        glBindTexture(GL_TEXTURE_BUFFER,texture);                                                      PRINT_OPENGL_ERROR();
+        glTexBuffer(GL_TEXTURE_BUFFER,GL_RGBA32F,buffer);                                              PRINT_OPENGL_ERROR();
+
+        tbo.push_back(buffer);
+        tbo_texture.push_back(texture);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER,0);                                                                PRINT_OPENGL_ERROR();
+
+    for(int k_batch=0 ; k_batch<N_batch ; ++k_batch)
+    {
+        int const first = k_batch*N_per_batch;
+        int const N = std::min(N_per_batch,N_instance-first);
+        std::size_t const bytes_batch = sizeof(float)*floats_per_instance*std::min(N_per_batch,N_instance);
+
+        //the storage is orphaned: the previous frame may still be drawn from it
+        glBindBuffer(GL_TEXTURE_BUFFER,tbo[k_batch]);                                                  PRINT_OPENGL_ERROR();
+        glBufferData(GL_TEXTURE_BUFFER,bytes_batch,nullptr,GL_STREAM_DRAW);                            PRINT_OPENGL_ERROR();
+        glBufferSubData(GL_TEXTURE_BUFFER,0,sizeof(float)*floats_per_instance*N,&palettes[floats_per_instance*first]); PRINT_OPENGL_ERROR();
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER,0);                                                                 PRINT_OPENGL_ERROR();
+}
+
+void crowd_skinned_opengl::draw(mesh_opengl const& mesh,GLint const uniform_palettes,GLint const uniform_joint_count,int const texture_unit) const
+{
+    int const N_instance = size();
+    if(N_instance==0)
+        return;
+    ASSERT_CPE(static_cast<int>(tbo.size())>=size_batch(),"Texture buffers must be updated before drawing");
+
+    int const N_per_batch = instance_per_batch();
+    int const N_batch = size_batch();
+
+    glUniform1i(uniform_palettes,texture_unit);                                                        PRINT_OPENGL_ERROR();
+    glUniform1i(uniform_joint_count,N_joint);                                                          PRINT_OPENGL_ERROR();
+
+    glActiveTexture(GL_TEXTURE0+texture_unit);                                                         PRINT_OPENGL_ERROR();
+    for(int k_batch=0 ; k_batch<N_batch ; ++k_batch)
+    {
+        int const N = std::min(N_per_batch,N_instance-k_batch*N_per_batch);
+        glBindTexture(GL_TEXTURE_BUFFER,tbo_texture[k_batch]);                                         PRINT_OPENGL_ERROR();
+        mesh.draw_instanced(N);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER,0);                                                                PRINT_OPENGL_ERROR();
+    glActiveTexture(GL_TEXTURE0);                                                                      PRINT_OPENGL_ERROR();
+}
+
+void crowd_skinned_opengl::delete_tbo()
+{
+    if(tbo_texture.size()>0)
+    {glDeleteTextures(tbo_texture.size(),&tbo_texture[0]);                                             PRINT_OPENGL_ERROR();}
+    if(tbo.size()>0)
+    {glDeleteBuffers(tbo.size(),&tbo[0]);                                                              PRINT_OPENGL_ERROR();}
+    tbo_texture.clear();
+    tbo.clear();
+}
+
+}
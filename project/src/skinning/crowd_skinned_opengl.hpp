@@ -0,0 +1,89 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef CROWD_SKINNED_OPENGL_HPP
+#define CROWD_SKINNED_OPENGL_HPP
+
+#include "GL/glew.h"
+#include "GL/gl.h"
+
+#include <vector>
+
+namespace cpe
+{
+
+class mat4;
+class mesh_opengl;
+class skeleton_geometry;
+
+/** Class to draw many instances of the same skinned mesh with instanced draw calls.
+    The instances share the VBOs and the VAO of a mesh_skinned_opengl.
+    The palettes of all the instances are stored in texture buffers (one 3x4 affine matrix, ie. 3 RGBA texels, per joint)
+     and fetched in the shader (ex. shader_mesh_skinned_instanced.vert) using gl_InstanceID.
+    The model matrix of each instance is premultiplied into its palette.
+    The instances are split in batches fitting the maximal size of a texture buffer, each batch is a single draw call.
+*/
+class crowd_skinned_opengl
+{
+public:
+
+    crowd_skinned_opengl();
+    ~crowd_skinned_opengl();
+
+    /** Remove all the instances. Every instance added after is deformed by a skeleton of N_joint joints */
+    void clear(int N_joint);
+    /** Add an instance placed by a model matrix and deformed by a palette (matrices T*B^{-1}, see upload_skinning_palette) */
+    void add_instance(mat4 const& model,skeleton_geometry const& palette);
+
+    /** Send the palettes of all the instances to the GPU */
+    void update_tbo();
+
+    /** Draw all the instances of the mesh.
+     *  The current shader must be an instanced skinning shader. Its uniform samplerBuffer "skinning_palettes" is bound
+     *  to the given texture unit and the number of joints is sent to the uniform "skinning_joint_count". */
+    void draw(mesh_opengl const& mesh,GLint uniform_palettes,GLint uniform_joint_count,int texture_unit=1) const;
+
+    /** Number of instances */
+    int size() const;
+    /** Number of draw calls needed to draw all the instances */
+    int size_batch() const;
+
+private:
+
+    /** Number of instances drawn per batch */
+    int instance_per_batch() const;
+    /** Helper function to delete the texture buffers */
+    void delete_tbo();
+
+    /** Number of joints of the palette of each instance */
+    int N_joint;
+    /** Palettes of all the instances (12 floats per joint, rows of the affine matrix) */
+    std::vector<float> palettes;
+
+    /** Buffers storing the palettes (one per batch) */
+    std::vector<GLuint> tbo;
+    /** Buffer textures to access the palettes in the shader (one per batch) */
+    std::vector<GLuint> tbo_texture;
+};
+
+}
+
+#endif
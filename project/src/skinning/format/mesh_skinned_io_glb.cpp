@@ -0,0 +1,1068 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_skinned_io_glb.hpp"
+
+#include "../../lib/common/json.hpp"
+#include "../../lib/common/mapped_file.hpp"
+#include "../../lib/common/error_handling.hpp"
+#include "../../lib/3d/mat4.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+namespace cpe
+{
+
+/** Magic number of a glb file ("glTF") */
+static std::uint32_t const glb_magic = 0x46546C67;
+/** Type of the chunk storing the json description ("JSON") */
+static std::uint32_t const glb_chunk_json = 0x4E4F534A;
+/** Type of the chunk storing the binary buffer ("BIN") */
+static std::uint32_t const glb_chunk_bin = 0x004E4942;
+
+/** Component types of the glTF accessors */
+static int const gltf_byte = 5120;
+static int const gltf_unsigned_byte = 5121;
+static int const gltf_short = 5122;
+static int const gltf_unsigned_short = 5123;
+static int const gltf_unsigned_int = 5125;
+static int const gltf_float = 5126;
+
+/** Targets of the glTF buffer views */
+static int const gltf_array_buffer = 34962;
+static int const gltf_element_array_buffer = 34963;
+
+static_assert(sizeof(vec3)==3*sizeof(float),"vec3 must be stored as 3 contiguous floats");
+static_assert(sizeof(vec2)==2*sizeof(float),"vec2 must be stored as 2 contiguous floats");
+
+skinned_model::skinned_model()
+    :mesh(),parent_id(),bind_pose(),animation(),keyframe_duration(1.0f/25.0f)
+{}
+
+static bool is_little_endian_host()
+{
+    std::uint32_t const value = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte,&value,1);
+    return first_byte==1;
+}
+
+static std::uint32_t read_uint32_glb(char const* data)
+{
+    std::uint32_t value = 0;
+    std::memcpy(&value,data,sizeof(value));
+    return value;
+}
+
+/** Content of a glb file: the json description, and the binary chunk read in place from the mapped file */
+struct glb_content
+{
+    mapped_file file;       // mapping of the whole file
+    json_value json;        // description of the scene
+    char const* bin;        // binary chunk (nullptr if there is none)
+    std::size_t size_bin;   // size of the binary chunk
+    std::string filename;   // name of the file (for the error messages)
+};
+
+static void open_file_glb(glb_content& glb,std::string const& filename)
+{
+    glb.filename = filename;
+    glb.file.open(filename);
+    glb.bin = nullptr;
+    glb.size_bin = 0;
+
+    char const* const data = glb.file.data();
+    std::size_t const size = glb.file.size();
+    if(size<12 || read_uint32_glb(data)!=glb_magic)
+        throw exception_cpe("File "+filename+" is not a glb file",EXCEPTION_PARAMETERS_CPE);
+    if(read_uint32_glb(data+4)!=2)
+        throw exception_cpe("Unsupported glTF version in file "+filename,EXCEPTION_PARAMETERS_CPE);
+    std::size_t const size_total = std::min<std::size_t>(read_uint32_glb(data+8),size);
+
+    bool has_json = false;
+    std::size_t offset = 12;
+    while(offset+8<=size_total)
+    {
+        std::size_t const size_chunk = read_uint32_glb(data+offset);
+        std::uint32_t const type_chunk = read_uint32_glb(data+offset+4);
+        char const* const chunk = data+offset+8;
+        if(size_chunk>size_total-offset-8)
+            throw exception_cpe("Truncated chunk in file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+        if(!has_json)
+        {
+            if(type_chunk!=glb_chunk_json)
+                throw exception_cpe("The first chunk of file "+filename+" must be the json description",EXCEPTION_PARAMETERS_CPE);
+            glb.json = parse_json(chunk,chunk+size_chunk);
+            has_json = true;
+        }
+        else if(type_chunk==glb_chunk_bin && glb.bin==nullptr)
+        {
+            glb.bin = chunk;
+            glb.size_bin = size_chunk;
+        }
+        //the other chunks are extensions and are skipped
+
+        offset += 8+((size_chunk+3)/4)*4;
+    }
+    if(!has_json)
+        throw exception_cpe("Missing json description in file "+filename,EXCEPTION_PARAMETERS_CPE);
+}
+
+/** An accessor of a glb file: the component c of the element k is stored at data+k*stride+c*size_component */
+struct glb_accessor
+{
+    char const* data;       // first element (nullptr if the accessor has no buffer view: all its values are zero)
+    int count;              // number of elements
+    int components;         // number of components per element
+    int component_type;     // gltf_byte, gltf_unsigned_byte, ..., gltf_float
+    int size_component;     // size of a component (in bytes)
+    std::size_t stride;     // distance between two elements (in bytes)
+    bool normalized;        // integer values mapped to [0,1] (unsigned) or [-1,1] (signed)
+};
+
+static int number_of_components_glb(std::string const& type)
+{
+    if(type=="SCALAR") return 1;
+    if(type=="VEC2") return 2;
+    if(type=="VEC3") return 3;
+    if(type=="VEC4") return 4;
+    if(type=="MAT4") return 16;
+    return 0;
+}
+
+static int size_of_component_glb(int const component_type)
+{
+    switch(component_type)
+    {
+    case gltf_byte: case gltf_unsigned_byte: return 1;
+    case gltf_short: case gltf_unsigned_short: return 2;
+    case gltf_unsigned_int: case gltf_float: return 4;
+    default: return 0;
+    }
+}
+
+static glb_accessor find_accessor_glb(glb_content const& glb,int const index)
+{
+    json_value const& json = glb.json["accessors"][index];
+    std::string const error_message = "Incorrect accessor "+std::to_string(index)+" in file "+glb.filename;
+
+    glb_accessor a;
+    a.data = nullptr;
+    a.count = json["count"].as_int();
+    a.components = number_of_components_glb(json["type"].as_string());
+    a.component_type = json["componentType"].as_int();
+    a.size_component = size_of_component_glb(a.component_type);
+    a.normalized = json.get("normalized",json_value(false)).as_bool();
+    a.stride = a.components*a.size_component;
+    if(a.count<0 || a.components==0 || a.size_component==0)
+        throw exception_cpe(error_message,EXCEPTION_PARAMETERS_CPE);
+    if(json.has("sparse"))
+        throw exception_cpe("Sparse accessors are not handled (accessor "+std::to_string(index)+" in file "+glb.filename+")",EXCEPTION_PARAMETERS_CPE);
+
+    if(!json.has("bufferView"))
+        return a;
+
+    json_value const& view = glb.json["bufferViews"][json["bufferView"].as_int()];
+    int const buffer = view["buffer"].as_int();
+    if(buffer!=0 || glb.bin==nullptr || glb.json["buffers"][0].has("uri"))
+        throw exception_cpe("Only the binary chunk of the glb file can be used as a buffer (file "+glb.filename+")",EXCEPTION_PARAMETERS_CPE);
+
+    std::size_t const offset_view = view.get("byteOffset",json_value(0)).as_int();
+    std::size_t const size_view = view["byteLength"].as_int();
+    std::size_t const offset_accessor = json.get("byteOffset",json_value(0)).as_int();
+    if(view.has("byteStride"))
+        a.stride = view["byteStride"].as_int();
+
+    std::size_t const size_element = a.components*a.size_component;
+    std::size_t const size_used = a.count==0? 0 : offset_accessor+a.stride*(a.count-1)+size_element;
+    if(offset_view+size_view>glb.size_bin || size_used>size_view || a.stride<size_element)
+        throw exception_cpe(error_message,EXCEPTION_PARAMETERS_CPE);
+
+    a.data = glb.bin+offset_view+offset_accessor;
+    return a;
+}
+
+/** Value of a component converted into a float (the normalized integers are mapped into [0,1] or [-1,1]) */
+static float read_component_glb(glb_accessor const& a,char const* const data)
+{
+    switch(a.component_type)
+    {
+    case gltf_byte:
+    {
+        std::int8_t v; std::memcpy(&v,data,sizeof(v));
+        return a.normalized? std::max(v/127.0f,-1.0f) : v;
+    }
+    case gltf_unsigned_byte:
+    {
+        std::uint8_t v; std::memcpy(&v,data,sizeof(v));
+        return a.normalized? v/255.0f : v;
+    }
+    case gltf_short:
+    {
+        std::int16_t v; std::memcpy(&v,data,sizeof(v));
+        return a.normalized? std::max(v/32767.0f,-1.0f) : v;
+    }
+    case gltf_unsigned_short:
+    {
+        std::uint16_t v; std::memcpy(&v,data,sizeof(v));
+        return a.normalized? v/65535.0f : v;
+    }
+    case gltf_unsigned_int:
+    {
+        std::uint32_t v; std::memcpy(&v,data,sizeof(v));
+        return static_cast<float>(v);
+    }
+    default:
+    {
+        float v; std::memcpy(&v,data,sizeof(v));
+        return v;
+    }
+    }
+}
+
+/** Read the N_component first components of the elements of an accessor into a float array (count*N_component values).
+ *  Tightly packed floats are copied at once from the binary chunk, the other layouts are converted value by value. */
+static void read_float_accessor_glb(glb_accessor const& a,int const N_component,float* const output)
+{
+    ASSERT_CPE(N_component<=a.components,"Accessor has not enough components");
+    std::size_t const N_value = static_cast<std::size_t>(a.count)*N_component;
+
+    if(a.data==nullptr)
+        std::fill(output,output+N_value,0.0f);
+    else if(a.component_type==gltf_float && a.components==N_component && a.stride==N_component*sizeof(float))
+        std::memcpy(output,a.data,N_value*sizeof(float));
+    else
+    {
+        for(int k=0 ; k<a.count ; ++k)
+            for(int c=0 ; c<N_component ; ++c)
+                output[k*N_component+c] = read_component_glb(a,a.data+k*a.stride+c*a.size_component);
+    }
+}
+
+/** Read the unsigned integer values of an accessor (indices, joints) */
+static std::vector<int> read_index_accessor_glb(glb_accessor const& a,std::string const& filename)
+{
+    if(a.normalized || a.component_type==gltf_byte || a.component_type==gltf_short || a.component_type==gltf_float)
+        throw exception_cpe("Indices must be stored as unsigned integers in file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    std::vector<int> values(static_cast<std::size_t>(a.count)*a.components,0);
+    if(a.data==nullptr)
+        return values;
+    for(int k=0 ; k<a.count ; ++k)
+        for(int c=0 ; c<a.components ; ++c)
+            values[k*a.components+c] = static_cast<int>(read_component_glb(a,a.data+k*a.stride+c*a.size_component));
+    return values;
+}
+
+/** Find the accessor of a given attribute of a primitive, and check its number of components */
+static glb_accessor find_attribute_glb(glb_content const& glb,json_value const& attributes,std::string const& name,
+                                       int const N_component_min,int const N_component_max,int const N_vertex)
+{
+    glb_accessor const a = find_accessor_glb(glb,attributes[name].as_int());
+    if(a.components<N_component_min || a.components>N_component_max || (N_vertex>=0 && a.count!=N_vertex))
+        throw exception_cpe("Incorrect attribute "+name+" in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+    return a;
+}
+
+/** Compose two frames: the frame local is expressed in the frame parent */
+static skeleton_joint compose_joint_glb(skeleton_joint const& parent,skeleton_joint const& local)
+{
+    return skeleton_joint(parent.orientation*local.position+parent.position,parent.orientation*local.orientation);
+}
+
+/** Express the frame child in the frame parent (inverse of compose_joint_glb) */
+static skeleton_joint relative_joint_glb(skeleton_joint const& parent,skeleton_joint const& child)
+{
+    quaternion const q_inv = conjugated(parent.orientation);
+    return skeleton_joint(q_inv*(child.position-parent.position),q_inv*child.orientation);
+}
+
+/** Convert a rigid transformation matrix into a frame, throw if it contains a scaling or a shearing.
+ *  The rotation is converted into a quaternion with Shepperd's method (numerically stable for any angle). */
+static skeleton_joint matrix_to_joint_glb(mat4 const& m,std::string const& filename)
+{
+    float const tolerance = 1e-3f;
+    for(int c0=0 ; c0<3 ; ++c0)
+    {
+        for(int c1=c0 ; c1<3 ; ++c1)
+        {
+            float const d = m(0,c0)*m(0,c1)+m(1,c0)*m(1,c1)+m(2,c0)*m(2,c1);
+            if(std::abs(d-(c0==c1? 1.0f : 0.0f))>tolerance)
+                throw exception_cpe("Only rigid transformations of the joints are handled (file "+filename+")",EXCEPTION_PARAMETERS_CPE);
+        }
+    }
+
+    float const trace = m(0,0)+m(1,1)+m(2,2);
+    quaternion q;
+    if(trace>0.0f)
+    {
+        float const s = 2.0f*std::sqrt(1.0f+trace);
+        q = quaternion((m(2,1)-m(1,2))/s,(m(0,2)-m(2,0))/s,(m(1,0)-m(0,1))/s,0.25f*s);
+    }
+    else if(m(0,0)>m(1,1) && m(0,0)>m(2,2))
+    {
+        float const s = 2.0f*std::sqrt(1.0f+m(0,0)-m(1,1)-m(2,2));
+        q = quaternion(0.25f*s,(m(0,1)+m(1,0))/s,(m(0,2)+m(2,0))/s,(m(2,1)-m(1,2))/s);
+    }
+    else if(m(1,1)>m(2,2))
+    {
+        float const s = 2.0f*std::sqrt(1.0f+m(1,1)-m(0,0)-m(2,2));
+        q = quaternion((m(0,1)+m(1,0))/s,0.25f*s,(m(1,2)+m(2,1))/s,(m(0,2)-m(2,0))/s);
+    }
+    else
+    {
+        float const s = 2.0f*std::sqrt(1.0f+m(2,2)-m(0,0)-m(1,1));
+        q = quaternion((m(0,2)+m(2,0))/s,(m(1,2)+m(2,1))/s,0.25f*s,(m(1,0)-m(0,1))/s);
+    }
+
+    return skeleton_joint(vec3(m(0,3),m(1,3),m(2,3)),normalized(q));
+}
+
+/** Check that the scaling of a node is the identity (only rigid joints are handled) */
+static void check_unit_scale_glb(float const* const scale,std::string const& filename)
+{
+    for(int k=0 ; k<3 ; ++k)
+        if(std::abs(scale[k]-1.0f)>1e-3f)
+            throw exception_cpe("Only rigid transformations of the joints are handled (scaling in file "+filename+")",EXCEPTION_PARAMETERS_CPE);
+}
+
+/** Frame of a node with respect to its parent, given by its matrix or by its translation and rotation */
+static skeleton_joint node_frame_glb(json_value const& node,std::string const& filename)
+{
+    if(node.has("matrix"))
+    {
+        json_value const& values = node["matrix"];
+        mat4 m;
+        for(int k=0 ; k<16 ; ++k)
+            m[k] = values[k].as_number(); //both column major
+        return matrix_to_joint_glb(m,filename);
+    }
+
+    skeleton_joint frame;
+    if(node.has("translation"))
+    {
+        json_value const& t = node["translation"];
+        frame.position = vec3(t[0].as_number(),t[1].as_number(),t[2].as_number());
+    }
+    if(node.has("rotation"))
+    {
+        json_value const& r = node["rotation"];
+        frame.orientation = normalized(quaternion(r[0].as_number(),r[1].as_number(),r[2].as_number(),r[3].as_number()));
+    }
+    if(node.has("scale"))
+    {
+        json_value const& s = node["scale"];
+        float const scale[3] = {static_cast<float>(s[0].as_number()),static_cast<float>(s[1].as_number()),static_cast<float>(s[2].as_number())};
+        check_unit_scale_glb(scale,filename);
+    }
+    return frame;
+}
+
+/** The joints of a skin, with the data needed to express their animated frames in the hierarchy of the skeleton */
+struct glb_skeleton
+{
+    std::vector<int> node_to_joint;         // index of the joint of each node (-1 if the node is not a joint)
+    std::vector<int> joint_to_node;         // node of each joint
+    std::vector<skeleton_joint> rest;       // frame of the node of each joint (with respect to its parent node)
+    std::vector<skeleton_joint> prefix;     // frame of the nodes between each joint and its parent joint (not animated)
+};
+
+static glb_skeleton read_skeleton_glb(glb_content const& glb,json_value const& skin,skinned_model& model)
+{
+    json_value const& nodes = glb.json["nodes"];
+    json_value const& joints = skin["joints"];
+    int const N_node = nodes.size();
+    int const N_joint = joints.size();
+
+    //parent of each node
+    json_value const no_children = json_value::array();
+    std::vector<int> parent_node(N_node,-1);
+    for(int k_node=0 ; k_node<N_node ; ++k_node)
+    {
+        json_value const& children = nodes[k_node].get("children",no_children);
+        for(int k=0 ; k<children.size() ; ++k)
+        {
+            int const child = children[k].as_int();
+            if(child<0 || child>=N_node || parent_node[child]!=-1)
+                throw exception_cpe("Incorrect hierarchy of nodes in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+            parent_node[child] = k_node;
+        }
+    }
+
+    glb_skeleton skeleton;
+    skeleton.node_to_joint.assign(N_node,-1);
+    for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+    {
+        int const node = joints[k_joint].as_int();
+        if(node<0 || node>=N_node || skeleton.node_to_joint[node]!=-1)
+            throw exception_cpe("Incorrect joint "+std::to_string(k_joint)+" in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        skeleton.node_to_joint[node] = k_joint;
+        skeleton.joint_to_node.push_back(node);
+    }
+
+    //the frames of the nodes that are not joints are gathered with the first joint below them
+    for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+    {
+        int const node = skeleton.joint_to_node[k_joint];
+        skeleton_joint prefix;
+        int ancestor = parent_node[node];
+        while(ancestor!=-1 && skeleton.node_to_joint[ancestor]==-1)
+        {
+            prefix = compose_joint_glb(node_frame_glb(nodes[ancestor],glb.filename),prefix);
+            ancestor = parent_node[ancestor];
+        }
+
+        int const parent = ancestor==-1? -1 : skeleton.node_to_joint[ancestor];
+        model.parent_id.push_back(parent);
+
+        skeleton.prefix.push_back(prefix);
+        skeleton.rest.push_back(node_frame_glb(nodes[node],glb.filename));
+    }
+
+    try
+    {
+        model.parent_id.validate();
+    }
+    catch(exception_cpe const& e)
+    {
+        throw exception_cpe("Incorrect skin in file "+glb.filename+": "+e.info(),EXCEPTION_PARAMETERS_CPE);
+    }
+
+    //bind pose
+    if(skin.has("inverseBindMatrices"))
+    {
+        glb_accessor const a = find_accessor_glb(glb,skin["inverseBindMatrices"].as_int());
+        if(a.components!=16 || a.count<N_joint)
+            throw exception_cpe("Incorrect inverse bind matrices in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        std::vector<float> values(16*a.count);
+        read_float_accessor_glb(a,16,&values[0]);
+
+        for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+        {
+            mat4 m;
+            for(int k=0 ; k<16 ; ++k)
+                m[k] = values[16*k_joint+k];
+            model.bind_pose.push_back(matrix_to_joint_glb(inverted(m),glb.filename));
+        }
+    }
+    else
+    {
+        //the joints may be stored before their parent (reordered by load_skinned_model_file_glb): the chain of parents is followed
+        skeleton_geometry rest_local;
+        for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+            rest_local.push_back(compose_joint_glb(skeleton.prefix[k_joint],skeleton.rest[k_joint]));
+        for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+        {
+            skeleton_joint global = rest_local[k_joint];
+            for(int parent=model.parent_id[k_joint] ; parent!=-1 ; parent=model.parent_id[parent])
+                global = compose_joint_glb(rest_local[parent],global);
+            model.bind_pose.push_back(global);
+        }
+    }
+
+    return skeleton;
+}
+
+/** Read the skinning weights of the vertices of a primitive: the WEIGHTS_PER_VERTEX largest influences
+ *  given by the sets JOINTS_k/WEIGHTS_k are kept, and normalized */
+static void read_weights_glb(glb_content const& glb,json_value const& attributes,int const N_vertex,int const N_joint,
+                             vertex_weight_parameter* const output)
+{
+    int N_set = 0;
+    while(attributes.has("JOINTS_"+std::to_string(N_set)) && attributes.has("WEIGHTS_"+std::to_string(N_set)))
+        ++N_set;
+    if(N_set==0)
+        throw exception_cpe("Missing skinning weights (JOINTS_0 and WEIGHTS_0) in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+
+    int const N_influence = 4*N_set;
+    std::vector<int> joint(static_cast<std::size_t>(N_influence)*N_vertex);
+    std::vector<float> weight(static_cast<std::size_t>(N_influence)*N_vertex);
+    for(int k_set=0 ; k_set<N_set ; ++k_set)
+    {
+        std::string const suffix = std::to_string(k_set);
+        glb_accessor const a_joint  = find_attribute_glb(glb,attributes,"JOINTS_"+suffix,4,4,N_vertex);
+        glb_accessor const a_weight = find_attribute_glb(glb,attributes,"WEIGHTS_"+suffix,4,4,N_vertex);
+        std::vector<int> const joint_set = read_index_accessor_glb(a_joint,glb.filename);
+        std::vector<float> weight_set(4*N_vertex);
+        if(N_vertex>0)
+            read_float_accessor_glb(a_weight,4,&weight_set[0]);
+
+        for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+        {
+            for(int k=0 ; k<4 ; ++k)
+            {
+                joint [k_vertex*N_influence+4*k_set+k] = joint_set[4*k_vertex+k];
+                weight[k_vertex*N_influence+4*k_set+k] = weight_set[4*k_vertex+k];
+            }
+        }
+    }
+
+    std::vector<skinning_weight> influence(N_influence);
+    for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+    {
+        for(int k=0 ; k<N_influence ; ++k)
+        {
+            influence[k].joint_id = joint[k_vertex*N_influence+k];
+            influence[k].weight = weight[k_vertex*N_influence+k];
+            if(influence[k].weight!=0.0f && (influence[k].joint_id<0 || influence[k].joint_id>=N_joint))
+                throw exception_cpe("Incorrect joint index ("+std::to_string(influence[k].joint_id)+") in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        }
+
+        int const N_kept = std::min(N_influence,WEIGHTS_PER_VERTEX);
+        std::partial_sort(influence.begin(),influence.begin()+N_kept,influence.end(),
+                          [](skinning_weight const& a,skinning_weight const& b){return a.weight>b.weight;});
+
+        vertex_weight_parameter w;
+        for(int k=0 ; k<N_kept ; ++k)
+            if(influence[k].weight>0.0f)
+                w[k] = influence[k];
+        output[k_vertex] = normalized(w);
+    }
+}
+
+/** Read all the triangle primitives of a mesh, merged into a single skinned mesh */
+static void read_mesh_glb(glb_content const& glb,json_value const& mesh_json,int const N_joint,mesh_skinned& m)
+{
+    std::vector<vec3> vertices,normals,colors;
+    std::vector<vec2> texture_coords;
+    std::vector<triangle_index> connectivity;
+    std::vector<vertex_weight_parameter> weights;
+
+    //the optional attributes are kept if all the primitives have them
+    bool has_normal = true;
+    bool has_color = true;
+    bool has_texture_coord = true;
+
+    json_value const& primitives = mesh_json["primitives"];
+    for(int k_primitive=0 ; k_primitive<primitives.size() ; ++k_primitive)
+    {
+        json_value const& primitive = primitives[k_primitive];
+        if(primitive.get("mode",json_value(4)).as_int()!=4)
+            throw exception_cpe("Only triangle primitives are handled in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        json_value const& attributes = primitive["attributes"];
+
+        glb_accessor const a_position = find_attribute_glb(glb,attributes,"POSITION",3,3,-1);
+        int const N_vertex = a_position.count;
+        int const offset = vertices.size();
+        if(N_vertex==0)
+            continue;
+
+        vertices.resize(offset+N_vertex);
+        read_float_accessor_glb(a_position,3,reinterpret_cast<float*>(&vertices[offset]));
+
+        has_normal = has_normal && attributes.has("NORMAL");
+        if(has_normal)
+        {
+            normals.resize(offset+N_vertex);
+            read_float_accessor_glb(find_attribute_glb(glb,attributes,"NORMAL",3,3,N_vertex),3,reinterpret_cast<float*>(&normals[offset]));
+        }
+
+        has_color = has_color && attributes.has("COLOR_0");
+        if(has_color)
+        {
+            colors.resize(offset+N_vertex);
+            read_float_accessor_glb(find_attribute_glb(glb,attributes,"COLOR_0",3,4,N_vertex),3,reinterpret_cast<float*>(&colors[offset]));
+        }
+
+        has_texture_coord = has_texture_coord && attributes.has("TEXCOORD_0");
+        if(has_texture_coord)
+        {
+            texture_coords.resize(offset+N_vertex);
+            read_float_accessor_glb(find_attribute_glb(glb,attributes,"TEXCOORD_0",2,2,N_vertex),2,reinterpret_cast<float*>(&texture_coords[offset]));
+            //the origin of the texture is at the top left corner in glTF
+            for(int k=offset ; k<offset+N_vertex ; ++k)
+                texture_coords[k].y() = 1.0f-texture_coords[k].y();
+        }
+
+        weights.resize(offset+N_vertex);
+        read_weights_glb(glb,attributes,N_vertex,N_joint,&weights[offset]);
+
+        if(!primitive.has("indices"))
+            throw exception_cpe("Only indexed primitives are handled in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        glb_accessor const a_index = find_accessor_glb(glb,primitive["indices"].as_int());
+        if(a_index.components!=1 || a_index.count%3!=0)
+            throw exception_cpe("Incorrect indices in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        std::vector<int> const index = read_index_accessor_glb(a_index,glb.filename);
+        for(int const u : index)
+            if(u>=N_vertex)
+                throw exception_cpe("Incorrect vertex index ("+std::to_string(u)+") in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+        for(std::size_t k=0 ; k<index.size() ; k+=3)
+            connectivity.push_back(triangle_index(offset+index[k],offset+index[k+1],offset+index[k+2]));
+    }
+
+    if(!has_normal) normals.clear();
+    if(!has_color) colors.clear();
+    if(!has_texture_coord) texture_coords.clear();
+
+    m.assign(std::move(vertices),std::move(normals),std::move(colors),std::move(texture_coords),std::move(connectivity));
+    m.assign_vertex_weight(std::move(weights));
+    m.fill_empty_field_by_default();
+}
+
+/** A channel of an animation modifying the translation or the rotation of a joint */
+struct glb_channel
+{
+    int joint;                  // animated joint
+    bool rotation;              // the values are rotations (quaternion x,y,z,w), otherwise translations
+    bool step;                  // the values are constant between two keys
+    bool cubic;                 // the values are stored with their tangents (in-tangent,value,out-tangent) for each key
+    std::vector<float> time;    // time of the keys
+    std::vector<float> value;   // values at the keys
+};
+
+/** Set the value of a channel at a given time in the frame of its joint.
+ *  The cubic splines are approximated by a linear interpolation of their values at the keys. */
+static void sample_channel_glb(glb_channel const& channel,float const t,skeleton_joint& frame)
+{
+    int const N_key = channel.time.size();
+    int const N_component = channel.rotation? 4 : 3;
+
+    int k0 = std::upper_bound(channel.time.begin(),channel.time.end(),t)-channel.time.begin()-1;
+    int k1 = k0+1;
+    float alpha = 0.0f;
+    if(k0<0)
+        k0 = k1 = 0;
+    else if(k1>=N_key)
+        k0 = k1 = N_key-1;
+    else if(!channel.step)
+        alpha = (t-channel.time[k0])/(channel.time[k1]-channel.time[k0]);
+
+    float const* const v0 = &channel.value[N_component*(channel.cubic? 3*k0+1 : k0)];
+    float const* const v1 = &channel.value[N_component*(channel.cubic? 3*k1+1 : k1)];
+    if(channel.rotation)
+        frame.orientation = normalized(slerp(quaternion(v0[0],v0[1],v0[2],v0[3]),quaternion(v1[0],v1[1],v1[2],v1[3]),alpha));
+    else
+        frame.position = (1.0f-alpha)*vec3(v0[0],v0[1],v0[2])+alpha*vec3(v1[0],v1[1],v1[2]);
+}
+
+static void read_animation_glb(glb_content const& glb,json_value const& animation,glb_skeleton const& skeleton,skinned_model& model)
+{
+    json_value const& samplers = animation["samplers"];
+    json_value const& channels_json = animation["channels"];
+
+    std::vector<glb_channel> channels;
+    std::vector<float> key_time;
+    for(int k_channel=0 ; k_channel<channels_json.size() ; ++k_channel)
+    {
+        json_value const& target = channels_json[k_channel]["target"];
+        if(!target.has("node"))
+            continue;
+        int const node = target["node"].as_int();
+        if(node<0 || node>=static_cast<int>(skeleton.node_to_joint.size()) || skeleton.node_to_joint[node]==-1)
+            continue; //only the joints are animated
+        std::string const& path = target["path"].as_string();
+        if(path!="translation" && path!="rotation" && path!="scale")
+            continue; //morph target weights
+
+        json_value const& sampler = samplers[channels_json[k_channel]["sampler"].as_int()];
+        std::string const interpolation = sampler.get("interpolation",json_value("LINEAR")).as_string();
+
+        glb_channel channel;
+        channel.joint = skeleton.node_to_joint[node];
+        channel.rotation = path=="rotation";
+        channel.step = interpolation=="STEP";
+        channel.cubic = interpolation=="CUBICSPLINE";
+
+        glb_accessor const a_time = find_accessor_glb(glb,sampler["input"].as_int());
+        glb_accessor const a_value = find_accessor_glb(glb,sampler["output"].as_int());
+        int const N_component = channel.rotation? 4 : 3;
+        if(a_time.components!=1 || a_time.count==0 || a_value.components!=N_component || a_value.count!=(channel.cubic? 3 : 1)*a_time.count)
+            throw exception_cpe("Incorrect animation sampler in file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+
+        channel.time.resize(a_time.count);
+        channel.value.resize(N_component*a_value.count);
+        read_float_accessor_glb(a_time,1,&channel.time[0]);
+        read_float_accessor_glb(a_value,N_component,&channel.value[0]);
+
+        if(path=="scale")
+        {
+            for(int k=0 ; k<a_value.count ; ++k)
+                if(!channel.cubic || k%3==1)
+                    check_unit_scale_glb(&channel.value[3*k],glb.filename);
+            continue;
+        }
+
+        key_time.insert(key_time.end(),channel.time.begin(),channel.time.end());
+        channels.push_back(std::move(channel));
+    }
+    if(key_time.size()==0)
+        return;
+
+    //the keyframes are regularly spaced with the smallest interval between two keys of the samplers
+    std::sort(key_time.begin(),key_time.end());
+    key_time.erase(std::unique(key_time.begin(),key_time.end(),[](float a,float b){return b-a<=1e-4f;}),key_time.end());
+    float const time_start = key_time.front();
+    float const time_end = key_time.back();
+    float interval = time_end-time_start;
+    for(std::size_t k=1 ; k<key_time.size() ; ++k)
+        interval = std::min(interval,key_time[k]-key_time[k-1]);
+
+    int N_keyframe = 1;
+    if(interval>0.0f)
+    {
+        N_keyframe = static_cast<int>(std::round((time_end-time_start)/interval))+1;
+        model.keyframe_duration = interval;
+    }
+    if(N_keyframe>100000)
+        throw exception_cpe("Too many keyframes in the animation of file "+glb.filename,EXCEPTION_PARAMETERS_CPE);
+
+    int const N_joint = skeleton.rest.size();
+    for(int k_frame=0 ; k_frame<N_keyframe ; ++k_frame)
+    {
+        //the keys are used directly when they are already regularly spaced
+        float const t = static_cast<int>(key_time.size())==N_keyframe? key_time[k_frame] : std::min(time_start+k_frame*interval,time_end);
+
+        std::vector<skeleton_joint> frame = skeleton.rest;
+        for(glb_channel const& channel : channels)
+            sample_channel_glb(channel,t,frame[channel.joint]);
+
+        skeleton_geometry keyframe;
+        for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+            keyframe.push_back(compose_joint_glb(skeleton.prefix[k_joint],frame[k_joint]));
+        model.animation.push_back(keyframe);
+    }
+}
+
+skinned_model load_skinned_model_file_glb(std::string const& filename)
+{
+    if(!is_little_endian_host())
+        throw exception_cpe("Glb files can only be read on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    glb_content glb;
+    open_file_glb(glb,filename);
+    json_value const& json = glb.json;
+    json_value const no_nodes = json_value::array();
+    json_value const& nodes = json.get("nodes",no_nodes);
+
+    //the first node with a skinned mesh
+    int node_mesh = -1;
+    for(int k=0 ; k<nodes.size() && node_mesh==-1 ; ++k)
+        if(nodes[k].has("mesh") && nodes[k].has("skin"))
+            node_mesh = k;
+    if(node_mesh==-1)
+        throw exception_cpe("No skinned mesh in file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    skinned_model model;
+    json_value const& skin = json["skins"][nodes[node_mesh]["skin"].as_int()];
+    glb_skeleton const skeleton = read_skeleton_glb(glb,skin,model);
+    read_mesh_glb(glb,json["meshes"][nodes[node_mesh]["mesh"].as_int()],model.bind_pose.size(),model.mesh);
+    if(json.has("animations") && json["animations"].size()>0)
+        read_animation_glb(glb,json["animations"][0],skeleton,model);
+
+    //the joints of a skin can be listed in any order: they are reordered to be stored after their parent
+    if(!model.parent_id.is_topologically_ordered())
+    {
+        std::vector<int> const new_to_old = model.parent_id.reorder_breadth_first();
+        model.bind_pose.remap_joints(new_to_old);
+        model.animation.remap_joints(new_to_old);
+        model.mesh.remap_joints(new_to_old);
+    }
+
+    ASSERT_CPE(model.mesh.valid_mesh(),"Mesh is invalid");
+    return model;
+}
+
+/** Binary chunk of a glb file being written, with the description of its buffer views and accessors */
+struct glb_writer
+{
+    std::vector<char> bin;
+    json_value buffer_views;
+    json_value accessors;
+};
+
+/** Add the given data in a new buffer view and an accessor on it, return the index of the accessor */
+static int add_accessor_glb(glb_writer& writer,void const* const data,int const count,std::string const& type,
+                            int const component_type,int const target,json_value const& min=json_value(),json_value const& max=json_value())
+{
+    std::size_t const size = static_cast<std::size_t>(count)*number_of_components_glb(type)*size_of_component_glb(component_type);
+    std::size_t const offset = writer.bin.size();
+    writer.bin.resize(offset+((size+3)/4)*4,0);
+    if(size>0)
+        std::memcpy(&writer.bin[offset],data,size);
+
+    json_value view = json_value::object();
+    view.set("buffer",0);
+    view.set("byteOffset",offset);
+    view.set("byteLength",size);
+    if(target!=0)
+        view.set("target",target);
+    writer.buffer_views.push_back(view);
+
+    json_value accessor = json_value::object();
+    accessor.set("bufferView",writer.buffer_views.size()-1);
+    accessor.set("componentType",component_type);
+    accessor.set("count",count);
+    accessor.set("type",type);
+    if(!min.is_null())
+        accessor.set("min",min);
+    if(!max.is_null())
+        accessor.set("max",max);
+    writer.accessors.push_back(accessor);
+
+    return writer.accessors.size()-1;
+}
+
+static json_value json_array_glb(float const* const values,int const N)
+{
+    json_value array = json_value::array();
+    for(int k=0 ; k<N ; ++k)
+        array.push_back(static_cast<double>(values[k]));
+    return array;
+}
+
+void save_skinned_model_file_glb(std::string const& filename,skinned_model const& model)
+{
+    if(!is_little_endian_host())
+        throw exception_cpe("Glb files can only be written on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    mesh_skinned const& m = model.mesh;
+    int const N_vertex = m.size_vertex();
+    int const N_joint = model.bind_pose.size();
+    ASSERT_CPE(m.size_vertex_weight()==N_vertex,"Skinned mesh has incorrect number of weights");
+    ASSERT_CPE(model.parent_id.size()==N_joint,"Incorrect skeleton size");
+
+    glb_writer writer;
+    writer.buffer_views = json_value::array();
+    writer.accessors = json_value::array();
+
+    //mesh in its rest pose
+    json_value attributes = json_value::object();
+    {
+        vec3 p_min,p_max;
+        if(N_vertex>0)
+            p_min = p_max = m.vertex_original(0);
+        for(int k=1 ; k<N_vertex ; ++k)
+        {
+            vec3 const& p = m.vertex_original(k);
+            p_min = vec3(std::min(p_min.x(),p.x()),std::min(p_min.y(),p.y()),std::min(p_min.z(),p.z()));
+            p_max = vec3(std::max(p_max.x(),p.x()),std::max(p_max.y(),p.y()),std::max(p_max.z(),p.z()));
+        }
+        attributes.set("POSITION",add_accessor_glb(writer,m.pointer_vertex_original(),N_vertex,"VEC3",gltf_float,gltf_array_buffer,
+                                                   json_array_glb(p_min.pointer(),3),json_array_glb(p_max.pointer(),3)));
+    }
+    if(m.size_normal()==N_vertex)
+        attributes.set("NORMAL",add_accessor_glb(writer,m.pointer_normal(),N_vertex,"VEC3",gltf_float,gltf_array_buffer));
+    if(m.size_texture_coord()==N_vertex)
+    {
+        float const* const t = m.pointer_texture_coord();
+        std::vector<float> texture_coords(2*N_vertex);
+        for(int k=0 ; k<N_vertex ; ++k)
+        {
+            texture_coords[2*k]   = t[2*k];
+            texture_coords[2*k+1] = 1.0f-t[2*k+1];
+        }
+        attributes.set("TEXCOORD_0",add_accessor_glb(writer,texture_coords.data(),N_vertex,"VEC2",gltf_float,gltf_array_buffer));
+    }
+    if(m.size_color()==N_vertex)
+        attributes.set("COLOR_0",add_accessor_glb(writer,m.pointer_color(),N_vertex,"VEC3",gltf_float,gltf_array_buffer));
+
+    //skinning weights, by sets of 4
+    int const N_set = (WEIGHTS_PER_VERTEX+3)/4;
+    bool const joint_as_byte = N_joint<=256;
+    for(int k_set=0 ; k_set<N_set ; ++k_set)
+    {
+        std::vector<std::uint8_t> joint_byte(joint_as_byte? 4*N_vertex : 0,0);
+        std::vector<std::uint16_t> joint_short(joint_as_byte? 0 : 4*N_vertex,0);
+        std::vector<float> weight(4*N_vertex,0.0f);
+        for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+        {
+            vertex_weight_parameter const& w = m.vertex_weight(k_vertex);
+            for(int k=0 ; k<4 && 4*k_set+k<WEIGHTS_PER_VERTEX ; ++k)
+            {
+                skinning_weight const& s = w[4*k_set+k];
+                ASSERT_CPE(s.joint_id>=0 && s.joint_id<N_joint,"Incorrect joint index in skinning weights");
+                if(joint_as_byte)
+                    joint_byte[4*k_vertex+k] = s.joint_id;
+                else
+                    joint_short[4*k_vertex+k] = s.joint_id;
+                weight[4*k_vertex+k] = s.weight;
+            }
+        }
+
+        std::string const suffix = std::to_string(k_set);
+        if(joint_as_byte)
+            attributes.set("JOINTS_"+suffix,add_accessor_glb(writer,joint_byte.data(),N_vertex,"VEC4",gltf_unsigned_byte,gltf_array_buffer));
+        else
+            attributes.set("JOINTS_"+suffix,add_accessor_glb(writer,joint_short.data(),N_vertex,"VEC4",gltf_unsigned_short,gltf_array_buffer));
+        attributes.set("WEIGHTS_"+suffix,add_accessor_glb(writer,weight.data(),N_vertex,"VEC4",gltf_float,gltf_array_buffer));
+    }
+
+    json_value primitive = json_value::object();
+    primitive.set("attributes",attributes);
+    primitive.set("indices",add_accessor_glb(writer,m.pointer_triangle_index(),3*m.size_connectivity(),"SCALAR",gltf_unsigned_int,gltf_element_array_buffer));
+    primitive.set("mode",4);
+    json_value primitives = json_value::array();
+    primitives.push_back(primitive);
+    json_value mesh_json = json_value::object();
+    mesh_json.set("primitives",primitives);
+
+    //skeleton: one node per joint storing its rest frame with respect to its parent, the mesh is the last node
+    std::vector<float> inverse_bind_matrices;
+    std::vector<json_value> nodes(N_joint+1,json_value::object());
+    json_value scene_nodes = json_value::array();
+    json_value skin_joints = json_value::array();
+    for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+    {
+        int const parent = model.parent_id[k_joint];
+        ASSERT_CPE(parent<k_joint,"The parent of a joint must be stored before it");
+        skeleton_joint const& bind = model.bind_pose[k_joint];
+        skeleton_joint const local = parent==-1? bind : relative_joint_glb(model.bind_pose[parent],bind);
+
+        nodes[k_joint].set("name","joint_"+std::to_string(k_joint));
+        nodes[k_joint].set("translation",json_array_glb(local.position.pointer(),3));
+        quaternion const q = normalized(local.orientation);
+        float const rotation[4] = {q.x(),q.y(),q.z(),q.w()};
+        nodes[k_joint].set("rotation",json_array_glb(rotation,4));
+        if(parent==-1)
+            scene_nodes.push_back(k_joint);
+        else
+        {
+            if(!nodes[parent].has("children"))
+                nodes[parent].set("children",json_value::array());
+            json_value children = nodes[parent]["children"];
+            children.push_back(k_joint);
+            nodes[parent].set("children",children);
+        }
+        skin_joints.push_back(k_joint);
+
+        mat4 const inverse_bind = relative_joint_glb(bind,skeleton_joint()).to_mat4();
+        inverse_bind_matrices.insert(inverse_bind_matrices.end(),inverse_bind.pointer(),inverse_bind.pointer()+16);
+    }
+    nodes[N_joint].set("name","mesh");
+    nodes[N_joint].set("mesh",0);
+    nodes[N_joint].set("skin",0);
+    scene_nodes.push_back(N_joint);
+
+    json_value skin = json_value::object();
+    skin.set("inverseBindMatrices",add_accessor_glb(writer,inverse_bind_matrices.data(),N_joint,"MAT4",gltf_float,0));
+    skin.set("joints",skin_joints);
+
+    //animation: one sampler per joint for the translation and for the rotation, sharing the same key times
+    json_value animations = json_value::array();
+    int const N_keyframe = model.animation.size();
+    if(N_keyframe>0 && N_joint>0)
+    {
+        std::vector<float> time(N_keyframe);
+        for(int k=0 ; k<N_keyframe ; ++k)
+            time[k] = k*model.keyframe_duration;
+        int const accessor_time = add_accessor_glb(writer,time.data(),N_keyframe,"SCALAR",gltf_float,0,
+                                                   json_array_glb(&time.front(),1),json_array_glb(&time.back(),1));
+
+        json_value samplers = json_value::array();
+        json_value channels = json_value::array();
+        std::vector<vec3> translation(N_keyframe);
+        std::vector<float> rotation(4*N_keyframe);
+        for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+        {
+            for(int k=0 ; k<N_keyframe ; ++k)
+            {
+                ASSERT_CPE(model.animation[k].size()==N_joint,"Keyframe has incorrect number of joints");
+                skeleton_joint const& joint = model.animation[k][k_joint];
+                translation[k] = joint.position;
+                for(int c=0 ; c<4 ; ++c)
+                    rotation[4*k+c] = joint.orientation[c];
+            }
+
+            int const accessor_translation = add_accessor_glb(writer,translation.data(),N_keyframe,"VEC3",gltf_float,0);
+            int const accessor_rotation = add_accessor_glb(writer,rotation.data(),N_keyframe,"VEC4",gltf_float,0);
+            for(int k_path=0 ; k_path<2 ; ++k_path)
+            {
+                json_value sampler = json_value::object();
+                sampler.set("input",accessor_time);
+                sampler.set("output",k_path==0? accessor_translation : accessor_rotation);
+                sampler.set("interpolation","LINEAR");
+
+                json_value target = json_value::object();
+                target.set("node",k_joint);
+                target.set("path",k_path==0? "translation" : "rotation");
+                json_value channel = json_value::object();
+                channel.set("sampler",samplers.size());
+                channel.set("target",target);
+
+                samplers.push_back(sampler);
+                channels.push_back(channel);
+            }
+        }
+
+        json_value animation = json_value::object();
+        animation.set("samplers",samplers);
+        animation.set("channels",channels);
+        animations.push_back(animation);
+    }
+
+    //json description
+    json_value json = json_value::object();
+    json_value asset = json_value::object();
+    asset.set("version","2.0");
+    asset.set("generator","cpe");
+    json.set("asset",asset);
+    json.set("scene",0);
+    json_value scene = json_value::object();
+    scene.set("nodes",scene_nodes);
+    json_value scenes = json_value::array();
+    scenes.push_back(scene);
+    json.set("scenes",scenes);
+    json_value nodes_json = json_value::array();
+    for(json_value const& node : nodes)
+        nodes_json.push_back(node);
+    json.set("nodes",nodes_json);
+    json_value meshes = json_value::array();
+    meshes.push_back(mesh_json);
+    json.set("meshes",meshes);
+    json_value skins = json_value::array();
+    skins.push_back(skin);
+    json.set("skins",skins);
+    if(animations.size()>0)
+        json.set("animations",animations);
+    json_value buffer = json_value::object();
+    buffer.set("byteLength",writer.bin.size());
+    json_value buffers = json_value::array();
+    buffers.push_back(buffer);
+    json.set("buffers",buffers);
+    json.set("bufferViews",writer.buffer_views);
+    json.set("accessors",writer.accessors);
+
+    //the chunks are aligned on 4 bytes: the json is padded with spaces, the binary chunk is already padded with zeros
+    std::string text = json.dump();
+    text.resize(((text.size()+3)/4)*4,' ');
+
+    std::uint32_t const size_total = 12+8+text.size()+8+writer.bin.size();
+    std::uint32_t const header[3] = {glb_magic,2,size_total};
+    std::uint32_t const header_json[2] = {static_cast<std::uint32_t>(text.size()),glb_chunk_json};
+    std::uint32_t const header_bin[2] = {static_cast<std::uint32_t>(writer.bin.size()),glb_chunk_bin};
+
+    std::ofstream fid(filename.c_str(),std::ios::binary);
+    if(!fid.good())
+        throw exception_cpe("Cannot open file "+filename,EXCEPTION_PARAMETERS_CPE);
+    fid.write(reinterpret_cast<char const*>(header),sizeof(header));
+    fid.write(reinterpret_cast<char const*>(header_json),sizeof(header_json));
+    fid.write(text.data(),text.size());
+    fid.write(reinterpret_cast<char const*>(header_bin),sizeof(header_bin));
+    if(writer.bin.size()>0)
+        fid.write(&writer.bin[0],writer.bin.size());
+    if(!fid.good())
+        throw exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+}
+
+}
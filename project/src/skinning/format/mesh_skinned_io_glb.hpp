@@ -0,0 +1,64 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef MESH_SKINNED_IO_GLB_HPP
+#define MESH_SKINNED_IO_GLB_HPP
+
+#include "../mesh_skinned.hpp"
+#include "../skeleton_parent_id.hpp"
+#include "../skeleton_geometry.hpp"
+#include "../skeleton_animation.hpp"
+
+#include <string>
+
+namespace cpe
+{
+
+/** A skinned mesh with its skeleton and its animation, as stored in a glTF file */
+struct skinned_model
+{
+    skinned_model();
+
+    mesh_skinned mesh;              // mesh in its rest pose with its skinning weights
+    skeleton_parent_id parent_id;   // hierarchy of the joints (the parent of a joint is stored before it)
+    skeleton_geometry bind_pose;    // frames of the joints in the rest pose, in global coordinates
+    skeleton_animation animation;   // keyframes of the frames of the joints, with respect to their parent
+    float keyframe_duration;        // duration between two keyframes (in seconds)
+};
+
+/** Load the first skinned mesh of a glTF 2.0 binary file (.glb), with its skin and its first animation.
+ *  - The primitives of the mesh are merged, JOINTS_0/WEIGHTS_0 (and JOINTS_1/WEIGHTS_1) give the skinning weights:
+ *    the WEIGHTS_PER_VERTEX largest ones are kept.
+ *  - The bind pose is given by the inverse bind matrices (or the rest pose of the nodes if they are not provided).
+ *  - The animation is resampled at regular keyframes, the smallest interval between two key times of its samplers.
+ *  Only rigid joints are handled (throw on a scaling). The hierarchy is validated, and if a joint of the skin is stored before
+ *   its parent the joints are reordered in breadth-first order (see skeleton_parent_id::reorder_breadth_first):
+ *   the mesh, the bind pose and the animation of the model always follow the order of parent_id.
+ *  The float data stored with the expected layout are copied in a single block from the mapped binary chunk. */
+skinned_model load_skinned_model_file_glb(std::string const& filename);
+
+/** Save a skinned model as a glTF 2.0 binary file (.glb): the rest pose of the mesh, the skeleton as a hierarchy of nodes,
+ *  and the keyframes as a single animation with linear interpolation.
+ *  pgm_bake uses it to convert the legacy files (obj, .skeleton and .animations) when its output is a .glb file. */
+void save_skinned_model_file_glb(std::string const& filename,skinned_model const& model);
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_skinned_io_ply.hpp"
+
+#include "../mesh_skinned.hpp"
+#include "../../lib/common/error_handling.hpp"
+
+#include <utility>
+
+namespace cpe
+{
+
+/** Name of the property storing the joint (or the weight) of the k-th skinning weight of the vertices */
+static std::string skinning_property_name(std::string const& prefix,int const k)
+{
+    return prefix+"_"+std::to_string(k);
+}
+
+mesh_skinned load_mesh_skinned_file_ply(std::string const& filename)
+{
+    ply_structure ply = load_file_ply_structure(filename);
+    int const N_vertex = ply.data_vertex.size();
+
+    std::vector<vertex_weight_parameter> weights(N_vertex);
+    for(int k=0 ; k<WEIGHTS_PER_VERTEX ; ++k)
+    {
+        ply_vertex_property const* const joint  = ply.find_vertex_property(skinning_property_name("joint",k));
+        ply_vertex_property const* const weight = ply.find_vertex_property(skinning_property_name("weight",k));
+        if(joint==nullptr || weight==nullptr)
+            throw exception_cpe("Missing skinning weight "+std::to_string(k)+" in file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+        for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+        {
+            weights[k_vertex][k].joint_id = static_cast<int>(joint->value[k_vertex]);
+            weights[k_vertex][k].weight   = weight->value[k_vertex];
+        }
+    }
+
+    mesh_skinned m;
+    m.assign(std::move(ply.data_vertex),std::move(ply.data_normal),std::move(ply.data_color),
+             std::move(ply.data_texture),std::move(ply.data_triangle));
+    m.assign_vertex_weight(std::move(weights));
+
+    m.fill_empty_field_by_default();
+    ASSERT_CPE(m.valid_mesh(),"Mesh is invalid");
+
+    return m;
+}
+
+void save_mesh_skinned_file_ply(std::string const& filename,mesh_skinned const& m,ply_format const format)
+{
+    int const N_vertex = m.size_vertex();
+    ASSERT_CPE(m.size_vertex_weight()==N_vertex,"Skinned mesh has incorrect number of weights");
+
+    //the rest pose is saved: the skinning is applied again after loading
+    ply_structure ply = build_ply_structure(m);
+    for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+        ply.data_vertex[k_vertex] = m.vertex_original(k_vertex);
+
+    for(int k=0 ; k<WEIGHTS_PER_VERTEX ; ++k)
+    {
+        ply_vertex_property joint  = {skinning_property_name("joint",k),ply_type::uint8,std::vector<float>(N_vertex)};
+        ply_vertex_property weight = {skinning_property_name("weight",k),ply_type::float32,std::vector<float>(N_vertex)};
+        for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+        {
+            skinning_weight const& w = m.vertex_weight(k_vertex)[k];
+            ASSERT_CPE(w.joint_id>=0 && w.joint_id<256,"Joint id cannot be stored in a ply file ("+std::to_string(w.joint_id)+")");
+            joint.value[k_vertex]  = static_cast<float>(w.joint_id);
+            weight.value[k_vertex] = w.weight;
+        }
+        ply.vertex_property.push_back(std::move(joint));
+        ply.vertex_property.push_back(std::move(weight));
+    }
+
+    save_file_ply_structure(filename,ply,format);
+}
+
+}
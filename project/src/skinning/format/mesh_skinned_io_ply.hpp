@@ -0,0 +1,40 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef MESH_SKINNED_IO_PLY_HPP
+#define MESH_SKINNED_IO_PLY_HPP
+
+#include <string>
+#include "../../lib/mesh/format/mesh_io_ply.hpp"
+
+namespace cpe
+{
+
+class mesh_skinned;
+
+/** Load a skinned mesh from a PLY file.
+ *  The skinning weights are the vertex properties joint_k (uchar) and weight_k (float) for k in [0,WEIGHTS_PER_VERTEX[. */
+mesh_skinned load_mesh_skinned_file_ply(std::string const& filename);
+/** Save a skinned mesh in its rest pose (original vertices) with its skinning weights in a PLY file */
+void save_mesh_skinned_file_ply(std::string const& filename,mesh_skinned const& m,ply_format format=ply_format::binary_little_endian);
+
+}
+
+#endif
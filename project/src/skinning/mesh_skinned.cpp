@@ -21,10 +21,17 @@
 
 #include "../lib/common/error_handling.hpp"
 #include "../lib/mesh/mesh_io.hpp"
+#include "../lib/mesh/format/mesh_io_obj.hpp"
 #include "skeleton_geometry.hpp"
+#include "skeleton_parent_id.hpp"
+#include "format/mesh_skinned_io_ply.hpp"
+#include "format/mesh_skinned_io_glb.hpp"
+#include "vertex_animation_cache.hpp"
+#include "vertex_animation_pca.hpp"
 
-#include <sstream>
-#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 
 namespace cpe
@@ -56,106 +63,59 @@ void mesh_skinned::add_vertex_weight(vertex_weight_parameter const& w)
 }
 
 
-void mesh_skinned::load(std::string const& filename)
+void mesh_skinned::load(std::string const& filename,obj_load_report* report)
 {
+    if(filename.find(".ply")!=std::string::npos || filename.find(".PLY")!=std::string::npos)
+    {
+        *this = load_mesh_skinned_file_ply(filename);
+        return;
+    }
+    if(filename.find(".glb")!=std::string::npos || filename.find(".GLB")!=std::string::npos)
+    {
+        *this = load_skinned_model_file_glb(filename).mesh;
+        return;
+    }
+
     //Warning: Can only handle meshes with same connectivity for vertex and textures
     //(Format de fichier de David Odin)
+    //the file is parsed in parallel, the vertex k is described by the k-th v, vt, vn and sk lines
+    obj_structure const obj = load_file_obj_structure(filename,report);
+
+    *this = mesh_skinned();
+    for(vec3 const& p : obj.data_vertex)
+        add_vertex(p);
+    for(vec2 const& t : obj.data_texture)
+        add_texture_coord(t);
+    for(vec3 const& n : obj.data_normal)
+        add_normal(n);
+
+    //only the vertex index of the corners is used, polygons are triangulated as fans
+    int const N_face = obj.size_face();
+    for(int k_face=0 ; k_face<N_face ; ++k_face)
+    {
+        int const first = obj.face_offset[k_face];
+        int const last = obj.face_offset[k_face+1];
+        for(int k=first+1 ; k<last-1 ; ++k)
+            add_triangle_index({obj.corner_vertex[first],obj.corner_vertex[k],obj.corner_vertex[k+1]});
+    }
 
-    std::ifstream fid(filename.c_str());
-    if(!fid.good())
-        throw exception_cpe("Cannot open file "+filename,MACRO_EXCEPTION_PARAMETER);
-
-    std::string buffer;
-
-    std::vector<vertex_weight_parameter> skinning_info;
-
-
-    //read the whole file
-    while(fid.good()==true)
+    //skinning: pairs of joint index and weight (the missing ones are kept at their default value)
+    int const N_skinning = obj.size_skinning();
+    for(int k_skinning=0 ; k_skinning<N_skinning ; ++k_skinning)
     {
-        //read line
-        std::getline(fid,buffer);
+        int const first = obj.skinning_offset[k_skinning];
+        int const N_value = obj.skinning_offset[k_skinning+1]-first;
 
-        if(buffer.size()>0)
+        vertex_weight_parameter temp_skinning;
+        int const N_bone = std::min(temp_skinning.size(),N_value/2);
+        for(int k_bone=0 ; k_bone<N_bone ; ++k_bone)
         {
-            std::stringstream tokens(buffer);
-            std::string first_word;
-            tokens >> first_word;
-
-            //skip comments
-            if(first_word.length()>0 && first_word[0]!='#')
-            {
-                //vertices
-                if(first_word=="v")
-                {
-                  vec3 vertex;
-                  tokens >> vertex.x();
-                  tokens >> vertex.y();
-                  tokens >> vertex.z();
-
-                  add_vertex(vertex);
-                }
-
-                //texture
-                if(first_word=="vt")
-                {
-                  vec2 texture;
-                  tokens >> texture.x();
-                  tokens >> texture.y();
-
-                  add_texture_coord(texture);
-                }
-
-                // normal
-                if(first_word=="vn")
-                {
-                  vec3 normal;
-                  tokens >> normal.x();
-                  tokens >> normal.y();
-                  tokens >> normal.z();
-
-                  add_normal(normal);
-                }
-
-                //skinning
-                if(first_word=="sk")
-                {
-                    vertex_weight_parameter temp_skinning;
-                    int const N_bone = temp_skinning.size();
-                    for(int k_bone=0 ; k_bone<N_bone ; ++k_bone)
-                    {
-                        tokens >> temp_skinning[k_bone].joint_id;
-                        tokens >> temp_skinning[k_bone].weight;
-                    }
-                    skinning_info.push_back(temp_skinning);
-                }
-
-
-                //read connectivity
-                if(first_word=="f")
-                {
-                  std::string u0_str,u1_str,u2_str;
-                  tokens >> u0_str >> u1_str >> u2_str;
-
-                  int const u0 = std::stoi(u0_str)-1;
-                  int const u1 = std::stoi(u1_str)-1;
-                  int const u2 = std::stoi(u2_str)-1;
-
-                  add_triangle_index({u0,u1,u2});
-
-                }
-            }
-
+            temp_skinning[k_bone].joint_id = static_cast<int>(obj.data_skinning[first+2*k_bone]);
+            temp_skinning[k_bone].weight = obj.data_skinning[first+2*k_bone+1];
         }
-
+        add_vertex_weight(normalized(temp_skinning));
     }
 
-    fid.close();
-
-    //add the skinning weights in the mesh structure
-    for(auto const& s : skinning_info)
-        add_vertex_weight(normalized(s));
-
     ASSERT_CPE(size_vertex_weight()==size_vertex(),"Mesh skinned seems to have the wrong number of skinning weights");
 
 }
@@ -169,23 +129,185 @@ vec3 const& mesh_skinned::vertex_original(int index) const
     return vertices_original_data[index];
 }
 
+float const* mesh_skinned::pointer_vertex_original() const
+{
+    ASSERT_CPE(vertices_original_data.size()>0,"No original vertex");
+    return vertices_original_data[0].pointer();
+}
+
 void mesh_skinned::add_vertex(vec3 const& p)
 {
     mesh::add_vertex(p);
     vertices_original_data.push_back(p);
 }
 
+void mesh_skinned::assign(std::vector<vec3> vertices,std::vector<vec3> normals,std::vector<vec3> colors,
+                          std::vector<vec2> texture_coords,std::vector<triangle_index> connectivity)
+{
+    vertices_original_data = vertices;
+    normals_original_data.clear();
+    vertex_weight_data.clear();
+    mesh::assign(std::move(vertices),std::move(normals),std::move(colors),std::move(texture_coords),std::move(connectivity));
+}
+
+void mesh_skinned::assign_vertex_weight(std::vector<vertex_weight_parameter> weights)
+{
+    ASSERT_CPE(weights.size()==vertices_original_data.size(),"Skinning weights must be given for every vertex");
+    vertex_weight_data.swap(weights);
+}
+
+void mesh_skinned::remap_joints(std::vector<int> const& new_to_old)
+{
+    if(new_to_old.size()==0)
+        return;
+    std::vector<int> const old_to_new = inverse_joint_order(new_to_old);
+    int const N_joint = old_to_new.size();
+
+    for(vertex_weight_parameter& w : vertex_weight_data)
+    {
+        for(int k=0 ; k<w.size() ; ++k)
+        {
+            int const joint = w[k].joint_id;
+            if(w[k].weight!=0.0f)
+                ASSERT_CPE(joint>=0 && joint<N_joint,"Incorrect joint index ("+std::to_string(joint)+")");
+            if(joint>=0 && joint<N_joint)
+                w[k].joint_id = old_to_new[joint];
+        }
+    }
+}
+
+void mesh_skinned::remap_vertices(std::vector<int> const& new_to_old,std::vector<int> const& old_to_new)
+{
+    int const N_vertex = size_vertex();
+    ASSERT_CPE(N_vertex==int(vertices_original_data.size()),"Incorrect size");
+    ASSERT_CPE(size_vertex_weight()==0 || size_vertex_weight()==N_vertex,"Incorrect number of skinning weights");
+
+    mesh::remap_vertices(new_to_old,old_to_new);
+    remap_vector(vertices_original_data,new_to_old);
+    if(normals_original_data.size()>0)
+        remap_vector(normals_original_data,new_to_old);
+    remap_vector(vertex_weight_data,new_to_old);
+}
+
+bool mesh_skinned::same_vertex_attributes(int const k0,int const k1,float const tolerance) const
+{
+    if(!mesh::same_vertex_attributes(k0,k1,tolerance))
+        return false;
+    if(size_vertex_weight()!=size_vertex())
+        return true;
+
+    //the influences are compared independently of their order
+    vertex_weight_parameter const& w0 = vertex_weight_data[k0];
+    vertex_weight_parameter const& w1 = vertex_weight_data[k1];
+    for(int k=0 ; k<2 ; ++k)
+    {
+        vertex_weight_parameter const& a = k==0 ? w0 : w1;
+        vertex_weight_parameter const& b = k==0 ? w1 : w0;
+        for(skinning_weight const& s_a : a)
+        {
+            float w_b = 0.0f;
+            for(skinning_weight const& s_b : b)
+                if(s_b.joint_id==s_a.joint_id)
+                    w_b += s_b.weight;
+            float w_a = 0.0f;
+            for(skinning_weight const& s : a)
+                if(s.joint_id==s_a.joint_id)
+                    w_a += s.weight;
+            if(std::abs(w_a-w_b)>tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+std::size_t mesh_skinned::size_memory() const
+{
+    return mesh::size_memory() + (vertices_original_data.size()+normals_original_data.size())*sizeof(vec3)
+        + vertex_weight_data.size()*sizeof(vertex_weight_parameter);
+}
+
 void mesh_skinned::apply_skinning(skeleton_geometry const& skeleton)
+{
+    if(size_vertex()==0)
+        return;
+    compute_skinning(skeleton,reinterpret_cast<float*>(&vertex_data[0]));
+    touch(mesh_attribute::vertex);
+}
+
+void mesh_skinned::apply_vertex_cache(vertex_animation_cache const& cache,float const time)
+{
+    int const N_vertex = size_vertex();
+    ASSERT_CPE(cache.size_vertex()==N_vertex,"Vertex animation cache has incorrect number of vertices");
+    if(N_vertex==0)
+        return;
+
+    int frame=0;
+    float alpha=0.0f;
+    cache.frame_at_time(time,frame,alpha);
+
+    bool const with_normal = cache.has_normal() && size_normal()==N_vertex;
+    if(with_normal && normals_original_data.size()==0)
+        normals_original_data = normal_data;
+    cache.interpolate(frame,alpha,reinterpret_cast<float*>(&vertex_data[0]),with_normal? reinterpret_cast<float*>(&normal_data[0]) : nullptr);
+    touch(mesh_attribute::vertex);
+    if(with_normal)
+        touch(mesh_attribute::normal);
+}
+
+void mesh_skinned::apply_vertex_cache(vertex_animation_pca const& cache,float const time)
+{
+    int const N_vertex = size_vertex();
+    ASSERT_CPE(cache.size_vertex()==N_vertex,"Compressed vertex animation has incorrect number of vertices");
+    if(N_vertex==0)
+        return;
+
+    int frame=0;
+    float alpha=0.0f;
+    cache.frame_at_time(time,frame,alpha);
+    cache.interpolate(frame,alpha,reinterpret_cast<float*>(&vertex_data[0]));
+    touch(mesh_attribute::vertex);
+}
+
+void mesh_skinned::compute_skinning(skeleton_geometry const& skeleton,float* const positions,float* const normals) const
 {
     int const N_vertex = size_vertex();
     ASSERT_CPE(N_vertex==int(vertices_original_data.size()),"Incorrect size");
+    ASSERT_CPE(N_vertex==size_vertex_weight(),"Incorrect number of skinning weights");
+    ASSERT_CPE(normals==nullptr || N_vertex==size_normal(),"Incorrect number of normals");
+    std::vector<vec3> const& normals_rest = normals_original_data.size()>0? normals_original_data : normal_data;
 
     for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
     {
-        //TO DO: Calculer deformation par skinning
-        //  vertex(k_vertex) = ...
-    }
+        vec3 const& p0 = vertices_original_data[k_vertex];
+        vertex_weight_parameter const& w = vertex_weight_data[k_vertex];
 
+        //linear blend of the vertex transformed by each influencing joint
+        vec3 p;
+        for(skinning_weight const& s : w)
+        {
+            if(s.weight<=0.0f)
+                continue;
+            skeleton_joint const& joint = skeleton[s.joint_id];
+            p += s.weight*(joint.orientation*p0+joint.position);
+        }
+        positions[3*k_vertex+0] = p.x();
+        positions[3*k_vertex+1] = p.y();
+        positions[3*k_vertex+2] = p.z();
+
+        if(normals==nullptr)
+            continue;
+
+        //the normals are only rotated
+        vec3 const& n0 = normals_rest[k_vertex];
+        vec3 n;
+        for(skinning_weight const& s : w)
+            if(s.weight>0.0f)
+                n += s.weight*(skeleton[s.joint_id].orientation*n0);
+        n = normalized(n);
+        normals[3*k_vertex+0] = n.x();
+        normals[3*k_vertex+1] = n.y();
+        normals[3*k_vertex+2] = n.z();
+    }
 }
 
 }
@@ -30,6 +30,9 @@ namespace cpe
 {
 
 class skeleton_geometry;
+class vertex_animation_cache;
+struct obj_load_report;
+class vertex_animation_pca;
 
 /** A derived class of mesh with skinning weight information per vertex
     Note that the class store twice the vertices:
@@ -49,6 +52,8 @@ public:
 
     /** Access to original vertex */
     vec3 const& vertex_original(int index) const;
+    /** Get a pointer on the original vertices (for OpenGL) */
+    float const* pointer_vertex_original() const;
 
     /** Add a vertex both as an original position and in the default vertex storage
         \note overloading of the add_vertex method of mesh
@@ -58,19 +63,62 @@ public:
     /** Add skinning weights information to the data structure (in the same order than the vertices) */
     void add_vertex_weight(vertex_weight_parameter const& w);
 
+    /** Replace all the data of the mesh at once, the vertices are also the original positions. The skinning weights are removed.
+        \note overloading of the assign method of mesh_basic
+    */
+    void assign(std::vector<vec3> vertices,std::vector<vec3> normals,std::vector<vec3> colors,
+                std::vector<vec2> texture_coords,std::vector<triangle_index> connectivity) override;
+    /** Replace all the skinning weights at once (in the same order than the vertices) */
+    void assign_vertex_weight(std::vector<vertex_weight_parameter> weights);
+
+    /** Reorder the joints referenced by the skinning weights: the new joint k is the previous joint new_to_old[k]
+     *  (see skeleton_parent_id::load_order). An empty order keeps the joints. */
+    void remap_joints(std::vector<int> const& new_to_old);
+
     /** Size of the vertex weights information (should be equals to size_vertex() when all the informations are provided) */
     int size_vertex_weight() const;
 
+    /** Memory used by the mesh data, including the original positions and the skinning weights (in bytes) */
+    std::size_t size_memory() const override;
+
     /** Load a mesh with its skinning information from a given file
      * \note Only handle custom 'obj' file with same connectivity for vertex, normals, texture, and skinning weights.
+     *  PLY files storing the skinning weights as vertex properties are also handled (see load_mesh_skinned_file_ply),
+     *  as well as the first skinned mesh of glTF binary files (see load_skinned_model_file_glb).
+     *  The 'obj' files are parsed in parallel (see load_file_obj_structure), the measures of the parsing are stored in the report if it is given.
     */
-    void load(std::string const& filename);
+    void load(std::string const& filename,obj_load_report* report=nullptr);
 
     /** Apply the skinning deformation using a given skeleton deformation
      * \note The skeleton should store the matrices T*B^{-1}, where T is the
      * global frame of the joint, and B is the bind pose of the joint in the local frame.
     */
     void apply_skinning(skeleton_geometry const& skeleton);
+    /** Compute the skinning deformation into external buffers, without modifying the mesh (can be called from several threads).
+     * \param positions: 3*size_vertex() floats receiving the deformed vertices.
+     * \param normals: 3*size_vertex() floats receiving the deformed normals (not computed if nullptr), from the rest normals.
+     * \note The skeleton stores the matrices T*B^{-1}, as for apply_skinning.
+    */
+    void compute_skinning(skeleton_geometry const& skeleton,float* positions,float* normals=nullptr) const;
+
+    /** Play back a baked vertex animation cache instead of applying the skinning: the vertices (and the normals if the cache
+     *  stores them) are interpolated between the two cached frames surrounding the given time (the cache is played cyclically).
+     * \note The cache must have been baked from this mesh (same vertices in the same order).
+     *  The rest normals are kept aside before being overwritten: the skinning still starts from them. */
+    void apply_vertex_cache(vertex_animation_cache const& cache,float time);
+    /** Play back a compressed vertex animation: only the vertices are modified (see apply_vertex_cache) */
+    void apply_vertex_cache(vertex_animation_pca const& cache,float time);
+
+protected:
+
+    /** Reorder the vertices, including the original positions and the skinning weights
+        \note overloading of the remap_vertices method of mesh_basic
+    */
+    void remap_vertices(std::vector<int> const& new_to_old,std::vector<int> const& old_to_new) override;
+    /** Compare the attributes of two vertices, including the skinning weights
+        \note overloading of the same_vertex_attributes method of mesh_basic
+    */
+    bool same_vertex_attributes(int k0,int k1,float tolerance) const override;
 
 private:
 
@@ -78,6 +126,9 @@ private:
      *  These positions are not modified when applying the skinning.
     */
     std::vector<vec3> vertices_original_data;
+    /** Internal storage for the original normals, saved when a deformation overwrites the normals of the mesh
+     *  (empty while the normals of the mesh are the original ones). */
+    std::vector<vec3> normals_original_data;
 
     /** Internal storage for the vertex weight information*/
     std::vector<vertex_weight_parameter> vertex_weight_data;
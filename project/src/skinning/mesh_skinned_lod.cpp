@@ -0,0 +1,196 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mesh_skinned_lod.hpp"
+
+#include "../lib/mesh/mesh_simplification.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cpe
+{
+
+/** Average of two sets of skinning weights, keeping the WEIGHTS_PER_VERTEX largest influences */
+static vertex_weight_parameter merge_weights(vertex_weight_parameter const& w0,float const mass_0,
+                                             vertex_weight_parameter const& w1,float const mass_1)
+{
+    std::vector<skinning_weight> influences;
+    for(int k=0 ; k<2 ; ++k)
+    {
+        vertex_weight_parameter const& w = k==0 ? w0 : w1;
+        float const mass = k==0 ? mass_0 : mass_1;
+        for(skinning_weight const& s : w)
+        {
+            if(s.weight<=0.0f)
+                continue;
+
+            auto it = std::find_if(influences.begin(),influences.end(),[&](skinning_weight const& c){return c.joint_id==s.joint_id;});
+            if(it==influences.end())
+            {
+                influences.push_back(skinning_weight());
+                it = influences.end()-1;
+                it->joint_id = s.joint_id;
+            }
+            it->weight += mass*s.weight/(mass_0+mass_1);
+        }
+    }
+
+    std::sort(influences.begin(),influences.end(),[](skinning_weight const& a,skinning_weight const& b){return a.weight>b.weight;});
+
+    vertex_weight_parameter merged;
+    int const N = std::min(static_cast<int>(influences.size()),merged.size());
+    for(int k=0 ; k<N ; ++k)
+        merged[k] = influences[k];
+    return normalized(merged);
+}
+
+/** Sum of the absolute differences between two sets of skinning weights, in [0,2] */
+static float weights_distance(vertex_weight_parameter const& w0,vertex_weight_parameter const& w1)
+{
+    float d = 0.0f;
+    for(skinning_weight const& s0 : w0)
+    {
+        float w_other = 0.0f;
+        for(skinning_weight const& s1 : w1)
+            if(s1.joint_id==s0.joint_id)
+                w_other += s1.weight;
+        d += std::abs(s0.weight-w_other);
+    }
+    //influences of w1 absent from w0
+    for(skinning_weight const& s1 : w1)
+    {
+        bool found = false;
+        for(skinning_weight const& s0 : w0)
+            found = found || (s0.joint_id==s1.joint_id && s0.weight>0.0f);
+        if(!found)
+            d += s1.weight;
+    }
+    return d;
+}
+
+mesh_skinned simplify(mesh_skinned const& m,int const N_triangle)
+{
+    int const N_vertex = m.size_vertex();
+    ASSERT_CPE(m.size_vertex_weight()==N_vertex,"Incorrect number of skinning weights");
+
+    std::vector<vec3> positions(N_vertex);
+    std::vector<vertex_weight_parameter> weights(N_vertex);
+    for(int k=0 ; k<N_vertex ; ++k)
+    {
+        positions[k] = m.vertex_original(k);
+        weights[k] = m.vertex_weight(k);
+    }
+    std::vector<triangle_index> triangles(m.size_connectivity());
+    for(int k=0,N=triangles.size() ; k<N ; ++k)
+        triangles[k] = m.connectivity(k);
+
+    //number of initial vertices merged in each vertex
+    std::vector<float> mass(N_vertex,1.0f);
+
+    //vertices driven by different joints should not be merged: penalty in the unit of the quadric error (area times squared distance)
+    auto const skinning_cost = [&](int const from,int const to)
+    {
+        vec3 const edge = positions[from]-positions[to];
+        float const L2 = dot(edge,edge);
+        return weights_distance(weights[from],weights[to])*L2*L2;
+    };
+    auto const merge = [&](int const from,int const to)
+    {
+        weights[to] = merge_weights(weights[from],mass[from],weights[to],mass[to]);
+        mass[to] += mass[from];
+    };
+
+    std::vector<int> collapsed_into;
+    std::vector<triangle_index> const simplified = simplify_quadric(positions,triangles,N_triangle,collapsed_into,skinning_cost,merge);
+
+    //build the mesh from the remaining vertices
+    std::vector<int> new_index(N_vertex,-1);
+    mesh_skinned result;
+    for(triangle_index const& tri : simplified)
+    {
+        triangle_index new_tri;
+        for(int k=0 ; k<3 ; ++k)
+        {
+            int const u = tri[k];
+            if(new_index[u]<0)
+            {
+                new_index[u] = result.size_vertex();
+                result.add_vertex(positions[u]);
+                result.add_vertex_weight(weights[u]);
+                if(m.size_normal()==N_vertex)
+                    result.add_normal(m.normal(u));
+                if(m.size_color()==N_vertex)
+                    result.add_color(m.color(u));
+                if(m.size_texture_coord()==N_vertex)
+                    result.add_texture_coord(m.texture_coord(u));
+            }
+            new_tri[k] = new_index[u];
+        }
+        result.add_triangle_index(new_tri);
+    }
+
+    result.optimize_vertex_cache();
+    return result;
+}
+
+
+mesh_skinned_lod::mesh_skinned_lod()
+    :full_resolution_size(0.5f),levels()
+{}
+
+void mesh_skinned_lod::build(mesh_skinned const& m,int const N_level,float const triangle_ratio)
+{
+    ASSERT_CPE(N_level>0,"At least one level is needed");
+    ASSERT_CPE(triangle_ratio>0.0f && triangle_ratio<1.0f,"Incorrect triangle ratio");
+
+    levels.clear();
+    levels.push_back(m);
+    for(int k_level=1 ; k_level<N_level ; ++k_level)
+    {
+        mesh_skinned const& previous = levels.back();
+        int const N_triangle = static_cast<int>(triangle_ratio*previous.size_connectivity());
+        levels.push_back(simplify(previous,N_triangle));
+    }
+}
+
+int mesh_skinned_lod::size() const
+{
+    return levels.size();
+}
+
+mesh_skinned const& mesh_skinned_lod::operator[](int const level) const
+{
+    ASSERT_CPE(level>=0 && level<size(),"Incorrect level of detail ("+std::to_string(level)+")");
+    return levels[level];
+}
+
+int mesh_skinned_lod::select(float const projected_size) const
+{
+    ASSERT_CPE(size()>0,"Levels of detail are not built");
+    if(projected_size>=full_resolution_size)
+        return 0;
+    if(projected_size<=0.0f)
+        return size()-1;
+
+    int const level = 1+static_cast<int>(std::log2(full_resolution_size/projected_size));
+    return std::min(level,size()-1);
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_SKINNED_LOD_HPP
+#define MESH_SKINNED_LOD_HPP
+
+#include "mesh_skinned.hpp"
+
+#include <vector>
+
+namespace cpe
+{
+
+/** Build a simplified copy of a skinned mesh with (approximately) N_triangle triangles.
+ *  The rest pose (original vertices) is simplified with quadric error collapses, penalized between vertices
+ *   with different skinning weights. The weights of a collapsed vertex are merged into the remaining one
+ *   (average weighted by the number of merged vertices, restricted to the WEIGHTS_PER_VERTEX largest influences).
+*/
+mesh_skinned simplify(mesh_skinned const& m,int N_triangle);
+
+/** Chain of levels of detail of a skinned mesh, from the full resolution (level 0) to the coarsest one.
+    The level used to deform and draw a character is selected from its projected size on the screen.
+*/
+class mesh_skinned_lod
+{
+public:
+
+    mesh_skinned_lod();
+
+    /** Build N_level levels: level 0 is a copy of the mesh, each next level is a simplification of the previous one
+     *  with triangle_ratio times its number of triangles. */
+    void build(mesh_skinned const& m,int N_level,float triangle_ratio=0.5f);
+
+    /** Number of levels */
+    int size() const;
+    /** Access to a given level */
+    mesh_skinned const& operator[](int level) const;
+
+    /** Select the level to use for a given projected size (fraction of the screen height, see projected_size).
+     *  The full resolution is used above full_resolution_size, the next levels each time the size is halved. */
+    int select(float projected_size) const;
+
+    /** Projected size above which the full resolution is used */
+    float full_resolution_size;
+
+private:
+
+    /** Internal storage of the levels */
+    std::vector<mesh_skinned> levels;
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mesh_skinned_opengl.hpp"
+
+#include "mesh_skinned.hpp"
+#include "skeleton_geometry.hpp"
+#include "../lib/opengl/glutils.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <vector>
+
+namespace cpe
+{
+
+/** Location of the skinning attributes in the shader.
+ *  The locations 0-8 are avoided as some drivers alias them with the built-in attributes (gl_Vertex, gl_Normal, etc). */
+static GLuint const attribute_joint_0  = 10;
+static GLuint const attribute_joint_1  = 11;
+static GLuint const attribute_weight_0 = 12;
+static GLuint const attribute_weight_1 = 13;
+
+/** Number of floats stored per vertex in the skinning VBO (joint indices followed by the weights) */
+static int const skinning_vbo_stride = 2*WEIGHTS_PER_VERTEX;
+
+static_assert(WEIGHTS_PER_VERTEX==6,"The skinning shader expects 6 weights per vertex");
+
+mesh_skinned_opengl::mesh_skinned_opengl()
+    :mesh_opengl(),vbo_skinning(0)
+{}
+
+mesh_skinned_opengl::~mesh_skinned_opengl()
+{
+    delete_vbo_skinning();
+}
+
+void mesh_skinned_opengl::fill_vbo(mesh_skinned const& m)
+{
+    //the GPU deforms the rest pose: send the original vertices instead of the (possibly already deformed) ones
+    mesh_opengl::fill_vbo(m,m.pointer_vertex_original());
+
+    int const N_vertex = m.size_vertex();
+    ASSERT_CPE(m.size_vertex_weight()==N_vertex,"Skinned mesh has incorrect number of weights");
+
+    //pack joint indices and weights
+    std::vector<float> data(skinning_vbo_stride*N_vertex);
+    for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+    {
+        vertex_weight_parameter const& w = m.vertex_weight(k_vertex);
+        float* const current = &data[skinning_vbo_stride*k_vertex];
+        for(int k=0 ; k<WEIGHTS_PER_VERTEX ; ++k)
+        {
+            ASSERT_CPE(w[k].joint_id>=0 && w[k].joint_id<SKINNING_MAX_JOINT,"Joint id exceeds the size of the skinning palette");
+            current[k]                    = static_cast<float>(w[k].joint_id);
+            current[WEIGHTS_PER_VERTEX+k] = w[k].weight;
+        }
+    }
+
+    if(vbo_skinning==0)
+    {glGenBuffers(1,&vbo_skinning);                                                                    PRINT_OPENGL_ERROR();}
+    ASSERT_CPE(vbo_skinning!=0,"Problem creation of VBO");
+
+    glBindBuffer(GL_ARRAY_BUFFER,vbo_skinning);                                                        PRINT_OPENGL_ERROR();
+    glBufferData(GL_ARRAY_BUFFER,sizeof(float)*data.size(),&data[0],GL_STATIC_DRAW);                  PRINT_OPENGL_ERROR();
+
+    //record the skinning attributes in the VAO of the mesh
+    GLsizei const stride = skinning_vbo_stride*sizeof(float);
+
+    glBindVertexArray(vao);                                                                            PRINT_OPENGL_ERROR();
+    glEnableVertexAttribArray(attribute_joint_0);                                                      PRINT_OPENGL_ERROR();
+    glEnableVertexAttribArray(attribute_joint_1);                                                      PRINT_OPENGL_ERROR();
+    glEnableVertexAttribArray(attribute_weight_0);                                                     PRINT_OPENGL_ERROR();
+    glEnableVertexAttribArray(attribute_weight_1);                                                     PRINT_OPENGL_ERROR();
+    glVertexAttribPointer(attribute_joint_0 ,3,GL_FLOAT,GL_FALSE,stride,buffer_offset(0));              PRINT_OPENGL_ERROR();
+    glVertexAttribPointer(attribute_joint_1 ,3,GL_FLOAT,GL_FALSE,stride,buffer_offset(3*sizeof(float))); PRINT_OPENGL_ERROR();
+    glVertexAttribPointer(attribute_weight_0,3,GL_FLOAT,GL_FALSE,stride,buffer_offset(6*sizeof(float))); PRINT_OPENGL_ERROR();
+    glVertexAttribPointer(attribute_weight_1,3,GL_FLOAT,GL_FALSE,stride,buffer_offset(9*sizeof(float))); PRINT_OPENGL_ERROR();
+    glBindVertexArray(0);                                                                              PRINT_OPENGL_ERROR();
+}
+
+void mesh_skinned_opengl::delete_vbo_skinning()
+{
+    if(vbo_skinning!=0)
+    {glDeleteBuffers(1,&vbo_skinning);                                                                 PRINT_OPENGL_ERROR();}
+    vbo_skinning=0;
+}
+
+std::vector<shader_attribute> mesh_skinned_opengl::shader_attributes()
+{
+    return {{attribute_joint_0 ,"skinning_joint_0"},
+            {attribute_joint_1 ,"skinning_joint_1"},
+            {attribute_weight_0,"skinning_weight_0"},
+            {attribute_weight_1,"skinning_weight_1"}};
+}
+
+void upload_skinning_palette(GLint const palette_location,skeleton_geometry const& skeleton)
+{
+    int const N_joint = skeleton.size();
+    ASSERT_CPE(N_joint<=SKINNING_MAX_JOINT,"Too many joints for the skinning palette ("+std::to_string(N_joint)+")");
+    if(N_joint<=0)
+        return;
+
+    std::vector<float> palette(16*N_joint);
+    for(int k=0 ; k<N_joint ; ++k)
+    {
+        mat4 const M = skeleton[k].to_mat4();
+        float const* const m = M.pointer();
+        for(int k_entry=0 ; k_entry<16 ; ++k_entry)
+            palette[16*k+k_entry] = m[k_entry];
+    }
+
+    glUniformMatrix4fv(palette_location,N_joint,false,&palette[0]);                                    PRINT_OPENGL_ERROR();
+}
+
+}
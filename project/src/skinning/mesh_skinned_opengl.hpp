@@ -0,0 +1,75 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef MESH_SKINNED_OPENGL_HPP
+#define MESH_SKINNED_OPENGL_HPP
+
+#include "../lib/opengl/mesh_opengl.hpp"
+#include "../lib/opengl/shader_registry.hpp"
+
+#include <vector>
+
+/** Maximal number of joints in the skinning palette (must match the size declared in shader_mesh_skinned.vert) */
+#define SKINNING_MAX_JOINT 64
+
+namespace cpe
+{
+
+class mesh_skinned;
+class skeleton_geometry;
+
+/** Class to draw a skinned mesh deformed on the GPU (matrix-palette skinning).
+    The rest pose of the mesh and its skinning weights are sent once to the GPU.
+    At each frame only the palette (one matrix per joint) has to be updated using upload_skinning_palette.
+    The skinning attributes are recorded in the VAO of the mesh, drawing is done with mesh_opengl::draw().
+    The shader must be a skinning shader (ex. shader_mesh_skinned.vert) linked with the attributes given by shader_attributes,
+     and the palette must be uploaded on this shader before drawing.
+*/
+class mesh_skinned_opengl : public mesh_opengl
+{
+public:
+
+    mesh_skinned_opengl();
+    ~mesh_skinned_opengl();
+
+    /** Send the mesh data and the skinning weights to the VBO.
+     *  \note The vertices sent are the original (rest pose) positions of the mesh. */
+    void fill_vbo(mesh_skinned const& m);
+
+    /** Locations expected for the skinning attributes of the shader (to be bound before linking) */
+    static std::vector<shader_attribute> shader_attributes();
+
+private:
+
+    /** Helper function to delete the skinning vbo */
+    void delete_vbo_skinning();
+
+    /** VBO for the joint indices and the weights */
+    GLuint vbo_skinning;
+};
+
+/** Send the skinning palette to the uniform "skinning_palette" of the current shader (given its location).
+ *  \note The skeleton should store the matrices T*B^{-1} (same convention than mesh_skinned::apply_skinning). */
+void upload_skinning_palette(GLint palette_location,skeleton_geometry const& skeleton);
+
+}
+
+#endif
@@ -116,6 +116,12 @@ void skeleton_animation::push_back(skeleton_geometry const& skeleton)
 
 }
 
+void skeleton_animation::remap_joints(std::vector<int> const& new_to_old)
+{
+    for(skeleton_geometry& skeleton : data)
+        skeleton.remap_joints(new_to_old);
+}
+
 skeleton_geometry skeleton_animation::operator()(int const frame,float const alpha) const
 {
     int const N_frame = size();
@@ -48,6 +48,10 @@ public:
     /** Add a skeleton keyframe into the structure */
     void push_back(skeleton_geometry const& skeleton);
 
+    /** Reorder the joints of all the keyframes: the new joint k is the previous joint new_to_old[k].
+     *  An empty order keeps the joints. */
+    void remap_joints(std::vector<int> const& new_to_old);
+
     /** STL compatible ranged-loop */
     std::vector<skeleton_geometry>::iterator begin();
     /** STL compatible ranged-loop */
@@ -47,6 +47,19 @@ void skeleton_geometry::push_back(skeleton_joint const& joint)
     data.push_back(joint);
 }
 
+void skeleton_geometry::remap_joints(std::vector<int> const& new_to_old)
+{
+    if(new_to_old.size()==0)
+        return;
+    ASSERT_CPE(new_to_old.size()==data.size(),"Incorrect joint order size");
+
+    std::vector<skeleton_joint> remapped;
+    remapped.reserve(data.size());
+    for(int const k_old : new_to_old)
+        remapped.push_back(data[k_old]);
+    data.swap(remapped);
+}
+
 skeleton_joint const& skeleton_geometry::operator[](int index) const
 {
     ASSERT_CPE(index>=0,"Index ("+std::to_string(index)+") must be positive");
@@ -177,6 +190,8 @@ skeleton_geometry local_to_global(skeleton_geometry const& sk_local,skeleton_par
         }
         else
         {
+            //single forward pass: the parent must be computed before (see skeleton_parent_id::load)
+            ASSERT_CPE(parent_id[i]<i,"Joint "+std::to_string(i)+" is stored before its parent "+std::to_string(parent_id[i]));
             skeleton_joint j_tmp;
             j_tmp.position = sk_global[parent_id[i]].orientation * sk_local[i].position
                     + sk_global[parent_id[i]].position;
@@ -188,13 +203,22 @@ skeleton_geometry local_to_global(skeleton_geometry const& sk_local,skeleton_par
 
 
 }
+skeleton_geometry bind_pose_file_to_global(skeleton_geometry const& bind_pose_file)
+{
+    skeleton_geometry bind_pose_global = bind_pose_file;
+    for(skeleton_joint& joint : bind_pose_global)
+        joint.position = joint.orientation*joint.position;
+    return bind_pose_global;
+}
+
 skeleton_geometry inversed(skeleton_geometry const& skeleton)
 {
     skeleton_geometry sk_inversed;
 
     for(skeleton_joint const& joint : skeleton)
     {
-        //TO DO: calculer l'inverse de chaque repere
+        quaternion const q_inv = conjugated(joint.orientation);
+        sk_inversed.push_back(skeleton_joint(-(q_inv*joint.position),q_inv));
     }
 
     return sk_inversed;
@@ -208,8 +232,11 @@ skeleton_geometry multiply(skeleton_geometry const& skeleton_1,skeleton_geometry
     int const N_joint = skeleton_1.size();
     for(int k=0 ; k<N_joint ; ++k)
     {
-        //TO DO: calculer le produit pour chaque joint entre celui du squelette 1 et celui du squelette 2
+        skeleton_joint const& joint_1 = skeleton_1[k];
+        skeleton_joint const& joint_2 = skeleton_2[k];
 
+        sk.push_back(skeleton_joint(joint_1.orientation*joint_2.position+joint_1.position,
+                                    joint_1.orientation*joint_2.orientation));
     }
 
     return sk;
@@ -224,10 +251,11 @@ std::vector<vec3> extract_bones(skeleton_geometry const& skeleton,skeleton_paren
     for(int k=1 ; k<N_joint ; ++k)
     {
         int const parent = parent_id[k];
+        if(parent<0)
+            continue;
 
-        //TO DO: completez la structure position avec la position des extermitees des os.
-
-
+        positions.push_back(skeleton[parent].position);
+        positions.push_back(skeleton[k].position);
     }
 
     return positions;
@@ -245,7 +273,10 @@ skeleton_geometry interpolated(skeleton_geometry const& skeleton_1,skeleton_geom
 
         skeleton_joint const& joint_1 = skeleton_1[k];
         skeleton_joint const& joint_2 = skeleton_2[k];
-        //TO DO: completez la methode d'interpolation entre les reperes des joints du squelette 1 et du squelette 2
+
+        vec3 const p = (1.0f-alpha)*joint_1.position + alpha*joint_2.position;
+        quaternion const q = slerp(joint_1.orientation,joint_2.orientation,alpha);
+        sk.push_back(skeleton_joint(p,q));
     }
 
     return sk;
@@ -46,6 +46,10 @@ public:
     /** Add a geometrical joint in the next entry of the structure */
     void push_back(skeleton_joint const& joint);
 
+    /** Reorder the joints: the new joint k is the previous joint new_to_old[k] (see skeleton_parent_id::load_order).
+     *  An empty order keeps the joints. */
+    void remap_joints(std::vector<int> const& new_to_old);
+
     /** Get the k-th joint geometry */
     skeleton_joint const& operator[](int index) const;
     /** Get the k-th joint geometry */
@@ -64,7 +68,7 @@ public:
     /** STL compatible ranged-loop */
     std::vector<skeleton_joint>::const_iterator cend() const;
 
-    /** Load geometrical structure from a .skeleton file */
+    /** Load geometrical structure from a .skeleton file (bind pose: see bind_pose_file_to_global) */
     void load(std::string const& filename);
     /** Save a .skeleton file
      * \note requires the parent_id for the hierarchy information in the file
@@ -83,6 +87,9 @@ std::ostream& operator<<(std::ostream& stream , skeleton_geometry const& skeleto
 
 /** Convert joint frame expressed with respect to their parent into a global coordinate frame. */
 skeleton_geometry local_to_global(skeleton_geometry const& skeleton,skeleton_parent_id const& parent_id);
+/** Convert a bind pose read from a .skeleton file into global frames.
+ *  The file stores the global orientation of each joint, and its position expressed in this orientation. */
+skeleton_geometry bind_pose_file_to_global(skeleton_geometry const& bind_pose_file);
 /** Take the inverse of the frame (used to compute the inversed bind pose frames). */
 skeleton_geometry inversed(skeleton_geometry const& skeleton);
 /** Multiply each frames of the skeleton each other.
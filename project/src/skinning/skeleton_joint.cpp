@@ -19,6 +19,8 @@
 
 #include "skeleton_joint.hpp"
 
+#include "../lib/3d/mat3.hpp"
+
 namespace cpe
 {
 
@@ -29,4 +31,11 @@ skeleton_joint::skeleton_joint(vec3 const& position_param,quaternion const& orie
     :position(position_param),orientation(orientation_param)
 {}
 
+mat4 skeleton_joint::to_mat4() const
+{
+    mat4 m;
+    m.set_transformation(orientation.to_mat3(),position);
+    return m;
+}
+
 }
@@ -24,6 +24,7 @@
 
 #include "../lib/3d/vec3.hpp"
 #include "../lib/3d/quaternion.hpp"
+#include "../lib/3d/mat4.hpp"
 
 namespace cpe
 {
@@ -34,6 +35,9 @@ struct skeleton_joint
     skeleton_joint();
     skeleton_joint(vec3 const& position_param,quaternion const& orientation_param);
 
+    /** Convert the frame into a 4x4 rigid transformation matrix */
+    mat4 to_mat4() const;
+
     /** 3D position of the joint */
     vec3 position;
     /** Orientation of the joint */
@@ -21,6 +21,7 @@
 
 #include "../lib/common/error_handling.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 
@@ -28,7 +29,7 @@ namespace cpe
 {
 
 skeleton_parent_id::skeleton_parent_id()
-    :parent_id_data()
+    :parent_id_data(),load_order_data()
 {}
 
 void skeleton_parent_id::push_back(int const parent_id)
@@ -52,6 +53,7 @@ int skeleton_parent_id::operator[](int const index) const
 void skeleton_parent_id::load(std::string const& filename)
 {
     parent_id_data.clear();
+    load_order_data.clear();
 
     std::ifstream fid(filename.c_str());
     if(!fid.good())
@@ -79,6 +81,116 @@ void skeleton_parent_id::load(std::string const& filename)
           parent_id_data.push_back(parent_id);
       }
     }
+
+    try
+    {
+        validate();
+    }
+    catch(exception_cpe const& e)
+    {
+        throw exception_cpe("Incorrect skeleton in file "+filename+": "+e.info(),EXCEPTION_PARAMETERS_CPE);
+    }
+    if(!is_topologically_ordered())
+        load_order_data = reorder_breadth_first();
+}
+
+/** Joints in breadth-first order from the roots. The joints of a cycle, unreachable from a root, are missing. */
+static std::vector<int> breadth_first_order(std::vector<int> const& parent)
+{
+    int const N = parent.size();
+
+    //children of each joint stored contiguously (offsets in the vector children)
+    std::vector<int> offset(N+1,0);
+    for(int const p : parent)
+        if(p>=0)
+            ++offset[p+1];
+    for(int k=0 ; k<N ; ++k)
+        offset[k+1] += offset[k];
+    std::vector<int> children(offset[N]);
+    std::vector<int> filled(offset.begin(),offset.end()-1);
+    for(int k=0 ; k<N ; ++k)
+        if(parent[k]>=0)
+            children[filled[parent[k]]++] = k;
+
+    //the order vector is used as the queue
+    std::vector<int> order;
+    order.reserve(N);
+    for(int k=0 ; k<N ; ++k)
+        if(parent[k]==-1)
+            order.push_back(k);
+    for(std::size_t k_queue=0 ; k_queue<order.size() ; ++k_queue)
+    {
+        int const joint = order[k_queue];
+        order.insert(order.end(),children.begin()+offset[joint],children.begin()+offset[joint+1]);
+    }
+
+    return order;
+}
+
+void skeleton_parent_id::validate() const
+{
+    int const N = parent_id_data.size();
+    for(int k=0 ; k<N ; ++k)
+    {
+        int const p = parent_id_data[k];
+        if(p<-1 || p>=N || p==k)
+            throw exception_cpe("Incorrect parent ("+std::to_string(p)+") for the joint "+std::to_string(k),EXCEPTION_PARAMETERS_CPE);
+    }
+
+    std::vector<int> const order = breadth_first_order(parent_id_data);
+    if(static_cast<int>(order.size())<N)
+    {
+        std::vector<bool> reached(N,false);
+        for(int const k : order)
+            reached[k] = true;
+        int const k_cycle = std::find(reached.begin(),reached.end(),false)-reached.begin();
+        throw exception_cpe("Cycle in the hierarchy of the joints (joint "+std::to_string(k_cycle)+" is not connected to a root)",EXCEPTION_PARAMETERS_CPE);
+    }
+}
+
+bool skeleton_parent_id::is_topologically_ordered() const
+{
+    int const N = parent_id_data.size();
+    for(int k=0 ; k<N ; ++k)
+        if(parent_id_data[k]>=k || parent_id_data[k]<-1)
+            return false;
+    return true;
+}
+
+int skeleton_parent_id::size_root() const
+{
+    return std::count(parent_id_data.begin(),parent_id_data.end(),-1);
+}
+
+std::vector<int> skeleton_parent_id::reorder_breadth_first()
+{
+    std::vector<int> const new_to_old = breadth_first_order(parent_id_data);
+    ASSERT_CPE(new_to_old.size()==parent_id_data.size(),"Cycle in the hierarchy of the joints");
+    std::vector<int> const old_to_new = inverse_joint_order(new_to_old);
+
+    std::vector<int> reordered;
+    reordered.reserve(new_to_old.size());
+    for(int const k_old : new_to_old)
+    {
+        int const p = parent_id_data[k_old];
+        reordered.push_back(p==-1? -1 : old_to_new[p]);
+    }
+    parent_id_data.swap(reordered);
+
+    return new_to_old;
+}
+
+std::vector<int> const& skeleton_parent_id::load_order() const
+{
+    return load_order_data;
+}
+
+std::vector<int> inverse_joint_order(std::vector<int> const& new_to_old)
+{
+    std::vector<int> old_to_new(new_to_old.size(),-1);
+    for(std::size_t k=0 ; k<new_to_old.size() ; ++k)
+        old_to_new[new_to_old[k]] = k;
+    return old_to_new;
 }
 
 std::vector<int>::const_iterator skeleton_parent_id::begin() const {return parent_id_data.begin();}
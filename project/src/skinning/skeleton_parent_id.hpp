@@ -32,7 +32,8 @@ namespace cpe
 
     For instance skeleton_parent_id[5] = 2 means that the joint 5 is the child of the joint 2.
     By convention, the parent of the joint 0 is usually chosen to be -1.
-    Note that the skeleton classes are usually assuming that k > parent_id(k).
+    Note that the skeleton classes are assuming that k > parent_id(k): the global frames are computed in a single
+    forward pass. The skeletons read from files are reordered when needed (see load).
 */
 class skeleton_parent_id
 {
@@ -50,9 +51,27 @@ public:
 
     /** Load the parent id structure from a .skeleton file
      *  Only store the first number of each line of the file.
+     *  The hierarchy is validated (see validate). If a joint is stored before its parent, the joints are reordered
+     *   in breadth-first order: the data read from the same files must then be remapped with load_order().
     */
     void load(std::string const& filename);
 
+    /** Check that each parent is -1 or another joint, and that the hierarchy has no cycle.
+     *  Throws an exception_cpe describing the problem otherwise. A forest (several roots) is valid. */
+    void validate() const;
+    /** True if each joint is stored after its parent (k > parent_id(k)) */
+    bool is_topologically_ordered() const;
+    /** Number of joints without parent (more than 1 for a forest) */
+    int size_root() const;
+
+    /** Reorder the joints in breadth-first order: the roots, then their children level by level (siblings are contiguous
+     *   and kept in their previous order). The hierarchy must be valid.
+     *  Returns new_to_old: the new joint k is the previous joint new_to_old[k]. */
+    std::vector<int> reorder_breadth_first();
+    /** Order of the joints applied by load: the joint k is the joint load_order()[k] of the file.
+     *  Empty if the order of the file was kept. */
+    std::vector<int> const& load_order() const;
+
     /** STL compatible ranged-loop */
     std::vector<int>::const_iterator begin() const;
     /** STL compatible ranged-loop */
@@ -66,8 +85,13 @@ private:
 
     /** Internal storage of the parent id */
     std::vector<int> parent_id_data;
+    /** Order of the joints applied by load (empty if kept) */
+    std::vector<int> load_order_data;
 };
 
+/** Inverse a permutation of the joints: gives old_to_new from new_to_old */
+std::vector<int> inverse_joint_order(std::vector<int> const& new_to_old);
+
 /** Printing parent_id structure */
 std::ostream& operator<<(std::ostream& stream,skeleton_parent_id const& parent_id);
 
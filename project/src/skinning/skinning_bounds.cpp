@@ -0,0 +1,133 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "skinning_bounds.hpp"
+
+#include "mesh_skinned.hpp"
+#include "skeleton_geometry.hpp"
+#include "../lib/3d/mat4.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace cpe
+{
+
+skinning_bounds::skinning_bounds()
+    :joint_corner_min(),joint_corner_max(),joint_influence()
+{}
+
+void skinning_bounds::build(mesh_skinned const& mesh,int const N_joint)
+{
+    ASSERT_CPE(N_joint>0,"Incorrect number of joints");
+    int const N_vertex = mesh.size_vertex();
+    ASSERT_CPE(mesh.size_vertex_weight()==N_vertex,"Incorrect number of skinning weights");
+
+    joint_corner_min.assign(N_joint,vec3());
+    joint_corner_max.assign(N_joint,vec3());
+    joint_influence.assign(N_joint,false);
+
+    for(int k_vertex=0 ; k_vertex<N_vertex ; ++k_vertex)
+    {
+        vec3 const& p = mesh.vertex_original(k_vertex);
+        for(skinning_weight const& s : mesh.vertex_weight(k_vertex))
+        {
+            if(s.weight<=0.0f)
+                continue;
+
+            int const k_joint = s.joint_id;
+            ASSERT_CPE(k_joint>=0 && k_joint<N_joint,"Incorrect joint index ("+std::to_string(k_joint)+")");
+
+            vec3& p_min = joint_corner_min[k_joint];
+            vec3& p_max = joint_corner_max[k_joint];
+            if(!joint_influence[k_joint])
+            {
+                p_min = p;
+                p_max = p;
+                joint_influence[k_joint] = true;
+            }
+            for(int k_dim=0 ; k_dim<3 ; ++k_dim)
+            {
+                p_min[k_dim] = std::min(p_min[k_dim],p[k_dim]);
+                p_max[k_dim] = std::max(p_max[k_dim],p[k_dim]);
+            }
+        }
+    }
+}
+
+bool skinning_bounds::compute_aabb(skeleton_geometry const& palette,vec3& corner_min,vec3& corner_max) const
+{
+    int const N_joint = size();
+    ASSERT_CPE(palette.size()==N_joint,"Palette has incorrect number of joints ("+std::to_string(palette.size())+")");
+
+    bool is_empty = true;
+    for(int k_joint=0 ; k_joint<N_joint ; ++k_joint)
+    {
+        if(!joint_influence[k_joint])
+            continue;
+
+        vec3 p_min = joint_corner_min[k_joint];
+        vec3 p_max = joint_corner_max[k_joint];
+        transform_aabb(palette[k_joint].to_mat4(),p_min,p_max);
+
+        if(is_empty)
+        {
+            corner_min = p_min;
+            corner_max = p_max;
+            is_empty = false;
+        }
+        for(int k_dim=0 ; k_dim<3 ; ++k_dim)
+        {
+            corner_min[k_dim] = std::min(corner_min[k_dim],p_min[k_dim]);
+            corner_max[k_dim] = std::max(corner_max[k_dim],p_max[k_dim]);
+        }
+    }
+
+    return !is_empty;
+}
+
+bool skinning_bounds::compute_aabb(mat4 const& model,skeleton_geometry const& palette,vec3& corner_min,vec3& corner_max) const
+{
+    if(!compute_aabb(palette,corner_min,corner_max))
+        return false;
+    transform_aabb(model,corner_min,corner_max);
+    return true;
+}
+
+int skinning_bounds::size() const
+{
+    return joint_influence.size();
+}
+
+void transform_aabb(mat4 const& M,vec3& corner_min,vec3& corner_max)
+{
+    //the center is transformed, and the half-size is transformed by the absolute value of the linear part (J. Arvo)
+    vec3 const center = M*((corner_min+corner_max)/2.0f);
+    vec3 const half_size = (corner_max-corner_min)/2.0f;
+
+    vec3 extent;
+    for(int row=0 ; row<3 ; ++row)
+        for(int col=0 ; col<3 ; ++col)
+            extent[row] += std::abs(M(row,col))*half_size[col];
+
+    corner_min = center-extent;
+    corner_max = center+extent;
+}
+
+}
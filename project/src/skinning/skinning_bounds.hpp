@@ -0,0 +1,74 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#ifndef SKINNING_BOUNDS_HPP
+#define SKINNING_BOUNDS_HPP
+
+#include "../lib/3d/vec3.hpp"
+
+#include <vector>
+
+namespace cpe
+{
+
+class mat4;
+class mesh_skinned;
+class skeleton_geometry;
+
+/** Bounding boxes of the vertices influenced by each joint, expressed in the bind pose (original vertices).
+    Each deformed vertex is a convex combination of its positions transformed by the influencing joints.
+    The union of the boxes transformed by the palette is therefore a conservative bound of the deformed mesh,
+     obtained in O(joints) instead of O(vertices).
+*/
+class skinning_bounds
+{
+public:
+
+    skinning_bounds();
+
+    /** Compute the box of each joint from the original vertices and the skinning weights of the mesh */
+    void build(mesh_skinned const& mesh,int N_joint);
+
+    /** Compute a box containing the mesh deformed by a palette (matrices T*B^{-1}, see upload_skinning_palette).
+     *  Return false if no vertex is influenced by the skeleton. */
+    bool compute_aabb(skeleton_geometry const& palette,vec3& corner_min,vec3& corner_max) const;
+    /** Compute a box containing the mesh deformed by a palette, then placed by a model matrix */
+    bool compute_aabb(mat4 const& model,skeleton_geometry const& palette,vec3& corner_min,vec3& corner_max) const;
+
+    /** Number of joints */
+    int size() const;
+
+private:
+
+    /** Minimal corner of the box of each joint */
+    std::vector<vec3> joint_corner_min;
+    /** Maximal corner of the box of each joint */
+    std::vector<vec3> joint_corner_max;
+    /** True if the joint influences at least one vertex (its box is not empty) */
+    std::vector<bool> joint_influence;
+};
+
+/** Transform an axis aligned bounding box by an affine matrix and give the axis aligned box containing the result */
+void transform_aabb(mat4 const& M,vec3& corner_min,vec3& corner_max);
+
+}
+
+#endif
@@ -0,0 +1,350 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "vertex_animation_cache.hpp"
+
+#include "mesh_skinned.hpp"
+#include "skeleton_parent_id.hpp"
+#include "skeleton_geometry.hpp"
+#include "skeleton_animation.hpp"
+#include "../lib/common/parallel_for.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <future>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+namespace cpe
+{
+
+static_assert(sizeof(vertex_animation_cache_header)==64,"Unexpected padding in the header of the vertex animation cache");
+
+static bool is_little_endian_host()
+{
+    std::uint32_t const value = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte,&value,1);
+    return first_byte==1;
+}
+
+std::size_t size_frame(vertex_animation_cache_header const& header)
+{
+    return std::size_t(header.has_normal? 6 : 3)*header.N_vertex*sizeof(float);
+}
+
+vertex_animation_cache_writer::vertex_animation_cache_writer()
+    :stream(),filename(),header_data(),chunk_offset(),size_written_data(0)
+{}
+
+void vertex_animation_cache_writer::open(std::string const& filename_param,int const N_vertex,int const N_frame,
+                                         bool const has_normal,float const frame_duration,int const frames_per_chunk)
+{
+    ASSERT_CPE(N_vertex>=0 && N_frame>=0 && frames_per_chunk>0,"Incorrect size of vertex animation cache");
+    if(!is_little_endian_host())
+        throw exception_cpe("Vertex animation caches can only be written on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    filename = filename_param;
+    stream.open(filename.c_str(),std::ios::binary|std::ios::trunc);
+    if(!stream.good())
+        throw exception_cpe("Cannot open file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    std::memset(&header_data,0,sizeof(header_data));
+    std::memcpy(header_data.magic,"CPEVAC01",8);
+    header_data.version = 1;
+    header_data.N_vertex = N_vertex;
+    header_data.N_frame = N_frame;
+    header_data.frames_per_chunk = frames_per_chunk;
+    header_data.N_chunk = (N_frame+frames_per_chunk-1)/frames_per_chunk;
+    header_data.has_normal = has_normal? 1 : 0;
+    header_data.frame_duration = frame_duration;
+    chunk_offset.clear();
+
+    //the offsets of the chunks are only known once they are written: the table is filled at closing
+    std::vector<std::uint64_t> const table(header_data.N_chunk,0);
+    stream.write(reinterpret_cast<char const*>(&header_data),sizeof(header_data));
+    if(table.size()>0)
+        stream.write(reinterpret_cast<char const*>(&table[0]),table.size()*sizeof(std::uint64_t));
+    size_written_data = sizeof(header_data)+table.size()*sizeof(std::uint64_t);
+}
+
+void vertex_animation_cache_writer::write_chunk(float const* const frames)
+{
+    int const k_chunk = chunk_offset.size();
+    ASSERT_CPE(k_chunk<static_cast<int>(header_data.N_chunk),"All the chunks are already written");
+
+    //padding up to the alignment of the chunk
+    std::size_t const offset = ((size_written_data+vertex_animation_cache_alignment-1)/vertex_animation_cache_alignment)*vertex_animation_cache_alignment;
+    static char const padding[vertex_animation_cache_alignment] = {0};
+    stream.write(padding,offset-size_written_data);
+
+    std::size_t const size = chunk_size(k_chunk)*size_frame(header_data);
+    stream.write(reinterpret_cast<char const*>(frames),size);
+    if(!stream.good())
+        throw exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    chunk_offset.push_back(offset);
+    size_written_data = offset+size;
+}
+
+void vertex_animation_cache_writer::close()
+{
+    if(chunk_offset.size()!=header_data.N_chunk)
+        throw exception_cpe("Incomplete vertex animation cache "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    if(chunk_offset.size()>0)
+    {
+        stream.seekp(sizeof(header_data));
+        stream.write(reinterpret_cast<char const*>(&chunk_offset[0]),chunk_offset.size()*sizeof(std::uint64_t));
+    }
+    stream.close();
+    if(stream.fail())
+        throw exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+}
+
+vertex_animation_cache_header const& vertex_animation_cache_writer::header() const
+{
+    return header_data;
+}
+
+int vertex_animation_cache_writer::chunk_size(int const k_chunk) const
+{
+    int const first = k_chunk*header_data.frames_per_chunk;
+    return std::min<int>(header_data.frames_per_chunk,header_data.N_frame-first);
+}
+
+std::size_t vertex_animation_cache_writer::size_written() const
+{
+    return size_written_data;
+}
+
+vertex_animation_cache::vertex_animation_cache()
+    :file(),header_data(),chunk_data()
+{
+    std::memset(&header_data,0,sizeof(header_data));
+}
+
+vertex_animation_cache::vertex_animation_cache(std::string const& filename)
+    :vertex_animation_cache()
+{
+    open(filename);
+}
+
+void vertex_animation_cache::open(std::string const& filename)
+{
+    if(!is_little_endian_host())
+        throw exception_cpe("Vertex animation caches can only be read on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    file.open(filename);
+    chunk_data.clear();
+    std::memset(&header_data,0,sizeof(header_data));
+
+    vertex_animation_cache_header header;
+    std::size_t const size = file.size();
+    if(size<sizeof(header) || std::memcmp(file.data(),"CPEVAC01",8)!=0)
+        throw exception_cpe("File "+filename+" is not a vertex animation cache",EXCEPTION_PARAMETERS_CPE);
+    std::memcpy(&header,file.data(),sizeof(header));
+    if(header.version!=1 || header.frames_per_chunk==0 || header.N_frame==0
+       || header.N_chunk!=(header.N_frame+header.frames_per_chunk-1)/header.frames_per_chunk
+       || size<sizeof(header)+header.N_chunk*sizeof(std::uint64_t))
+        throw exception_cpe("Incorrect header of vertex animation cache "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    //all the frames must be in the file
+    for(std::uint32_t k_chunk=0 ; k_chunk<header.N_chunk ; ++k_chunk)
+    {
+        std::uint64_t offset = 0;
+        std::memcpy(&offset,file.data()+sizeof(header)+k_chunk*sizeof(std::uint64_t),sizeof(offset));
+        std::size_t const N_frame_chunk = std::min(header.frames_per_chunk,header.N_frame-k_chunk*header.frames_per_chunk);
+        if(offset%sizeof(float)!=0 || offset>size || N_frame_chunk*size_frame(header)>size-offset)
+            throw exception_cpe("Truncated vertex animation cache "+filename,EXCEPTION_PARAMETERS_CPE);
+        chunk_data.push_back(file.data()+offset);
+    }
+    header_data = header;
+}
+
+int vertex_animation_cache::size() const
+{
+    return header_data.N_frame;
+}
+
+int vertex_animation_cache::size_vertex() const
+{
+    return header_data.N_vertex;
+}
+
+bool vertex_animation_cache::has_normal() const
+{
+    return header_data.has_normal!=0;
+}
+
+float vertex_animation_cache::frame_duration() const
+{
+    return header_data.frame_duration;
+}
+
+float const* vertex_animation_cache::position(int const frame) const
+{
+    ASSERT_CPE(frame>=0 && frame<size(),"Incorrect frame number");
+    char const* const chunk = chunk_data[frame/header_data.frames_per_chunk];
+    return reinterpret_cast<float const*>(chunk+(frame%header_data.frames_per_chunk)*size_frame(header_data));
+}
+
+float const* vertex_animation_cache::normal(int const frame) const
+{
+    if(!has_normal())
+        return nullptr;
+    return position(frame)+3*header_data.N_vertex;
+}
+
+void vertex_animation_cache::frame_at_time(float const time,int& frame,float& alpha) const
+{
+    ASSERT_CPE(size()>0,"Empty vertex animation cache");
+    float const f = header_data.frame_duration>0.0f? time/header_data.frame_duration : 0.0f;
+    float const f_floor = std::floor(f);
+    int const N_frame = size();
+    frame = ((static_cast<long long>(f_floor)%N_frame)+N_frame)%N_frame;
+    alpha = f-f_floor;
+}
+
+/** Write (1-alpha)*a+alpha*b */
+static void lerp_array(float const* const a,float const* const b,float const alpha,float* const output,int const N)
+{
+    for(int k=0 ; k<N ; ++k)
+        output[k] = a[k]+alpha*(b[k]-a[k]);
+}
+
+void vertex_animation_cache::interpolate(int const frame,float const alpha,float* const positions,float* const normals) const
+{
+    int const frame_next = (frame+1)%size();
+    int const N = 3*size_vertex();
+    lerp_array(position(frame),position(frame_next),alpha,positions,N);
+
+    if(normals!=nullptr && has_normal())
+    {
+        lerp_array(normal(frame),normal(frame_next),alpha,normals,N);
+        //the interpolated normals are slightly shorter
+        for(int k=0 ; k<N ; k+=3)
+        {
+            float const n = std::sqrt(normals[k]*normals[k]+normals[k+1]*normals[k+1]+normals[k+2]*normals[k+2]);
+            if(n>1e-6f)
+            {
+                normals[k] /= n;
+                normals[k+1] /= n;
+                normals[k+2] /= n;
+            }
+        }
+    }
+}
+
+vertex_animation_bake_parameter::vertex_animation_bake_parameter()
+    :frame_per_second(0.0f),with_normal(false),frames_per_chunk(32)
+{}
+
+vertex_animation_bake_report::vertex_animation_bake_report()
+    :N_frame(0),size_file(0),time_evaluation(0.0),time_write(0.0),time_total(0.0)
+{}
+
+double vertex_animation_bake_report::write_throughput() const
+{
+    if(time_write<=0.0)
+        return 0.0;
+    return size_file/(1024.0*1024.0)/time_write;
+}
+
+static double elapsed_seconds(std::chrono::steady_clock::time_point const& t0,std::chrono::steady_clock::time_point const& t1)
+{
+    return std::chrono::duration<double>(t1-t0).count();
+}
+
+vertex_animation_bake_report bake_vertex_animation(std::string const& filename,mesh_skinned const& mesh,
+                                                   skeleton_parent_id const& parent_id,skeleton_geometry const& bind_pose,
+                                                   skeleton_animation const& animation,float const keyframe_per_second,
+                                                   vertex_animation_bake_parameter const& parameter)
+{
+    std::chrono::steady_clock::time_point const t_start = std::chrono::steady_clock::now();
+
+    int const N_keyframe = animation.size();
+    int const N_vertex = mesh.size_vertex();
+    ASSERT_CPE(N_keyframe>0,"Animation without keyframe");
+    ASSERT_CPE(keyframe_per_second>0.0f,"Incorrect keyframe rate");
+    ASSERT_CPE(bind_pose.size()==parent_id.size(),"Incorrect skeleton size");
+    ASSERT_CPE(!parameter.with_normal || mesh.size_normal()==N_vertex,"The mesh has no normals");
+
+    //one cycle of the animation at the requested rate
+    float const frame_per_second = parameter.frame_per_second>0.0f? parameter.frame_per_second : keyframe_per_second;
+    int const N_frame = std::max(1,static_cast<int>(std::round(N_keyframe*frame_per_second/keyframe_per_second)));
+
+    vertex_animation_cache_writer writer;
+    writer.open(filename,N_vertex,N_frame,parameter.with_normal,1.0f/frame_per_second,parameter.frames_per_chunk);
+    std::size_t const floats_per_frame = size_frame(writer.header())/sizeof(float);
+    int const N_chunk = writer.header().N_chunk;
+
+    skeleton_geometry const bind_pose_inverse = inversed(bind_pose);
+
+    //two buffers: a chunk is evaluated while the previous one is written
+    std::vector<float> buffer[2];
+    for(std::vector<float>& b : buffer)
+        b.resize(floats_per_frame*parameter.frames_per_chunk);
+    std::future<double> pending_write;
+
+    vertex_animation_bake_report report;
+    for(int k_chunk=0 ; k_chunk<N_chunk ; ++k_chunk)
+    {
+        std::vector<float>& chunk = buffer[k_chunk%2];
+        int const first = k_chunk*parameter.frames_per_chunk;
+        int const N_frame_chunk = writer.chunk_size(k_chunk);
+
+        //the buffer was written two chunks ago: its write is already finished
+        std::chrono::steady_clock::time_point const t_evaluation = std::chrono::steady_clock::now();
+        parallel_for(N_frame_chunk,[&](int const begin,int const end)
+        {
+            for(int k=begin ; k<end ; ++k)
+            {
+                float const keyframe = (first+k)*keyframe_per_second/frame_per_second;
+                int const frame = static_cast<int>(keyframe)%N_keyframe;
+                float const alpha = keyframe-std::floor(keyframe);
+
+                skeleton_geometry const palette = multiply(local_to_global(animation(frame,alpha),parent_id),bind_pose_inverse);
+                float* const positions = &chunk[floats_per_frame*k];
+                mesh.compute_skinning(palette,positions,parameter.with_normal? positions+3*N_vertex : nullptr);
+            }
+        },1);
+        report.time_evaluation += elapsed_seconds(t_evaluation,std::chrono::steady_clock::now());
+
+        if(pending_write.valid())
+            report.time_write += pending_write.get();
+        float const* const data = chunk.data();
+        pending_write = std::async(std::launch::async,[&writer,data]()
+        {
+            std::chrono::steady_clock::time_point const t0 = std::chrono::steady_clock::now();
+            writer.write_chunk(data);
+            return elapsed_seconds(t0,std::chrono::steady_clock::now());
+        });
+    }
+    if(pending_write.valid())
+        report.time_write += pending_write.get();
+    writer.close();
+
+    report.N_frame = N_frame;
+    report.size_file = writer.size_written();
+    report.time_total = elapsed_seconds(t_start,std::chrono::steady_clock::now());
+    return report;
+}
+
+}
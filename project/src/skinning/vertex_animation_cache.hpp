@@ -0,0 +1,179 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef VERTEX_ANIMATION_CACHE_HPP
+#define VERTEX_ANIMATION_CACHE_HPP
+
+#include "../lib/common/mapped_file.hpp"
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cpe
+{
+
+class mesh_skinned;
+class skeleton_parent_id;
+class skeleton_geometry;
+class skeleton_animation;
+
+/** Header of a vertex animation cache file (little endian).
+ *  The file stores the deformed vertices (and optionally the normals) of a mesh at regularly spaced frames:
+ *  - the header, followed by the offset of each chunk in the file (N_chunk uint64),
+ *  - the chunks, each one aligned on vertex_animation_cache_alignment bytes, storing frames_per_chunk consecutive frames
+ *    (fewer for the last chunk).
+ *  A frame stores 3*N_vertex floats for the positions, followed by 3*N_vertex floats for the normals if they are present.
+ */
+struct vertex_animation_cache_header
+{
+    char magic[8];                  // "CPEVAC01"
+    std::uint32_t version;          // version of the format (1)
+    std::uint32_t N_vertex;         // number of vertices per frame
+    std::uint32_t N_frame;          // number of frames
+    std::uint32_t frames_per_chunk; // number of frames per chunk
+    std::uint32_t N_chunk;          // number of chunks
+    std::uint32_t has_normal;       // 1 if the frames store the normals
+    float frame_duration;           // duration of a frame (in seconds)
+    std::uint32_t reserved[7];      // 0
+};
+
+/** Alignment of the chunks of the cache in the file (size of a memory page) */
+std::size_t const vertex_animation_cache_alignment = 4096;
+
+/** Size of a frame of the cache (in bytes) */
+std::size_t size_frame(vertex_animation_cache_header const& header);
+
+/** Write a vertex animation cache file, chunk after chunk.
+ *  The chunks are written at once from the caller's buffer: the only copies are the ones of the system. */
+class vertex_animation_cache_writer
+{
+public:
+
+    vertex_animation_cache_writer();
+
+    /** Create the file and write its header, throw an exception if it cannot be created */
+    void open(std::string const& filename,int N_vertex,int N_frame,bool has_normal,float frame_duration,int frames_per_chunk);
+    /** Write the next chunk: the frames are given consecutively (chunk_size(k) frames for the k-th chunk) */
+    void write_chunk(float const* frames);
+    /** Write the offsets of the chunks and close the file, throw an exception if all the chunks were not written */
+    void close();
+
+    /** Header of the file being written */
+    vertex_animation_cache_header const& header() const;
+    /** Number of frames of the k-th chunk */
+    int chunk_size(int k_chunk) const;
+    /** Number of bytes written in the file */
+    std::size_t size_written() const;
+
+private:
+
+    std::ofstream stream;
+    std::string filename;
+    vertex_animation_cache_header header_data;
+    /** Offset of each chunk already written */
+    std::vector<std::uint64_t> chunk_offset;
+    /** Number of bytes written in the file */
+    std::size_t size_written_data;
+};
+
+/** A vertex animation cache file mapped in memory (see vertex_animation_cache_header).
+ *  The frames are read in place: the pages of the file are only loaded by the system when they are accessed. */
+class vertex_animation_cache
+{
+public:
+
+    vertex_animation_cache();
+    /** Map the given file (see open) */
+    explicit vertex_animation_cache(std::string const& filename);
+
+    /** Map a cache file, throw an exception if it is not a valid cache */
+    void open(std::string const& filename);
+
+    /** Number of frames */
+    int size() const;
+    /** Number of vertices per frame */
+    int size_vertex() const;
+    /** Check if the frames store the normals */
+    bool has_normal() const;
+    /** Duration of a frame (in seconds) */
+    float frame_duration() const;
+
+    /** The 3*size_vertex() positions of a frame */
+    float const* position(int frame) const;
+    /** The 3*size_vertex() normals of a frame (nullptr if the cache has no normals) */
+    float const* normal(int frame) const;
+
+    /** The frame and the interpolation coefficient (in [0,1[) at a given time, the frames being played cyclically */
+    void frame_at_time(float time,int& frame,float& alpha) const;
+    /** Linear interpolation between a frame and the next one (the first one follows the last one).
+     * \param positions: 3*size_vertex() floats receiving the positions.
+     * \param normals: 3*size_vertex() floats receiving the normals (nothing is written if nullptr or if the cache has no normals). */
+    void interpolate(int frame,float alpha,float* positions,float* normals=nullptr) const;
+
+private:
+
+    /** Mapping of the file */
+    mapped_file file;
+    /** Header of the file */
+    vertex_animation_cache_header header_data;
+    /** Address of the first frame of each chunk */
+    std::vector<char const*> chunk_data;
+};
+
+/** Parameters of bake_vertex_animation */
+struct vertex_animation_bake_parameter
+{
+    vertex_animation_bake_parameter();
+
+    float frame_per_second;     // rate of the baked frames (0: rate of the keyframes)
+    bool with_normal;           // store the deformed normals
+    int frames_per_chunk;       // number of frames evaluated in parallel and written at once
+};
+
+/** Timings of bake_vertex_animation */
+struct vertex_animation_bake_report
+{
+    vertex_animation_bake_report();
+
+    int N_frame;                // number of baked frames
+    std::size_t size_file;      // size of the cache file (in bytes)
+    double time_evaluation;     // time spent evaluating the frames (in seconds)
+    double time_write;          // time spent writing the chunks in the file, overlapped with the evaluation (in seconds)
+    double time_total;          // total time of the bake (in seconds)
+
+    /** Write throughput (in MB/s) */
+    double write_throughput() const;
+};
+
+/** Evaluate the skinned mesh over one cycle of the animation and store the deformed frames in a cache file.
+ *  The frames of a chunk are evaluated in parallel, while the previous chunk is written by another thread.
+ * \param bind_pose: frames of the joints in the bind pose, in global coordinates.
+ * \param animation: keyframes of the joints with respect to their parent, played cyclically at keyframe_per_second. */
+vertex_animation_bake_report bake_vertex_animation(std::string const& filename,mesh_skinned const& mesh,
+                                                   skeleton_parent_id const& parent_id,skeleton_geometry const& bind_pose,
+                                                   skeleton_animation const& animation,float keyframe_per_second,
+                                                   vertex_animation_bake_parameter const& parameter=vertex_animation_bake_parameter());
+
+}
+
+#endif
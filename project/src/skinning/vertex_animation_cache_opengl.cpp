@@ -0,0 +1,74 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "vertex_animation_cache_opengl.hpp"
+
+#include "vertex_animation_cache.hpp"
+#include "vertex_animation_pca.hpp"
+#include "../lib/opengl/mesh_opengl.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <functional>
+
+namespace cpe
+{
+
+/** Map the VBOs of the mesh, write the frame into them with the interpolation function (normals is nullptr without normals),
+ *  then unmap them. The content of a buffer lost while mapped is undefined: the frame is written once again. */
+static void write_mapped_frame(mesh_opengl& vbo,int const N_vertex,bool const with_normal,
+                               std::function<void(float* positions,float* normals)> const& interpolate)
+{
+    for(int k_attempt=0 ; k_attempt<2 ; ++k_attempt)
+    {
+        float* const positions = vbo.map_vbo_vertex(N_vertex);
+        float* const normals = with_normal? vbo.map_vbo_normal(N_vertex) : nullptr;
+        interpolate(positions,normals);
+
+        bool const valid_position = vbo.unmap_vbo_vertex();
+        bool const valid_normal = !with_normal || vbo.unmap_vbo_normal();
+        if(valid_position && valid_normal)
+            return;
+    }
+    throw exception_cpe("The vertex buffers were lost while writing the vertex animation",EXCEPTION_PARAMETERS_CPE);
+}
+
+void upload_vertex_cache(mesh_opengl& vbo,vertex_animation_cache const& cache,float const time)
+{
+    int frame=0;
+    float alpha=0.0f;
+    cache.frame_at_time(time,frame,alpha);
+
+    write_mapped_frame(vbo,cache.size_vertex(),cache.has_normal(),[&](float* const positions,float* const normals)
+    {
+        cache.interpolate(frame,alpha,positions,normals);
+    });
+}
+
+void upload_vertex_cache(mesh_opengl& vbo,vertex_animation_pca const& cache,float const time)
+{
+    int frame=0;
+    float alpha=0.0f;
+    cache.frame_at_time(time,frame,alpha);
+
+    write_mapped_frame(vbo,cache.size_vertex(),false,[&](float* const positions,float*)
+    {
+        cache.interpolate(frame,alpha,positions);
+    });
+}
+
+}
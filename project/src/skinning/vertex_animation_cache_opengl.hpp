@@ -0,0 +1,43 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef VERTEX_ANIMATION_CACHE_OPENGL_HPP
+#define VERTEX_ANIMATION_CACHE_OPENGL_HPP
+
+namespace cpe
+{
+
+class mesh_opengl;
+class vertex_animation_cache;
+class vertex_animation_pca;
+
+/** Send the positions (and the normals if the cache stores them) of a baked vertex animation at a given time
+ *   to a mesh_opengl with the dynamic_position layout.
+ *  The two surrounding frames are read from the mapped cache file and interpolated directly into the mapped VBOs:
+ *  there is no skinning and no intermediate copy of the vertices. The frame is written again if a buffer is lost while mapped.
+ *  \note Without normals in the cache, the normals are the ones sent by fill_vbo. */
+void upload_vertex_cache(mesh_opengl& vbo,vertex_animation_cache const& cache,float time);
+/** Send the positions of a compressed vertex animation at a given time: the interpolated frame is reconstructed
+ *  directly into the mapped VBO (see upload_vertex_cache). The compressed animations do not store the normals. */
+void upload_vertex_cache(mesh_opengl& vbo,vertex_animation_pca const& cache,float time);
+
+}
+
+#endif
@@ -0,0 +1,568 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "vertex_animation_pca.hpp"
+
+#include "vertex_animation_cache.hpp"
+#include "../lib/mesh/mesh_simd.hpp"
+#include "../lib/common/parallel_for.hpp"
+#include "../lib/common/error_handling.hpp"
+
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+namespace cpe
+{
+
+static_assert(sizeof(vertex_animation_pca_header)==64,"Unexpected padding in the header of the compressed vertex animation");
+
+static bool is_little_endian_host()
+{
+    std::uint32_t const value = 1;
+    unsigned char first_byte = 0;
+    std::memcpy(&first_byte,&value,1);
+    return first_byte==1;
+}
+
+vertex_animation_pca_parameter::vertex_animation_pca_parameter()
+    :tolerance(1e-2f),max_component(256)
+{}
+
+vertex_animation_pca_report::vertex_animation_pca_report()
+    :N_component(0),size_raw(0),size_compressed(0),max_error(0.0f),rms_error(0.0f),time_total(0.0)
+{}
+
+double vertex_animation_pca_report::compression_ratio() const
+{
+    if(size_compressed==0)
+        return 0.0;
+    return static_cast<double>(size_raw)/size_compressed;
+}
+
+/** Dot product of two arrays of floats */
+static float dot_product(float const* const a,float const* const b,int const N)
+{
+    int k = 0;
+    float sum = 0.0f;
+#ifdef __SSE__
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    for( ; k+8<=N ; k+=8)
+    {
+        s0 = _mm_add_ps(s0,_mm_mul_ps(_mm_loadu_ps(a+k),_mm_loadu_ps(b+k)));
+        s1 = _mm_add_ps(s1,_mm_mul_ps(_mm_loadu_ps(a+k+4),_mm_loadu_ps(b+k+4)));
+    }
+    sum = horizontal_sum(_mm_add_ps(s0,s1));
+#endif
+    for( ; k<N ; ++k)
+        sum += a[k]*b[k];
+    return sum;
+}
+
+/** Eigen decomposition of a symmetric matrix (n*n, row major): Householder reduction to a tridiagonal matrix,
+ *  then QL algorithm with implicit shifts (as in the EISPACK routines tred2 and tql2).
+ *  The eigenvalues are sorted by decreasing value, the k-th eigenvector is the column k of the matrix V. */
+static void symmetric_eigen_decomposition(std::vector<double> const& A,int const n,std::vector<double>& eigenvalue,std::vector<double>& V)
+{
+    V = A;
+    std::vector<double> d(n,0.0),e(n,0.0);
+    auto const v = [&V,n](int const row,int const col)->double& {return V[static_cast<std::size_t>(row)*n+col];};
+    if(n==0)
+    {
+        eigenvalue.clear();
+        return;
+    }
+
+    //Householder reduction to tridiagonal form
+    for(int j=0 ; j<n ; ++j)
+        d[j] = v(n-1,j);
+    for(int i=n-1 ; i>0 ; --i)
+    {
+        double scale = 0.0;
+        double h = 0.0;
+        for(int k=0 ; k<i ; ++k)
+            scale += std::abs(d[k]);
+        if(scale==0.0)
+        {
+            e[i] = d[i-1];
+            for(int j=0 ; j<i ; ++j)
+            {
+                d[j] = v(i-1,j);
+                v(i,j) = 0.0;
+                v(j,i) = 0.0;
+            }
+        }
+        else
+        {
+            for(int k=0 ; k<i ; ++k)
+            {
+                d[k] /= scale;
+                h += d[k]*d[k];
+            }
+            double f = d[i-1];
+            double g = f>0? -std::sqrt(h) : std::sqrt(h);
+            e[i] = scale*g;
+            h -= f*g;
+            d[i-1] = f-g;
+            for(int j=0 ; j<i ; ++j)
+                e[j] = 0.0;
+
+            for(int j=0 ; j<i ; ++j)
+            {
+                f = d[j];
+                v(j,i) = f;
+                g = e[j]+v(j,j)*f;
+                for(int k=j+1 ; k<=i-1 ; ++k)
+                {
+                    g += v(k,j)*d[k];
+                    e[k] += v(k,j)*f;
+                }
+                e[j] = g;
+            }
+            f = 0.0;
+            for(int j=0 ; j<i ; ++j)
+            {
+                e[j] /= h;
+                f += e[j]*d[j];
+            }
+            double const hh = f/(h+h);
+            for(int j=0 ; j<i ; ++j)
+                e[j] -= hh*d[j];
+            for(int j=0 ; j<i ; ++j)
+            {
+                f = d[j];
+                g = e[j];
+                for(int k=j ; k<=i-1 ; ++k)
+                    v(k,j) -= f*e[k]+g*d[k];
+                d[j] = v(i-1,j);
+                v(i,j) = 0.0;
+            }
+        }
+        d[i] = h;
+    }
+
+    //accumulate the transformations
+    for(int i=0 ; i<n-1 ; ++i)
+    {
+        v(n-1,i) = v(i,i);
+        v(i,i) = 1.0;
+        double const h = d[i+1];
+        if(h!=0.0)
+        {
+            for(int k=0 ; k<=i ; ++k)
+                d[k] = v(k,i+1)/h;
+            for(int j=0 ; j<=i ; ++j)
+            {
+                double g = 0.0;
+                for(int k=0 ; k<=i ; ++k)
+                    g += v(k,i+1)*v(k,j);
+                for(int k=0 ; k<=i ; ++k)
+                    v(k,j) -= g*d[k];
+            }
+        }
+        for(int k=0 ; k<=i ; ++k)
+            v(k,i+1) = 0.0;
+    }
+    for(int j=0 ; j<n ; ++j)
+    {
+        d[j] = v(n-1,j);
+        v(n-1,j) = 0.0;
+    }
+    v(n-1,n-1) = 1.0;
+    e[0] = 0.0;
+
+    //QL algorithm on the tridiagonal matrix
+    for(int i=1 ; i<n ; ++i)
+        e[i-1] = e[i];
+    e[n-1] = 0.0;
+
+    double f = 0.0;
+    double tst1 = 0.0;
+    double const eps = std::ldexp(1.0,-52);
+    for(int l=0 ; l<n ; ++l)
+    {
+        tst1 = std::max(tst1,std::abs(d[l])+std::abs(e[l]));
+        int m = l;
+        while(m<n-1 && std::abs(e[m])>eps*tst1)
+            ++m;
+
+        if(m>l)
+        {
+            int iteration = 0;
+            do
+            {
+                if(++iteration>60)
+                    throw exception_cpe("No convergence of the eigen decomposition",EXCEPTION_PARAMETERS_CPE);
+
+                double g = d[l];
+                double p = (d[l+1]-g)/(2.0*e[l]);
+                double r = std::hypot(p,1.0);
+                if(p<0)
+                    r = -r;
+                d[l] = e[l]/(p+r);
+                d[l+1] = e[l]*(p+r);
+                double const dl1 = d[l+1];
+                double h = g-d[l];
+                for(int i=l+2 ; i<n ; ++i)
+                    d[i] -= h;
+                f += h;
+
+                p = d[m];
+                double c = 1.0, c2 = 1.0, c3 = 1.0;
+                double const el1 = e[l+1];
+                double s = 0.0, s2 = 0.0;
+                for(int i=m-1 ; i>=l ; --i)
+                {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c*e[i];
+                    h = c*p;
+                    r = std::hypot(p,e[i]);
+                    e[i+1] = s*r;
+                    s = e[i]/r;
+                    c = p/r;
+                    p = c*d[i]-s*g;
+                    d[i+1] = h+s*(c*g+s*d[i]);
+                    for(int k=0 ; k<n ; ++k)
+                    {
+                        h = v(k,i+1);
+                        v(k,i+1) = s*v(k,i)+c*h;
+                        v(k,i) = c*v(k,i)-s*h;
+                    }
+                }
+                p = -s*s2*c3*el1*e[l]/dl1;
+                e[l] = s*p;
+                d[l] = c*p;
+            } while(std::abs(e[l])>eps*tst1);
+        }
+        d[l] += f;
+        e[l] = 0.0;
+    }
+
+    //sort by decreasing eigenvalue
+    std::vector<int> order(n);
+    std::iota(order.begin(),order.end(),0);
+    std::sort(order.begin(),order.end(),[&d](int a,int b){return d[a]>d[b];});
+    std::vector<double> const V_unsorted = V;
+    eigenvalue.resize(n);
+    for(int k=0 ; k<n ; ++k)
+    {
+        eigenvalue[k] = d[order[k]];
+        for(int row=0 ; row<n ; ++row)
+            v(row,k) = V_unsorted[static_cast<std::size_t>(row)*n+order[k]];
+    }
+}
+
+/** Largest vertex error and sum of the squared vertex errors of the residual frames [begin,end[ */
+static void residual_error(std::vector<float> const& residual,int const N_value,int const begin,int const end,float& max_error,double& squared_error)
+{
+    max_error = 0.0f;
+    squared_error = 0.0;
+    for(int f=begin ; f<end ; ++f)
+    {
+        float const* const r = &residual[static_cast<std::size_t>(f)*N_value];
+        float max_squared = 0.0f;
+        double sum = 0.0;
+        for(int k=0 ; k<N_value ; k+=3)
+        {
+            float const e = r[k]*r[k]+r[k+1]*r[k+1]+r[k+2]*r[k+2];
+            max_squared = std::max(max_squared,e);
+            sum += e;
+        }
+        max_error = std::max(max_error,std::sqrt(max_squared));
+        squared_error += sum;
+    }
+}
+
+vertex_animation_pca_report compress_vertex_animation(vertex_animation_cache const& cache,std::string const& filename,
+                                                      vertex_animation_pca_parameter const& parameter)
+{
+    std::chrono::steady_clock::time_point const t_start = std::chrono::steady_clock::now();
+    if(!is_little_endian_host())
+        throw exception_cpe("Compressed vertex animations can only be written on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    int const N_frame = cache.size();
+    int const N_vertex = cache.size_vertex();
+    int const N_value = 3*N_vertex;
+    int const N_block = (N_value+3)/4;
+    ASSERT_CPE(N_frame>0,"Empty vertex animation cache");
+
+    //mean frame
+    std::vector<double> mean_sum(N_value,0.0);
+    for(int f=0 ; f<N_frame ; ++f)
+    {
+        float const* const p = cache.position(f);
+        for(int k=0 ; k<N_value ; ++k)
+            mean_sum[k] += p[k];
+    }
+    std::vector<float> mean(4*N_block,0.0f);
+    for(int k=0 ; k<N_value ; ++k)
+        mean[k] = static_cast<float>(mean_sum[k]/N_frame);
+
+    //centered frames: they become the residual of the reconstruction when the components are added
+    std::vector<float> residual(static_cast<std::size_t>(N_frame)*N_value);
+    parallel_for(N_frame,[&](int const begin,int const end)
+    {
+        for(int f=begin ; f<end ; ++f)
+        {
+            float const* const p = cache.position(f);
+            float* const r = &residual[static_cast<std::size_t>(f)*N_value];
+            for(int k=0 ; k<N_value ; ++k)
+                r[k] = p[k]-mean[k];
+        }
+    },1);
+
+    //Gram matrix of the centered frames, its eigenvectors give the coefficients of the principal components
+    std::vector<double> gram(static_cast<std::size_t>(N_frame)*N_frame);
+    parallel_for(N_frame,[&](int const begin,int const end)
+    {
+        for(int a=begin ; a<end ; ++a)
+            for(int b=0 ; b<=a ; ++b)
+                gram[static_cast<std::size_t>(a)*N_frame+b] = dot_product(&residual[static_cast<std::size_t>(a)*N_value],&residual[static_cast<std::size_t>(b)*N_value],N_value);
+    },1);
+    for(int a=0 ; a<N_frame ; ++a)
+        for(int b=a+1 ; b<N_frame ; ++b)
+            gram[static_cast<std::size_t>(a)*N_frame+b] = gram[static_cast<std::size_t>(b)*N_frame+a];
+
+    std::vector<double> eigenvalue,eigenvector;
+    symmetric_eigen_decomposition(gram,N_frame,eigenvalue,eigenvector);
+
+    //error of the mean alone
+    vertex_animation_pca_report report;
+    int const N_chunk = std::max(1,parallel_for_chunk_count(N_frame,1));
+    std::vector<float> chunk_max_error(N_chunk);
+    std::vector<double> chunk_squared_error(N_chunk);
+    auto const compute_error = [&]()
+    {
+        parallel_for(N_chunk,[&](int const begin,int const end)
+        {
+            for(int k=begin ; k<end ; ++k)
+                residual_error(residual,N_value,static_cast<long long>(N_frame)*k/N_chunk,static_cast<long long>(N_frame)*(k+1)/N_chunk,chunk_max_error[k],chunk_squared_error[k]);
+        },1);
+        report.max_error = *std::max_element(chunk_max_error.begin(),chunk_max_error.end());
+        double const squared_error = std::accumulate(chunk_squared_error.begin(),chunk_squared_error.end(),0.0);
+        report.rms_error = static_cast<float>(std::sqrt(squared_error/(static_cast<double>(N_frame)*std::max(1,N_vertex))));
+    };
+    compute_error();
+
+    //the components are added by decreasing variance until the tolerance is reached
+    std::vector<std::vector<float>> basis;
+    std::vector<std::vector<float>> coefficient;
+    double const eigenvalue_min = 1e-12*std::max(eigenvalue.size()>0? eigenvalue[0] : 0.0,1e-30);
+    for(int i=0 ; i<N_frame && i<parameter.max_component && report.max_error>parameter.tolerance ; ++i)
+    {
+        if(eigenvalue[i]<=eigenvalue_min)
+            break;
+
+        //component: normalized combination of the frames (u_i.residual = u_i.centered frames, as u_i is orthogonal to the previous components)
+        double const sigma = std::sqrt(eigenvalue[i]);
+        std::vector<float> u(N_frame),c(N_frame);
+        for(int f=0 ; f<N_frame ; ++f)
+            u[f] = static_cast<float>(eigenvector[static_cast<std::size_t>(f)*N_frame+i]/sigma);
+
+        std::vector<float> b(4*N_block,0.0f);
+        parallel_for(N_value,[&](int const begin,int const end)
+        {
+            for(int f=0 ; f<N_frame ; ++f)
+            {
+                float const* const r = &residual[static_cast<std::size_t>(f)*N_value];
+                for(int k=begin ; k<end ; ++k)
+                    b[k] += u[f]*r[k];
+            }
+        },4096);
+
+        //the coefficients are projections on the stored (float) basis: the reconstruction error is the one measured here
+        parallel_for(N_frame,[&](int const begin,int const end)
+        {
+            for(int f=begin ; f<end ; ++f)
+            {
+                float* const r = &residual[static_cast<std::size_t>(f)*N_value];
+                c[f] = dot_product(r,&b[0],N_value)/std::max(dot_product(&b[0],&b[0],N_value),1e-30f);
+                for(int k=0 ; k<N_value ; ++k)
+                    r[k] -= c[f]*b[k];
+            }
+        },1);
+
+        basis.push_back(std::move(b));
+        coefficient.push_back(std::move(c));
+        compute_error();
+    }
+    int const N_component = basis.size();
+
+    //file
+    vertex_animation_pca_header header;
+    std::memset(&header,0,sizeof(header));
+    std::memcpy(header.magic,"CPEPCA01",8);
+    header.version = 1;
+    header.N_vertex = N_vertex;
+    header.N_frame = N_frame;
+    header.N_component = N_component;
+    header.N_block = N_block;
+    header.frame_duration = cache.frame_duration();
+
+    std::vector<float> basis_block(static_cast<std::size_t>(N_block)*N_component*4);
+    for(int k_block=0 ; k_block<N_block ; ++k_block)
+        for(int i=0 ; i<N_component ; ++i)
+            std::memcpy(&basis_block[(static_cast<std::size_t>(k_block)*N_component+i)*4],&basis[i][4*k_block],4*sizeof(float));
+    std::vector<float> coefficient_frame(static_cast<std::size_t>(N_frame)*N_component);
+    for(int f=0 ; f<N_frame ; ++f)
+        for(int i=0 ; i<N_component ; ++i)
+            coefficient_frame[static_cast<std::size_t>(f)*N_component+i] = coefficient[i][f];
+
+    std::ofstream stream(filename.c_str(),std::ios::binary|std::ios::trunc);
+    if(!stream.good())
+        throw exception_cpe("Cannot open file "+filename,EXCEPTION_PARAMETERS_CPE);
+    stream.write(reinterpret_cast<char const*>(&header),sizeof(header));
+    stream.write(reinterpret_cast<char const*>(mean.data()),mean.size()*sizeof(float));
+    stream.write(reinterpret_cast<char const*>(basis_block.data()),basis_block.size()*sizeof(float));
+    stream.write(reinterpret_cast<char const*>(coefficient_frame.data()),coefficient_frame.size()*sizeof(float));
+    stream.close();
+    if(stream.fail())
+        throw exception_cpe("Cannot write file "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    report.N_component = N_component;
+    report.size_raw = static_cast<std::size_t>(N_frame)*N_value*sizeof(float);
+    report.size_compressed = sizeof(header)+(mean.size()+basis_block.size()+coefficient_frame.size())*sizeof(float);
+    report.time_total = std::chrono::duration<double>(std::chrono::steady_clock::now()-t_start).count();
+    return report;
+}
+
+vertex_animation_pca::vertex_animation_pca()
+    :file(),header_data(),mean(nullptr),basis(nullptr),coefficients(nullptr)
+{
+    std::memset(&header_data,0,sizeof(header_data));
+}
+
+vertex_animation_pca::vertex_animation_pca(std::string const& filename)
+    :vertex_animation_pca()
+{
+    open(filename);
+}
+
+void vertex_animation_pca::open(std::string const& filename)
+{
+    if(!is_little_endian_host())
+        throw exception_cpe("Compressed vertex animations can only be read on little endian hosts",EXCEPTION_PARAMETERS_CPE);
+
+    file.open(filename);
+    std::memset(&header_data,0,sizeof(header_data));
+    mean = basis = coefficients = nullptr;
+
+    vertex_animation_pca_header header;
+    std::size_t const size = file.size();
+    if(size<sizeof(header) || std::memcmp(file.data(),"CPEPCA01",8)!=0)
+        throw exception_cpe("File "+filename+" is not a compressed vertex animation",EXCEPTION_PARAMETERS_CPE);
+    std::memcpy(&header,file.data(),sizeof(header));
+
+    std::size_t const size_mean = 4*std::size_t(header.N_block);
+    std::size_t const size_basis = size_mean*header.N_component;
+    std::size_t const size_coefficient = std::size_t(header.N_frame)*header.N_component;
+    if(header.version!=1 || header.N_frame==0 || header.N_block!=(3*header.N_vertex+3)/4
+       || size!=sizeof(header)+(size_mean+size_basis+size_coefficient)*sizeof(float))
+        throw exception_cpe("Incorrect compressed vertex animation "+filename,EXCEPTION_PARAMETERS_CPE);
+
+    header_data = header;
+    mean = reinterpret_cast<float const*>(file.data()+sizeof(header));
+    basis = mean+size_mean;
+    coefficients = basis+size_basis;
+}
+
+int vertex_animation_pca::size() const
+{
+    return header_data.N_frame;
+}
+
+int vertex_animation_pca::size_vertex() const
+{
+    return header_data.N_vertex;
+}
+
+int vertex_animation_pca::size_component() const
+{
+    return header_data.N_component;
+}
+
+float vertex_animation_pca::frame_duration() const
+{
+    return header_data.frame_duration;
+}
+
+void vertex_animation_pca::frame_at_time(float const time,int& frame,float& alpha) const
+{
+    ASSERT_CPE(size()>0,"Empty compressed vertex animation");
+    float const f = header_data.frame_duration>0.0f? time/header_data.frame_duration : 0.0f;
+    float const f_floor = std::floor(f);
+    int const N_frame = size();
+    frame = ((static_cast<long long>(f_floor)%N_frame)+N_frame)%N_frame;
+    alpha = f-f_floor;
+}
+
+void vertex_animation_pca::interpolate(int const frame,float const alpha,float* const positions) const
+{
+    ASSERT_CPE(frame>=0 && frame<size(),"Incorrect frame number");
+    int const N_component = size_component();
+    int const frame_next = (frame+1)%size();
+
+    std::vector<float> c(N_component);
+    float const* const c0 = coefficients+static_cast<std::size_t>(frame)*N_component;
+    float const* const c1 = coefficients+static_cast<std::size_t>(frame_next)*N_component;
+    for(int i=0 ; i<N_component ; ++i)
+        c[i] = c0[i]+alpha*(c1[i]-c0[i]);
+    reconstruct(c.data(),positions);
+}
+
+void vertex_animation_pca::reconstruct(float const* const c,float* const positions) const
+{
+    int const N_component = size_component();
+    int const N_block = header_data.N_block;
+    int const N_value = 3*size_vertex();
+
+    //each block of 4 values is accumulated in a register over all the components (contiguous in the file)
+    for(int k_block=0 ; k_block<N_block ; ++k_block)
+    {
+        float const* const b = basis+static_cast<std::size_t>(k_block)*N_component*4;
+        float value[4];
+#ifdef __SSE__
+        __m128 sum = _mm_loadu_ps(mean+4*k_block);
+        for(int i=0 ; i<N_component ; ++i)
+            sum = _mm_add_ps(sum,_mm_mul_ps(_mm_set1_ps(c[i]),_mm_loadu_ps(b+4*i)));
+        if(4*k_block+4<=N_value)
+        {
+            _mm_storeu_ps(positions+4*k_block,sum);
+            continue;
+        }
+        _mm_storeu_ps(value,sum);
+#else
+        for(int j=0 ; j<4 ; ++j)
+        {
+            value[j] = mean[4*k_block+j];
+            for(int i=0 ; i<N_component ; ++i)
+                value[j] += c[i]*b[4*i+j];
+        }
+#endif
+        for(int j=0 ; j<4 && 4*k_block+j<N_value ; ++j)
+            positions[4*k_block+j] = value[j];
+    }
+}
+
+}
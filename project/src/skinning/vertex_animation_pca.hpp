@@ -0,0 +1,134 @@
+/*
+**    TP CPE Lyon
+**    Copyright (C) 2015 Damien Rohmer
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**   This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#ifndef VERTEX_ANIMATION_PCA_HPP
+#define VERTEX_ANIMATION_PCA_HPP
+
+#include "../lib/common/mapped_file.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace cpe
+{
+
+class vertex_animation_cache;
+
+/** Header of a compressed vertex animation file (little endian).
+ *  The positions of frame f are mean + sum_i coefficient[f][i]*basis[i] (truncated PCA of the frames of a vertex animation cache).
+ *  The header is followed by:
+ *  - the mean: 4*N_block floats (3*N_vertex values, padded with zeros),
+ *  - the basis: N_block*N_component*4 floats, stored by blocks of 4 values: the block b of the component i is at (b*N_component+i)*4,
+ *  - the coefficients: N_frame*N_component floats.
+ *  The normals are not stored.
+ */
+struct vertex_animation_pca_header
+{
+    char magic[8];                  // "CPEPCA01"
+    std::uint32_t version;          // version of the format (1)
+    std::uint32_t N_vertex;         // number of vertices per frame
+    std::uint32_t N_frame;          // number of frames
+    std::uint32_t N_component;      // number of components of the basis
+    std::uint32_t N_block;          // number of blocks of 4 values of a frame, ceil(3*N_vertex/4)
+    float frame_duration;           // duration of a frame (in seconds)
+    std::uint32_t reserved[8];      // 0
+};
+
+/** Parameters of compress_vertex_animation */
+struct vertex_animation_pca_parameter
+{
+    vertex_animation_pca_parameter();
+
+    float tolerance;                // maximal distance between a compressed and an original vertex
+    int max_component;              // maximal number of components (the tolerance may not be reached)
+};
+
+/** Result of compress_vertex_animation */
+struct vertex_animation_pca_report
+{
+    vertex_animation_pca_report();
+
+    int N_component;                // number of components kept
+    std::size_t size_raw;           // size of the uncompressed positions (in bytes)
+    std::size_t size_compressed;    // size of the compressed file (in bytes)
+    float max_error;                // maximal distance between a compressed and an original vertex
+    float rms_error;                // root mean square of the distance between the compressed and the original vertices
+    double time_total;              // time of the compression (in seconds)
+
+    /** Ratio between the uncompressed and the compressed sizes */
+    double compression_ratio() const;
+};
+
+/** Compress the positions of a vertex animation cache with a truncated PCA of its frames.
+ *  The principal components are obtained from the eigen decomposition of the Gram matrix of the centered frames
+ *  (size N_frame*N_frame): they are added by decreasing variance until the tolerance on the vertex error is reached. */
+vertex_animation_pca_report compress_vertex_animation(vertex_animation_cache const& cache,std::string const& filename,
+                                                      vertex_animation_pca_parameter const& parameter=vertex_animation_pca_parameter());
+
+/** A compressed vertex animation file mapped in memory (see vertex_animation_pca_header).
+ *  Same interface than vertex_animation_cache: the positions are reconstructed from the basis when they are requested. */
+class vertex_animation_pca
+{
+public:
+
+    vertex_animation_pca();
+    /** Map the given file (see open) */
+    explicit vertex_animation_pca(std::string const& filename);
+
+    /** Map a compressed file, throw an exception if it is not valid */
+    void open(std::string const& filename);
+
+    /** Number of frames */
+    int size() const;
+    /** Number of vertices per frame */
+    int size_vertex() const;
+    /** Number of components of the basis */
+    int size_component() const;
+    /** Duration of a frame (in seconds) */
+    float frame_duration() const;
+
+    /** The frame and the interpolation coefficient (in [0,1[) at a given time, the frames being played cyclically */
+    void frame_at_time(float time,int& frame,float& alpha) const;
+    /** Linear interpolation between a frame and the next one (the first one follows the last one).
+     *  The coefficients are interpolated, then a single frame is reconstructed.
+     * \param positions: 3*size_vertex() floats receiving the positions. */
+    void interpolate(int frame,float alpha,float* positions) const;
+    /** Reconstruct the positions given the coefficients of the components */
+    void reconstruct(float const* coefficients,float* positions) const;
+
+private:
+
+    /** Mapping of the file */
+    mapped_file file;
+    /** Header of the file */
+    vertex_animation_pca_header header_data;
+    /** Mean of the frames */
+    float const* mean;
+    /** Components, by blocks of 4 values */
+    float const* basis;
+    /** Coefficients of the frames */
+    float const* coefficients;
+};
+
+}
+
+#endif